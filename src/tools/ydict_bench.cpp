@@ -0,0 +1,725 @@
+/*
+ * ydict_bench - microbenchmarks for the ydict library
+ * ---------------------------------------------------
+ * Runs against synthetic definitions and a synthetic .idx/.dat generated
+ * in-process, so no dictionary files are needed. Single-threaded cases
+ * report ns/op plus heap allocations and allocated bytes per op (counted
+ * by the operator new below). The scaling.* cases query one shared
+ * Dictionary snapshot from 1..N threads and report throughput, speedup and
+ * efficiency.
+ *
+ * Usage:
+ *   ydict_bench [--filter <substring>] [--min-time-ms <ms>] [--json <file|->]
+ *
+ * --json writes every result as one JSON document (with "-": to stdout,
+ * and the human-readable table goes to stderr).
+ */
+
+#include "ydict/json.h"
+#include "ydict/ydict.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+ * Allocation counting: every operator new on a thread bumps that thread's
+ * counters (plain thread_locals, so counting costs next to nothing). The
+ * array forms forward here; over-aligned allocations are not counted.
+ */
+static thread_local std::uint64_t t_allocs = 0;
+static thread_local std::uint64_t t_alloc_bytes = 0;
+
+void* operator new(std::size_t n)
+{
+    ++t_allocs;
+    t_alloc_bytes += n;
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+// Results are folded into this so the optimizer cannot drop the work.
+volatile std::size_t g_sink = 0;
+
+struct BenchOptions
+{
+    std::string filter;
+    double min_time_ms = 300.0;
+    std::string json_path;      // empty: no JSON
+    std::FILE* out = stdout;    // human-readable table
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double mb_per_s = 0.0;          // input bytes processed per second
+    double allocs_per_op = -1.0;    // -1: not measured (multi-threaded cases)
+    double alloc_bytes_per_op = -1.0;
+    unsigned threads = 1;
+};
+
+static bool selected(const BenchOptions& opt, std::string_view name)
+{
+    return opt.filter.empty() || name.find(opt.filter) != std::string_view::npos;
+}
+
+// For setup that takes a moment: skip it when none of its cases would run.
+static bool any_selected(const BenchOptions& opt, std::initializer_list<std::string_view> names)
+{
+    return std::any_of(names.begin(), names.end(), [&](std::string_view n) { return selected(opt, n); });
+}
+
+template <class Fn>
+static bool run_bench(const BenchOptions& opt,
+                      std::vector<BenchResult>& results,
+                      const std::string& name,
+                      std::size_t bytesPerOp,
+                      Fn&& fn)
+{
+    if (!selected(opt, name))
+        return false;
+
+    using Clock = std::chrono::steady_clock;
+
+    fn(); // warm-up
+
+    std::uint64_t iters = 1;
+    double elapsedNs = 0.0;
+    std::uint64_t allocs = 0;
+    std::uint64_t allocBytes = 0;
+    for (;;) {
+        const std::uint64_t a0 = t_allocs;
+        const std::uint64_t b0 = t_alloc_bytes;
+        const auto t0 = Clock::now();
+        for (std::uint64_t i = 0; i < iters; ++i) {
+            fn();
+        }
+        elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        allocs = t_allocs - a0;
+        allocBytes = t_alloc_bytes - b0;
+        if (elapsedNs >= opt.min_time_ms * 1e6 || iters >= (1ull << 32))
+            break;
+        // Aim slightly past the target in one more round.
+        const double scale = elapsedNs > 0 ? (opt.min_time_ms * 1e6 * 1.2) / elapsedNs : 100.0;
+        iters = static_cast<std::uint64_t>(static_cast<double>(iters) * std::min(std::max(scale, 2.0), 100.0));
+    }
+
+    BenchResult r;
+    r.name = name;
+    r.iterations = iters;
+    r.ns_per_op = elapsedNs / static_cast<double>(iters);
+    r.mb_per_s = bytesPerOp ? (static_cast<double>(bytesPerOp) / r.ns_per_op) * 1e9 / (1024.0 * 1024.0) : 0.0;
+    r.allocs_per_op = static_cast<double>(allocs) / static_cast<double>(iters);
+    r.alloc_bytes_per_op = static_cast<double>(allocBytes) / static_cast<double>(iters);
+    results.push_back(r);
+
+    std::fprintf(opt.out, "%-40s %12.1f ns/op %10.1f MB/s %8.2f allocs/op %10.0f B/op %12llu iters\n",
+                 r.name.c_str(), r.ns_per_op, r.mb_per_s, r.allocs_per_op, r.alloc_bytes_per_op,
+                 static_cast<unsigned long long>(r.iterations));
+    std::fflush(opt.out);
+    return true;
+}
+
+/*
+ * Synthetic definition in the shape of ydpdict entries: headword + phonetics,
+ * POS headings (\cf2), translations, indented examples (\saN), hidden \qc
+ * blocks, CP1250 hex escapes.
+ */
+static std::string make_definition(std::mt19937& rng, int blocks, int sensesPerBlock)
+{
+    static const char* kWords[] = {
+        "take", "house", "get", "set", "run", "light", "over", "line", "make", "go",
+    };
+    static const char* kPos[] = { "vt", "vi", "n", "adj", "adv" };
+    std::uniform_int_distribution<int> pick(0, 9);
+
+    std::string s;
+    s += "{\\b ";
+    s += kWords[pick(rng)];
+    s += "} {\\f1 [\\'8e\\'8ab\\'8an\\'8ed\\'8an]}\\par\n";
+
+    for (int b = 0; b < blocks; ++b) {
+        s += "\\pard\\cf2 ";
+        s += kPos[b % 5];
+        s += "\\par\n";
+        for (int k = 0; k < sensesPerBlock; ++k) {
+            s += "\\pard\\cf1 {przyk\\'b3ad t\\'b3umaczenia ";
+            s += kWords[pick(rng)];
+            s += "}, {\\i o\\'9cwietlenie} ";
+            s += std::to_string(k + 1);
+            s += "\\par\n\\pard\\sa100 {\\cf0 To ";
+            s += kWords[pick(rng)];
+            s += " the house is an example sentence.} \\par\n";
+            if (k % 3 == 0)
+                s += "{\\qc hidden cross-reference\\par}\n";
+        }
+    }
+    return s;
+}
+
+static std::string render_streamed(std::string_view rtf, ydict::OutputFormat fmt, std::size_t block)
+{
+    std::string out;
+    ydict::RtfStreamRenderer renderer(fmt, [&](std::string_view chunk) { out.append(chunk); });
+    for (std::size_t i = 0; i < rtf.size(); i += block) {
+        if (!renderer.feed(rtf.substr(i, block)))
+            break;
+    }
+    renderer.finish();
+    return out;
+}
+
+struct Corpus
+{
+    std::string name;
+    std::string rtf;
+};
+
+static void bench_render(const BenchOptions& opt, std::vector<BenchResult>& results)
+{
+    std::mt19937 rng(42);
+    const std::vector<Corpus> corpora = {
+        {"small",  make_definition(rng, 1, 2)},
+        {"medium", make_definition(rng, 4, 8)},
+        {"large",  make_definition(rng, 40, 80)},
+    };
+
+    struct Policy
+    {
+        const char* name;
+        ydict::OutputFormat fmt;
+    };
+    static const Policy kPolicies[] = {
+        {"cli",   ydict::OutputFormat::Cli},
+        {"plain", ydict::OutputFormat::Plain},
+        {"ansi",  ydict::OutputFormat::Ansi},
+        {"html",  ydict::OutputFormat::Html},
+        {"json",  ydict::OutputFormat::Json},
+    };
+
+    for (const Corpus& c : corpora) {
+        const std::string_view rtf = c.rtf;
+        const std::string suffix = "/" + c.name;
+
+        // The public one-call API (document.h equivalent: render.direct.cli).
+        run_bench(opt, results, "render.renderRtfForCli" + suffix, rtf.size(), [&] {
+            g_sink = g_sink + ydict::renderRtfForCli(rtf).size();
+        });
+
+        run_bench(opt, results, "render.document+cli" + suffix, rtf.size(), [&] {
+            g_sink = g_sink + ydict::renderDocument(ydict::parseDocument(rtf), ydict::OutputFormat::Cli).size();
+        });
+
+        for (const Policy& p : kPolicies) {
+            run_bench(opt, results, std::string("render.direct.") + p.name + suffix, rtf.size(), [&] {
+                g_sink = g_sink + ydict::renderRtf(rtf, p.fmt).size();
+            });
+        }
+
+        for (const Policy& p : kPolicies) {
+            run_bench(opt, results, std::string("render.measure.") + p.name + suffix, rtf.size(), [&] {
+                g_sink = g_sink + ydict::measureRtf(rtf, p.fmt);
+            });
+        }
+
+        // Fed in 4 KiB blocks, as Dictionary::streamDefinition() reads the .dat.
+        run_bench(opt, results, "render.stream4k.cli" + suffix, rtf.size(), [&] {
+            g_sink = g_sink + render_streamed(rtf, ydict::OutputFormat::Cli, 4096).size();
+        });
+
+        // Measure once, allocate once, render into the exact-size buffer.
+        run_bench(opt, results, "render.measure+to.cli" + suffix, rtf.size(), [&] {
+            std::string out(ydict::measureRtf(rtf, ydict::OutputFormat::Cli), '\0');
+            g_sink = g_sink + ydict::renderRtfTo(rtf, ydict::OutputFormat::Cli, out.data(), out.size());
+        });
+    }
+}
+
+/*
+ * Stress inputs: pathological nesting (far past the renderer's group depth
+ * limit, balanced and unbalanced), a huge definition, and runs of control
+ * noise. Besides timing them, each one is checked to render identically via
+ * the Document path and when streamed in odd-sized blocks, and to keep the
+ * output size bounded by the input.
+ */
+static bool bench_render_stress(const BenchOptions& opt, std::vector<BenchResult>& results)
+{
+    std::mt19937 rng(7);
+    std::vector<Corpus> corpora;
+
+    {
+        std::string s;
+        for (int i = 0; i < 100000; ++i)
+            s += "{\\cf1 a";
+        s += "\\par deep\\par\n";
+        corpora.push_back({"deep-unbalanced", std::move(s)});
+    }
+    {
+        std::string s = "head\\par\n";
+        for (int k = 0; k < 50; ++k) {
+            for (int i = 0; i < 2000; ++i)
+                s += (i % 7 == 0) ? "{\\qc " : "{\\sa100\\f1 \\'8a";
+            s += "x\\par\n";
+            s.append(2000, '}');
+            s += "back at top\\par\n";
+        }
+        corpora.push_back({"deep-balanced", std::move(s)});
+    }
+    {
+        std::string s;
+        while (s.size() < (8u << 20))
+            s += make_definition(rng, 40, 80);
+        corpora.push_back({"huge-8MiB", std::move(s)});
+    }
+    {
+        std::string s;
+        for (int i = 0; i < 50000; ++i) {
+            s += "\\cf99999999999999\\u-99999999999 \\unknownword\\'zz}}\\";
+            s += (i % 2) ? "\n" : "\\line";
+        }
+        corpora.push_back({"control-noise", std::move(s)});
+    }
+
+    bool ok = true;
+    for (const Corpus& c : corpora) {
+        const std::string_view rtf = c.rtf;
+
+        const std::string direct = ydict::renderRtf(rtf, ydict::OutputFormat::Cli);
+        const std::string viaDoc = ydict::renderDocument(ydict::parseDocument(rtf), ydict::OutputFormat::Cli);
+        const std::string streamed = render_streamed(rtf, ydict::OutputFormat::Cli, 1000);
+        if (direct != viaDoc || direct != streamed || direct.size() > rtf.size() * 4 + 64) {
+            std::cerr << "stress/" << c.name << ": output mismatch or unbounded output ("
+                      << direct.size() << " bytes from " << rtf.size() << ")\n";
+            ok = false;
+        }
+
+        run_bench(opt, results, "stress.direct.cli/" + c.name, rtf.size(), [&] {
+            g_sink = g_sink + ydict::renderRtf(rtf, ydict::OutputFormat::Cli).size();
+        });
+        run_bench(opt, results, "stress.measure.html/" + c.name, rtf.size(), [&] {
+            g_sink = g_sink + ydict::measureRtf(rtf, ydict::OutputFormat::Html);
+        });
+        run_bench(opt, results, "stress.stream64k.cli/" + c.name, rtf.size(), [&] {
+            g_sink = g_sink + render_streamed(rtf, ydict::OutputFormat::Cli, 64 * 1024).size();
+        });
+        run_bench(opt, results, "stress.document/" + c.name, rtf.size(), [&] {
+            g_sink = g_sink + ydict::parseDocument(rtf).lines.size();
+        });
+    }
+    return ok;
+}
+
+/*
+ * Synthetic .idx/.dat pair: `count` sorted unique words, each with a small
+ * generated definition. Same layout as the ydpdict files (see
+ * buildIndexImage). With `sorted` false the table is in reverse order, so
+ * findWord() has to take its linear fallback.
+ */
+struct SyntheticDict
+{
+    std::vector<std::byte> idx;
+    std::vector<std::byte> dat;
+    std::vector<std::string> words;
+};
+
+static void put_u32(std::vector<std::byte>& out, std::size_t at, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        out[at + i] = static_cast<std::byte>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+static SyntheticDict make_dictionary(std::mt19937& rng, std::size_t count, bool sorted = true)
+{
+    SyntheticDict d;
+    std::uniform_int_distribution<int> len(3, 10);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::set<std::string> unique;
+    while (unique.size() < count) {
+        std::string w(static_cast<std::size_t>(len(rng)), ' ');
+        for (char& c : w) {
+            c = static_cast<char>(letter(rng));
+        }
+        unique.insert(std::move(w));
+    }
+    d.words.assign(unique.begin(), unique.end());
+    if (!sorted)
+        std::reverse(d.words.begin(), d.words.end());
+
+    d.idx.resize(20);
+    put_u32(d.idx, 0, 0x8d4e11d5);
+    d.idx[8] = static_cast<std::byte>(count & 0xFF);
+    d.idx[9] = static_cast<std::byte>((count >> 8) & 0xFF);
+    put_u32(d.idx, 16, 20);
+
+    for (const std::string& w : d.words) {
+        const std::string rtf = make_definition(rng, 2, 2);
+        const std::size_t datAt = d.dat.size();
+        d.dat.resize(datAt + 4 + rtf.size());
+        put_u32(d.dat, datAt, static_cast<std::uint32_t>(rtf.size()));
+        std::memcpy(d.dat.data() + datAt + 4, rtf.data(), rtf.size());
+
+        const std::size_t idxAt = d.idx.size();
+        d.idx.resize(idxAt + 8 + w.size() + 1);
+        put_u32(d.idx, idxAt + 4, static_cast<std::uint32_t>(datAt));
+        std::memcpy(d.idx.data() + idxAt + 8, w.data(), w.size() + 1);
+    }
+    return d;
+}
+
+static bool write_file(const std::filesystem::path& path, const std::vector<std::byte>& bytes)
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+// Writes `synth` to the temp directory and points `cfg` at it.
+static bool write_temp_dictionary(const SyntheticDict& synth, std::mt19937& rng, ydict::Config& cfg)
+{
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::string stem = "ydict_bench_" + std::to_string(rng());
+    cfg.idx_path = (dir / (stem + ".idx")).string();
+    cfg.dat_path = (dir / (stem + ".dat")).string();
+    return write_file(cfg.idx_path, synth.idx) && write_file(cfg.dat_path, synth.dat);
+}
+
+static void remove_temp_dictionary(const ydict::Config& cfg)
+{
+    std::error_code ec;
+    std::filesystem::remove(cfg.idx_path, ec);
+    std::filesystem::remove(cfg.dat_path, ec);
+}
+
+/*
+ * Dictionary operations on a 50k-word synthetic dictionary. Keys are
+ * spread over the table with a multiplicative hash of the op counter, so
+ * consecutive ops touch unrelated entries.
+ */
+static void bench_dictionary(const BenchOptions& opt, std::vector<BenchResult>& results)
+{
+    if (!any_selected(opt, {"dict.init.file", "dict.initFromMemory", "dict.findWord.hit", "dict.findWord.miss",
+                             "dict.findWord.fallback-hit", "dict.lowerBound", "dict.suggest/p1", "dict.suggest/p2",
+                             "dict.suggest/p3", "dict.suggest/p5", "dict.readRtf.memory", "dict.readRtf.file"}))
+        return;
+
+    std::mt19937 rng(1234);
+    const SyntheticDict synth = make_dictionary(rng, 50000);
+    const std::vector<std::string>& words = synth.words;
+    const std::size_t n = words.size();
+    auto pick = [n](std::size_t i) { return (i * 2654435761u) % n; };
+
+    ydict::Config cfg;
+    if (!write_temp_dictionary(synth, rng, cfg)) {
+        std::cerr << "dict: cannot write the synthetic dictionary\n";
+        return;
+    }
+
+    run_bench(opt, results, "dict.init.file", synth.idx.size(), [&] {
+        ydict::Dictionary d;
+        g_sink = g_sink + static_cast<std::size_t>(d.init(cfg));
+    });
+    run_bench(opt, results, "dict.initFromMemory", synth.idx.size(), [&] {
+        ydict::Dictionary d;
+        g_sink = g_sink + static_cast<std::size_t>(d.initFromMemory(synth.idx, synth.dat));
+    });
+
+    ydict::Dictionary mem;
+    ydict::Dictionary file;
+    if (!mem.initFromMemory(synth.idx, synth.dat) || !file.init(cfg)) {
+        std::cerr << "dict: cannot load the synthetic dictionary\n";
+        remove_temp_dictionary(cfg);
+        return;
+    }
+
+    std::size_t i = 0;
+    run_bench(opt, results, "dict.findWord.hit", 0, [&] {
+        g_sink = g_sink + static_cast<std::size_t>(mem.findWord(words[pick(i++)]));
+    });
+
+    // Synthetic words are lowercase letters only: a trailing digit never matches,
+    // and every miss ends in the linear fallback scan over the whole table.
+    std::vector<std::string> misses;
+    for (std::size_t k = 0; k < 256; ++k) {
+        misses.push_back(words[pick(k)] + "0");
+    }
+    run_bench(opt, results, "dict.findWord.miss", 0, [&] {
+        g_sink = g_sink + static_cast<std::size_t>(mem.findWord(misses[i++ % misses.size()]));
+    });
+
+    {
+        std::mt19937 rng2(1234);
+        const SyntheticDict reversed = make_dictionary(rng2, 50000, /*sorted=*/false);
+        ydict::Dictionary unsorted;
+        if (unsorted.initFromMemory(reversed.idx, reversed.dat)) {
+            run_bench(opt, results, "dict.findWord.fallback-hit", 0, [&] {
+                g_sink = g_sink + static_cast<std::size_t>(unsorted.findWord(words[pick(i++)]));
+            });
+        }
+    }
+
+    run_bench(opt, results, "dict.lowerBound", 0, [&] {
+        const std::string& w = words[pick(i++)];
+        g_sink = g_sink + static_cast<std::size_t>(mem.lowerBound(std::string_view(w).substr(0, 2)));
+    });
+
+    // suggest() scans in table order until it has 15 hits: short prefixes fill up fast.
+    for (const std::size_t len : {1u, 2u, 3u, 5u}) {
+        std::vector<std::string> prefixes;
+        for (std::size_t k = 0; prefixes.size() < 256; ++k) {
+            const std::string& w = words[pick(k)];
+            if (w.size() >= len)
+                prefixes.push_back(w.substr(0, len));
+        }
+        run_bench(opt, results, "dict.suggest/p" + std::to_string(len), 0, [&] {
+            g_sink = g_sink + mem.suggest(prefixes[i++ % prefixes.size()]).size();
+        });
+    }
+
+    const std::size_t avgDef = synth.dat.size() / n;
+    run_bench(opt, results, "dict.readRtf.memory", avgDef, [&] {
+        g_sink = g_sink + mem.readRtf(static_cast<int>(pick(i++))).size();
+    });
+    run_bench(opt, results, "dict.readRtf.file", avgDef, [&] {
+        g_sink = g_sink + file.readRtf(static_cast<int>(pick(i++))).size();
+    });
+
+    file = ydict::Dictionary();
+    remove_temp_dictionary(cfg);
+}
+
+/*
+ * Throughput of `op` on 1, 2, 4, ... threads (up to the hardware threads),
+ * all querying one shared snapshot for --min-time-ms each. Linear scaling
+ * means ops/s grows with the thread count and efficiency stays near 100%.
+ */
+template <class Op>
+static void run_scaling(const BenchOptions& opt, std::vector<BenchResult>& results, const std::string& name, Op&& op)
+{
+    if (!selected(opt, name))
+        return;
+
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < hw; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(hw);
+
+    double base = 0.0;
+    for (const unsigned threads : counts) {
+        std::atomic<bool> stop{false};
+        std::vector<std::uint64_t> done(threads * 8, 0); // 64-byte stride: no false sharing
+        std::vector<std::thread> pool;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (unsigned t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                std::uint64_t n = 0;
+                std::size_t acc = 0;
+                std::size_t i = t * 7919u;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    for (int k = 0; k < 64; ++k) {
+                        acc += op(i++);
+                    }
+                    n += 64;
+                }
+                done[t * 8] = n;
+                g_sink = g_sink + acc;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(opt.min_time_ms));
+        stop = true;
+        for (std::thread& th : pool) {
+            th.join();
+        }
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::uint64_t total = 0;
+        for (unsigned t = 0; t < threads; ++t) {
+            total += done[t * 8];
+        }
+        const double opsPerSec = static_cast<double>(total) / secs;
+        if (threads == 1)
+            base = opsPerSec;
+
+        BenchResult r;
+        r.name = name + "/t" + std::to_string(threads);
+        r.iterations = total;
+        r.ns_per_op = 1e9 * threads / opsPerSec; // per-thread latency
+        r.threads = threads;
+        results.push_back(r);
+
+        const double speedup = base > 0 ? opsPerSec / base : 0.0;
+        std::fprintf(opt.out, "%-40s %12.0f ops/s %7.2fx %6.0f%% eff %9.1f ns/op/thread\n",
+                     r.name.c_str(), opsPerSec, speedup, 100.0 * speedup / threads, r.ns_per_op);
+        std::fflush(opt.out);
+    }
+}
+
+static void bench_scaling(const BenchOptions& opt, std::vector<BenchResult>& results)
+{
+    if (!any_selected(opt, {"scaling.findWord", "scaling.readRtf.pread", "scaling.document.cached"}))
+        return;
+
+    std::mt19937 rng(4242);
+    SyntheticDict synth = make_dictionary(rng, 50000);
+    const std::vector<std::string> words = synth.words;
+
+    // File-backed snapshot: definitions come through pread on one shared descriptor.
+    ydict::Config cfg;
+    std::shared_ptr<const ydict::Dictionary> fileDict;
+    if (write_temp_dictionary(synth, rng, cfg))
+        fileDict = ydict::Dictionary::open(cfg);
+
+    const auto memDict = ydict::Dictionary::openFromMemory(std::move(synth.idx), std::move(synth.dat));
+    if (!memDict || !fileDict) {
+        std::cerr << "scaling: cannot build the synthetic dictionary\n";
+    } else {
+        const std::size_t n = words.size();
+        run_scaling(opt, results, "scaling.findWord", [&](std::size_t i) {
+            return static_cast<std::size_t>(memDict->findWord(words[(i * 2654435761u) % n]));
+        });
+        run_scaling(opt, results, "scaling.readRtf.pread", [&](std::size_t i) {
+            return fileDict->readRtf(static_cast<int>((i * 2654435761u) % n)).size();
+        });
+        run_scaling(opt, results, "scaling.document.cached", [&](std::size_t i) {
+            // 64 hot entries: exercises the sharded parse cache.
+            const auto doc = memDict->document(static_cast<int>(i % 64));
+            return doc ? doc->lines.size() : 0;
+        });
+    }
+
+    fileDict.reset();
+    remove_temp_dictionary(cfg);
+}
+
+static bool write_json(const BenchOptions& opt, const std::vector<BenchResult>& results)
+{
+    std::string j;
+    j += "{\"tool\":\"ydict_bench\",\"build\":";
+#ifdef NDEBUG
+    j += "\"release\"";
+#else
+    j += "\"debug\"";
+#endif
+    j += ",\"min_time_ms\":" + std::to_string(opt.min_time_ms);
+    j += ",\"results\":[";
+
+    char num[64];
+    auto field = [&](const char* key, double v) {
+        std::snprintf(num, sizeof(num), ",\"%s\":%.3f", key, v);
+        j += num;
+    };
+    for (std::size_t k = 0; k < results.size(); ++k) {
+        const BenchResult& r = results[k];
+        j += k ? ",\n{" : "\n{";
+        j += "\"name\":";
+        ydict::appendJsonString(j, r.name);
+        j += ",\"threads\":" + std::to_string(r.threads);
+        j += ",\"iterations\":" + std::to_string(r.iterations);
+        field("ns_per_op", r.ns_per_op);
+        if (r.mb_per_s > 0)
+            field("mb_per_s", r.mb_per_s);
+        if (r.allocs_per_op >= 0) {
+            field("allocs_per_op", r.allocs_per_op);
+            field("bytes_per_op", r.alloc_bytes_per_op);
+        }
+        j += "}";
+    }
+    j += "\n]}\n";
+
+    if (opt.json_path == "-") {
+        std::fwrite(j.data(), 1, j.size(), stdout);
+        return std::fflush(stdout) == 0;
+    }
+    std::ofstream out(opt.json_path, std::ios::binary);
+    out << j;
+    return static_cast<bool>(out);
+}
+
+static void printUsage(const char* exe)
+{
+    std::cout
+        << "Usage:\n"
+        << "  " << exe << " [--filter <substring>] [--min-time-ms <ms>] [--json <file|->]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view a = argv[i];
+        if (a == "--filter" && i + 1 < argc) {
+            opt.filter = argv[++i];
+            continue;
+        }
+        if (a == "--min-time-ms" && i + 1 < argc) {
+            opt.min_time_ms = std::atof(argv[++i]);
+            continue;
+        }
+        if (a == "--json" && i + 1 < argc) {
+            opt.json_path = argv[++i];
+            if (opt.json_path == "-")
+                opt.out = stderr; // stdout carries the JSON only
+            continue;
+        }
+        printUsage(argv[0]);
+        return a == "--help" || a == "-h" ? 0 : 2;
+    }
+
+#ifndef NDEBUG
+    std::fprintf(opt.out, "(note: ydict_bench built without NDEBUG; numbers are not representative)\n");
+#endif
+
+    std::vector<BenchResult> results;
+    bench_render(opt, results);
+    const bool stressOk = bench_render_stress(opt, results);
+    bench_dictionary(opt, results);
+    bench_scaling(opt, results);
+
+    if (results.empty()) {
+        std::cerr << "No benchmark matched filter \"" << opt.filter << "\"\n";
+        return 1;
+    }
+    if (!opt.json_path.empty() && !write_json(opt, results)) {
+        std::cerr << "Cannot write " << opt.json_path << "\n";
+        return 1;
+    }
+    return stressOk ? 0 : 1;
+}
@@ -0,0 +1,469 @@
+/*
+ * ydict_gen - synthetic .idx/.dat dictionary generator
+ * ----------------------------------------------------
+ * Writes a format-valid dictionary pair for tests, benchmarks and load tests
+ * on machines without the ydpdict data:
+ *
+ *   .idx  u32 magic 0x8d4e11d5 @0, u16 word count @8, u32 table offset @16;
+ *         per entry 4 unused bytes, u32 .dat offset, NUL-terminated word,
+ *         sorted in byte order (what Dictionary::findWord() expects)
+ *   .dat  per entry u32 length + RTF-like definition
+ *
+ * Definitions use the control words the renderers handle: \par \pard \line
+ * \tab \cfN \saN \qc (hidden), \f1 phonetics with \'XX glyph slots, \uN?
+ * and CP1250 \'XX escapes, in groups nested up to --nesting deep, so
+ * --validate reports no unknown control words on generated data.
+ *
+ * The u16 count caps one .idx at 65535 words. Larger --words are split into
+ * <out>.1.idx/.dat, <out>.2.idx/.dat, ... (consecutive ranges of the sorted
+ * word list); --cfg writes a ydict.cfg that loads all parts together.
+ *
+ * Usage:
+ *   ydict_gen --out <prefix> [--words <n>] [--seed <n>]
+ *             [--size-dist fixed|uniform|lognormal] [--mean-bytes <n>] [--max-bytes <n>]
+ *             [--nesting <depth>] [--phonetic <0..1>] [--cfg <path>]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::uint32_t kIdxMagic = 0x8d4e11d5;
+constexpr std::size_t kMaxWordsPerFile = 0xFFFF;        // u16 count
+constexpr std::size_t kMaxDefinition = 4u * 1024 * 1024; // Dictionary rejects larger entries
+
+enum class SizeDist { Fixed, Uniform, LogNormal };
+
+struct GenOptions
+{
+    std::string out;                // output prefix
+    std::size_t words = 20000;
+    std::uint32_t seed = 1;
+    SizeDist size_dist = SizeDist::LogNormal;
+    std::size_t mean_bytes = 600;   // target definition size
+    std::size_t max_bytes = 64 * 1024;
+    int nesting = 3;                // max group depth inside a sense
+    double phonetic = 0.8;          // share of entries with a transcription
+    std::string cfg_path;           // empty: no ydict.cfg
+};
+
+/* --- headwords --- */
+
+static const char* kOnsets[] = {
+    "b", "br", "c", "ch", "d", "dr", "f", "fl", "g", "gr", "h", "j", "k", "l", "m",
+    "n", "p", "pl", "qu", "r", "s", "sh", "st", "t", "th", "tr", "v", "w", "y", "z",
+};
+static const char* kVowels[] = { "a", "e", "i", "o", "u", "ea", "oo", "ai" };
+static const char* kCodas[] = { "", "", "", "n", "r", "s", "t", "ck", "ng", "ll" };
+
+template <class T, std::size_t N>
+static const T& pick(std::mt19937& rng, const T (&items)[N])
+{
+    return items[std::uniform_int_distribution<std::size_t>(0, N - 1)(rng)];
+}
+
+static std::string make_word(std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> syllables(1, 4);
+    std::string w;
+    const int n = syllables(rng);
+    for (int k = 0; k < n; ++k) {
+        w += pick(rng, kOnsets);
+        w += pick(rng, kVowels);
+        w += pick(rng, kCodas);
+    }
+    return w;
+}
+
+// `count` unique headwords in byte order; a few phrases and hyphenated forms like real entries.
+static std::vector<std::string> make_headwords(std::mt19937& rng, std::size_t count)
+{
+    std::uniform_int_distribution<int> shape(0, 99);
+    std::set<std::string> unique;
+    while (unique.size() < count) {
+        std::string w = make_word(rng);
+        const int s = shape(rng);
+        if (s < 5)
+            w += " " + make_word(rng);
+        else if (s < 8)
+            w += "-" + make_word(rng);
+        else if (s < 10)
+            w[0] = static_cast<char>(w[0] - 'a' + 'A');
+        unique.insert(std::move(w));
+    }
+    return std::vector<std::string>(unique.begin(), unique.end());
+}
+
+/* --- definitions --- */
+
+static const char* kPos[] = { "n", "vt", "vi", "adj", "adv", "prep", "pron", "conj" };
+static const char* kPolish[] = {
+    "przyk\\'b3ad", "t\\'b3umaczenie", "o\\'9cwietlenie", "\\'bfo\\'b3\\'b9d\\'9f", "m\\'easki",
+    "s\\'b3owo", "zdanie", "dom", "\\'9cwiat\\'b3o", "droga", "czas", "r\\'eaka", "g\\'b3owa",
+};
+static const char* kEnglish[] = {
+    "the", "house", "is", "on", "a", "hill", "we", "take", "it", "over", "there", "light", "run",
+};
+static const char* kLetters[] = { "b", "d", "f", "k", "l", "m", "n", "p", "r", "s", "t", "v", "w", "z" };
+
+// Glyph slots the phonetic table maps (see kPhoneticToUtf8 in rtf_render.cpp).
+static const char* kPhoneticSlots[] = {
+    "\\'82", "\\'83", "\\'85", "\\'86", "\\'87", "\\'88", "\\'89",
+    "\\'8a", "\\'8b", "\\'8d", "\\'8e", "\\'90", "\\'97", "\\'98",
+};
+
+static void append_phonetic(std::string& s, std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> len(3, 10);
+    std::bernoulli_distribution slot(0.4);
+    s += "{\\f1 [";
+    const int n = len(rng);
+    for (int k = 0; k < n; ++k) {
+        s += slot(rng) ? pick(rng, kPhoneticSlots) : pick(rng, kLetters);
+    }
+    s += "]}";
+}
+
+static void append_words(std::string& s, std::mt19937& rng, const char* const* words, std::size_t n, int count)
+{
+    std::uniform_int_distribution<std::size_t> which(0, n - 1);
+    for (int k = 0; k < count; ++k) {
+        if (k)
+            s += ' ';
+        s += words[which(rng)];
+    }
+}
+
+// A run of styled groups, each possibly holding another one, `depth` levels at most.
+static void append_nested(std::string& s, std::mt19937& rng, int depth)
+{
+    static const char* kOpen[] = { "{\\cf0 ", "{\\cf4 ", "{\\cf1 ", "{\\cf5 ", "{\\sa100 " };
+    std::bernoulli_distribution deeper(0.6);
+    s += pick(rng, kOpen);
+    append_words(s, rng, kPolish, std::size(kPolish), 2);
+    if (depth > 1 && deeper(rng)) {
+        s += ' ';
+        append_nested(s, rng, depth - 1);
+    }
+    s += '}';
+}
+
+// A plain paragraph of English words at most `room` bytes long (nothing if too little room).
+static void append_padding(std::string& s, std::mt19937& rng, std::size_t room)
+{
+    static constexpr std::string_view kOpen = "\\pard ";
+    static constexpr std::string_view kClose = "\\par\n";
+    if (room < kOpen.size() + kClose.size() + 1)
+        return;
+    std::string text;
+    for (;;) {
+        const std::string_view w = pick(rng, kEnglish);
+        if (kOpen.size() + text.size() + 1 + w.size() + kClose.size() > room)
+            break;
+        if (!text.empty())
+            text += ' ';
+        text += w;
+    }
+    if (text.empty())
+        text = "a";
+    s += kOpen;
+    s += text;
+    s += kClose;
+}
+
+/*
+ * Definition of about `target` bytes: a headword line, then sense blocks
+ * while the next one still fits, then a plain padding paragraph. Never
+ * longer than `target` (itself at most --max-bytes), so generated entries
+ * stay under the reader's size limit.
+ */
+static std::string make_definition(std::mt19937& rng, const GenOptions& opt, std::string_view headword,
+                                   std::size_t target)
+{
+    std::bernoulli_distribution hasPhonetic(opt.phonetic);
+    std::bernoulli_distribution inlinePhonetic(opt.phonetic / 4);
+    std::uniform_int_distribution<int> roll(0, 99);
+    std::uniform_int_distribution<int> depth(1, std::max(opt.nesting, 1));
+
+    std::string s;
+    s.reserve(target + 256);
+    s += "{\\cf1 ";
+    s += headword;
+    s += '}';
+    if (hasPhonetic(rng)) {
+        std::string phonetic = " ";
+        append_phonetic(phonetic, rng);
+        if (s.size() + phonetic.size() + 5 <= target)
+            s += phonetic;
+    }
+    s += "\\par\n";
+
+    int sense = 0;
+    std::string block;
+    while (s.size() < target) {
+        block.clear();
+        if (sense % 4 == 0) {
+            block += "\\pard\\cf2 ";
+            block += pick(rng, kPos);
+            block += "\\par\n";
+        }
+        ++sense;
+
+        block += "\\pard\\cf1 " + std::to_string(sense) + ". ";
+        append_words(block, rng, kPolish, std::size(kPolish), 3);
+        if (opt.nesting > 0) {
+            block += ", ";
+            append_nested(block, rng, depth(rng));
+        }
+        if (inlinePhonetic(rng)) {
+            block += ' ';
+            append_phonetic(block, rng);
+        }
+        block += "\\par\n";
+
+        const int r = roll(rng);
+        if (r < 50) {
+            block += "\\pard\\sa100 {\\cf0 ";
+            append_words(block, rng, kEnglish, std::size(kEnglish), 6);
+            block += ".}\\line {\\cf5 ";
+            append_words(block, rng, kPolish, std::size(kPolish), 4);
+            block += "}\\par\n";
+        } else if (r < 65) {
+            block += "{\\qc ";
+            append_words(block, rng, kEnglish, std::size(kEnglish), 3);
+            block += "\\par}\n";
+        } else if (r < 75) {
+            block += "\\pard\\tab \\u8211? ";
+            append_words(block, rng, kPolish, std::size(kPolish), 2);
+            block += "\\par\n";
+        }
+
+        // Built on the side: a sense that would overshoot is replaced by padding.
+        if (s.size() + block.size() > target) {
+            append_padding(s, rng, target - s.size());
+            break;
+        }
+        s += block;
+    }
+    return s;
+}
+
+static std::size_t sample_size(std::mt19937& rng, const GenOptions& opt)
+{
+    double v = static_cast<double>(opt.mean_bytes);
+    if (opt.size_dist == SizeDist::Uniform) {
+        v = std::uniform_real_distribution<double>(0.0, 2.0 * v)(rng);
+    } else if (opt.size_dist == SizeDist::LogNormal) {
+        // Long tail like real entries ("get", "take" run to tens of KiB); sigma 1, same mean.
+        constexpr double kSigma = 1.0;
+        v = std::lognormal_distribution<double>(std::log(v) - kSigma * kSigma / 2, kSigma)(rng);
+    }
+    return std::clamp<std::size_t>(static_cast<std::size_t>(v), 64, opt.max_bytes);
+}
+
+/* --- files --- */
+
+static void put_u32(std::string& out, std::size_t at, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        out[at + i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+struct PartStats
+{
+    std::size_t words = 0;
+    std::uint64_t idx_bytes = 0;
+    std::uint64_t dat_bytes = 0;
+};
+
+/*
+ * One .idx/.dat pair for words[begin, end). Definitions are streamed to the
+ * .dat as they are generated; only the (small) .idx is assembled in memory.
+ */
+static bool write_part(std::mt19937& rng, const GenOptions& opt, const std::vector<std::string>& words,
+                       std::size_t begin, std::size_t end, const std::string& stem,
+                       std::vector<std::size_t>& sizes, PartStats& stats)
+{
+    std::ofstream dat(stem + ".dat", std::ios::binary);
+    if (!dat) {
+        std::cerr << "Cannot create " << stem << ".dat\n";
+        return false;
+    }
+
+    const std::size_t count = end - begin;
+    std::string idx(20, '\0');
+    put_u32(idx, 0, kIdxMagic);
+    idx[8] = static_cast<char>(count & 0xFF);
+    idx[9] = static_cast<char>((count >> 8) & 0xFF);
+    put_u32(idx, 16, 20);
+
+    std::uint64_t datSize = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        const std::string rtf = make_definition(rng, opt, words[i], sample_size(rng, opt));
+        if (datSize + 4 + rtf.size() > 0xFFFFFFFFu) {
+            std::cerr << stem << ".dat would pass 4 GiB (u32 offsets); lower --mean-bytes\n";
+            return false;
+        }
+        sizes.push_back(rtf.size());
+
+        const std::size_t at = idx.size();
+        idx.resize(at + 8);
+        put_u32(idx, at + 4, static_cast<std::uint32_t>(datSize));
+        idx += words[i];
+        idx.push_back('\0');
+
+        std::string len(4, '\0');
+        put_u32(len, 0, static_cast<std::uint32_t>(rtf.size()));
+        dat.write(len.data(), 4);
+        dat.write(rtf.data(), static_cast<std::streamsize>(rtf.size()));
+        datSize += 4 + rtf.size();
+    }
+    dat.close();
+
+    std::ofstream idxOut(stem + ".idx", std::ios::binary);
+    idxOut.write(idx.data(), static_cast<std::streamsize>(idx.size()));
+    idxOut.close();
+    if (!dat || !idxOut) {
+        std::cerr << "Write failed for " << stem << ".idx/.dat\n";
+        return false;
+    }
+
+    stats.words = count;
+    stats.idx_bytes = idx.size();
+    stats.dat_bytes = datSize;
+    return true;
+}
+
+static bool write_cfg(const std::string& path, const std::vector<std::string>& stems)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << "# generated by ydict_gen\n";
+    for (std::size_t k = 0; k < stems.size(); ++k) {
+        const std::string abs = std::filesystem::absolute(stems[k]).string();
+        if (k > 0)
+            out << "\n[part" << (k + 1) << "]\n";
+        out << "idx_path = " << abs << ".idx\n"
+            << "dat_path = " << abs << ".dat\n";
+    }
+    return static_cast<bool>(out);
+}
+
+static bool parse_size_dist(std::string_view name, SizeDist& d)
+{
+    if (name == "fixed")     { d = SizeDist::Fixed;     return true; }
+    if (name == "uniform")   { d = SizeDist::Uniform;   return true; }
+    if (name == "lognormal") { d = SizeDist::LogNormal; return true; }
+    return false;
+}
+
+static void printUsage(const char* exe)
+{
+    std::cout
+        << "Usage:\n"
+        << "  " << exe << " --out <prefix> [options]\n"
+        << "\n"
+        << "Options:\n"
+        << "  --words <n>                       Headwords (default 20000; over 65535 splits into parts)\n"
+        << "  --seed <n>                        Random seed (default 1; same seed, same files)\n"
+        << "  --size-dist <fixed|uniform|lognormal>  Definition size distribution (default lognormal)\n"
+        << "  --mean-bytes <n>                  Mean definition size (default 600)\n"
+        << "  --max-bytes <n>                   Largest definition (default 65536, at most 4 MiB)\n"
+        << "  --nesting <depth>                 Max nested groups per sense (default 3; 0 = none)\n"
+        << "  --phonetic <0..1>                 Share of entries with a \\f1 transcription (default 0.8)\n"
+        << "  --cfg <path>                      Also write a ydict.cfg for the generated files\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    GenOptions opt;
+    bool bad = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (a == "--out" && hasValue) {
+            opt.out = argv[++i];
+        } else if (a == "--words" && hasValue) {
+            opt.words = std::strtoull(argv[++i], nullptr, 10);
+        } else if (a == "--seed" && hasValue) {
+            opt.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "--size-dist" && hasValue) {
+            bad |= !parse_size_dist(argv[++i], opt.size_dist);
+        } else if (a == "--mean-bytes" && hasValue) {
+            opt.mean_bytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (a == "--max-bytes" && hasValue) {
+            opt.max_bytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (a == "--nesting" && hasValue) {
+            opt.nesting = std::atoi(argv[++i]);
+        } else if (a == "--phonetic" && hasValue) {
+            opt.phonetic = std::atof(argv[++i]);
+        } else if (a == "--cfg" && hasValue) {
+            opt.cfg_path = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return a == "--help" || a == "-h" ? 0 : 2;
+        }
+    }
+    if (bad || opt.out.empty() || opt.words == 0 || opt.mean_bytes == 0 || opt.max_bytes < 64 ||
+        opt.max_bytes > kMaxDefinition || opt.nesting < 0 || opt.phonetic < 0.0 || opt.phonetic > 1.0) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(opt.seed);
+    const std::vector<std::string> words = make_headwords(rng, opt.words);
+
+    const std::size_t parts = (words.size() + kMaxWordsPerFile - 1) / kMaxWordsPerFile;
+    std::vector<std::string> stems;
+    std::vector<std::size_t> sizes;
+    sizes.reserve(words.size());
+    PartStats total;
+
+    for (std::size_t p = 0; p < parts; ++p) {
+        // Even split, so no part ends up with a handful of words.
+        const std::size_t begin = words.size() * p / parts;
+        const std::size_t end = words.size() * (p + 1) / parts;
+        const std::string stem = parts == 1 ? opt.out : opt.out + "." + std::to_string(p + 1);
+
+        PartStats st;
+        if (!write_part(rng, opt, words, begin, end, stem, sizes, st))
+            return 1;
+        stems.push_back(stem);
+        total.words += st.words;
+        total.idx_bytes += st.idx_bytes;
+        total.dat_bytes += st.dat_bytes;
+        std::printf("%s.idx/.dat: %zu words, %llu + %llu bytes\n", stem.c_str(), st.words,
+                    static_cast<unsigned long long>(st.idx_bytes), static_cast<unsigned long long>(st.dat_bytes));
+    }
+
+    std::sort(sizes.begin(), sizes.end());
+    auto pct = [&](double q) { return sizes[std::min(sizes.size() - 1, static_cast<std::size_t>(q * sizes.size()))]; };
+    std::printf("total: %zu words in %zu part(s), %llu .dat bytes; definition bytes p50 %zu, p99 %zu, max %zu\n",
+                total.words, parts, static_cast<unsigned long long>(total.dat_bytes), pct(0.50), pct(0.99),
+                sizes.back());
+
+    if (!opt.cfg_path.empty()) {
+        if (!write_cfg(opt.cfg_path, stems)) {
+            std::cerr << "Cannot write " << opt.cfg_path << "\n";
+            return 1;
+        }
+        std::printf("config: %s\n", opt.cfg_path.c_str());
+    }
+    return 0;
+}
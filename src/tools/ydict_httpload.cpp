@@ -0,0 +1,284 @@
+/*
+ * ydict_httpload - load generator for ydict_app --http
+ * ----------------------------------------------------
+ * Opens N keep-alive connections to 127.0.0.1:<port>; each runs on its own
+ * thread and sends requests back to back (closed loop) for the given time.
+ * Prints throughput and latency percentiles over all requests.
+ *
+ * Usage:
+ *   ydict_httpload --port <p> [--connections <n>] [--seconds <s>]
+ *                  [--path <target>] [--words <file>] [--format <f>]
+ *
+ * With --words, targets cycle through /render?word=<w>&format=<f> for the
+ * words in the file (one per line); otherwise every request uses --path
+ * (default /lookup?word=get).
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct LoadOptions
+{
+    std::uint16_t port = 0;
+    int connections = 8;
+    double seconds = 5.0;
+    std::string path = "/lookup?word=get";
+    std::string words_file;
+    std::string format = "cli";
+};
+
+struct WorkerResult
+{
+    std::vector<std::uint32_t> latency_ns; // per request, capped at ~4 s
+    std::uint64_t bytes = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t non_200 = 0;
+};
+
+static std::string url_encode(std::string_view s)
+{
+    static const char kHex[] = "0123456789ABCDEF";
+    std::string out;
+    for (const char c : s) {
+        const unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isalnum(uc) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out.push_back(c);
+        } else {
+            out.push_back('%');
+            out.push_back(kHex[uc >> 4]);
+            out.push_back(kHex[uc & 0x0F]);
+        }
+    }
+    return out;
+}
+
+#ifdef __linux__
+
+static int connect_local(std::uint16_t port)
+{
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Reads one response (head + Content-Length body). Returns the status, or -1.
+static int read_response(int fd, std::string& buf, std::uint64_t& bytes)
+{
+    std::size_t headEnd = std::string::npos;
+    char tmp[64 * 1024];
+    for (;;) {
+        headEnd = buf.find("\r\n\r\n");
+        if (headEnd != std::string::npos)
+            break;
+        const ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0)
+            return -1;
+        buf.append(tmp, static_cast<std::size_t>(n));
+    }
+
+    const std::string_view head(buf.data(), headEnd);
+    if (head.size() < 12 || head.substr(0, 5) != "HTTP/")
+        return -1;
+    const int status = std::atoi(std::string(head.substr(9, 3)).c_str());
+
+    std::size_t length = 0;
+    const std::size_t cl = head.find("Content-Length:");
+    if (cl != std::string_view::npos)
+        length = static_cast<std::size_t>(std::strtoull(buf.c_str() + cl + 15, nullptr, 10));
+
+    const std::size_t total = headEnd + 4 + length;
+    while (buf.size() < total) {
+        const ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0)
+            return -1;
+        buf.append(tmp, static_cast<std::size_t>(n));
+    }
+    bytes += total;
+    buf.erase(0, total);
+    return status;
+}
+
+static void run_worker(const LoadOptions& opt, const std::vector<std::string>& targets,
+                       std::size_t firstTarget, std::chrono::steady_clock::time_point deadline,
+                       WorkerResult& res)
+{
+    using Clock = std::chrono::steady_clock;
+
+    int fd = connect_local(opt.port);
+    std::string buf;
+    std::size_t t = firstTarget;
+
+    while (Clock::now() < deadline) {
+        if (fd < 0) {
+            ++res.errors;
+            fd = connect_local(opt.port);
+            if (fd < 0)
+                return;
+        }
+
+        const std::string req = "GET " + targets[t % targets.size()] + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        ++t;
+
+        const auto t0 = Clock::now();
+        if (::send(fd, req.data(), req.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(req.size())) {
+            ::close(fd);
+            fd = -1;
+            continue;
+        }
+        const int status = read_response(fd, buf, res.bytes);
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+        if (status < 0) {
+            ::close(fd);
+            fd = -1;
+            buf.clear();
+            continue;
+        }
+        if (status != 200)
+            ++res.non_200;
+        res.latency_ns.push_back(static_cast<std::uint32_t>(std::min<long long>(ns, 0xFFFFFFFFll)));
+    }
+    if (fd >= 0)
+        ::close(fd);
+}
+
+#endif // __linux__
+
+static double percentile_us(const std::vector<std::uint32_t>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    const std::size_t k = std::min(sorted.size() - 1, static_cast<std::size_t>(p * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[k]) / 1000.0;
+}
+
+static void printUsage(const char* exe)
+{
+    std::cout
+        << "Usage:\n"
+        << "  " << exe << " --port <p> [--connections <n>] [--seconds <s>]\n"
+        << "  " << std::string(std::strlen(exe), ' ') << " [--path <target>] [--words <file>] [--format <f>]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    LoadOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (a == "--port" && hasValue) {
+            opt.port = static_cast<std::uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "--connections" && hasValue) {
+            opt.connections = std::max(1, std::atoi(argv[++i]));
+        } else if (a == "--seconds" && hasValue) {
+            opt.seconds = std::atof(argv[++i]);
+        } else if (a == "--path" && hasValue) {
+            opt.path = argv[++i];
+        } else if (a == "--words" && hasValue) {
+            opt.words_file = argv[++i];
+        } else if (a == "--format" && hasValue) {
+            opt.format = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return a == "--help" || a == "-h" ? 0 : 2;
+        }
+    }
+    if (opt.port == 0) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+#ifndef __linux__
+    std::cerr << "ydict_httpload is only supported on Linux\n";
+    return 1;
+#else
+    std::vector<std::string> targets;
+    if (!opt.words_file.empty()) {
+        std::ifstream in(opt.words_file, std::ios::binary);
+        std::string w;
+        while (std::getline(in, w)) {
+            while (!w.empty() && (w.back() == '\r' || w.back() == ' '))
+                w.pop_back();
+            if (!w.empty())
+                targets.push_back("/render?word=" + url_encode(w) + "&format=" + url_encode(opt.format));
+        }
+        if (targets.empty()) {
+            std::cerr << "No words in " << opt.words_file << "\n";
+            return 1;
+        }
+    } else {
+        targets.push_back(opt.path);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double>(opt.seconds));
+
+    std::vector<WorkerResult> results(static_cast<std::size_t>(opt.connections));
+    std::vector<std::thread> threads;
+    for (int c = 0; c < opt.connections; ++c) {
+        // Spread the connections over the word list.
+        const std::size_t first = targets.size() * static_cast<std::size_t>(c) / static_cast<std::size_t>(opt.connections);
+        threads.emplace_back(run_worker, std::cref(opt), std::cref(targets), first, deadline,
+                             std::ref(results[static_cast<std::size_t>(c)]));
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::uint32_t> all;
+    std::uint64_t bytes = 0, errors = 0, non200 = 0;
+    for (const WorkerResult& r : results) {
+        all.insert(all.end(), r.latency_ns.begin(), r.latency_ns.end());
+        bytes += r.bytes;
+        errors += r.errors;
+        non200 += r.non_200;
+    }
+    std::sort(all.begin(), all.end());
+
+    std::printf("requests      %llu in %.2f s (%d connections)\n",
+                static_cast<unsigned long long>(all.size()), elapsed, opt.connections);
+    std::printf("throughput    %.0f req/s, %.1f MB/s\n",
+                static_cast<double>(all.size()) / elapsed, static_cast<double>(bytes) / elapsed / (1024.0 * 1024.0));
+    std::printf("latency us    p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                percentile_us(all, 0.50), percentile_us(all, 0.90), percentile_us(all, 0.99),
+                percentile_us(all, 0.999), all.empty() ? 0.0 : all.back() / 1000.0);
+    std::printf("non-200       %llu, reconnects %llu\n",
+                static_cast<unsigned long long>(non200), static_cast<unsigned long long>(errors));
+    return all.empty() ? 1 : 0;
+#endif
+}
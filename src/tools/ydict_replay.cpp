@@ -0,0 +1,269 @@
+/*
+ * ydict_replay - replay a query log against a Dictionary
+ * ------------------------------------------------------
+ * Loads a log written by `ydict_app --query-log` and runs its queries, in
+ * log order, against a dictionary loaded in this process:
+ *
+ *   --speed max       closed loop: every thread takes the next query as soon
+ *                     as it finished the last one (default)
+ *   --speed original  open loop at the recorded pace; --speed <x> at x times
+ *                     that pace. Latency is then measured from when the
+ *                     query was due, so time spent behind schedule counts
+ *                     (no coordinated omission).
+ *
+ * Prints throughput and, per query type and overall, p50/p99/p99.9 latency.
+ *
+ * Usage:
+ *   ydict_replay --log <file> --idx <path> --dat <path>
+ *                [--threads <n>] [--speed max|original|<x>] [--repeat <n>] [--cache <n>]
+ */
+
+#include "ydict/query_log.h"
+#include "ydict/ydict.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ReplayOptions
+{
+    std::string log_path;
+    std::string idx_path;
+    std::string dat_path;
+    std::size_t threads = 1;
+    double speed = 0.0;             // 0 = max; otherwise multiple of the recorded pace
+    std::size_t repeat = 1;
+    std::size_t cache = 64;         // Config::document_cache_entries
+};
+
+constexpr std::size_t kOpSlots = 6; // QueryOp values 1..5
+
+// Output sizes land here, so no work is optimized away.
+volatile std::uint64_t g_sink = 0;
+
+struct OpSamples
+{
+    std::vector<std::uint64_t> latency_ns;
+    std::uint64_t hits = 0;
+};
+
+struct ThreadResult
+{
+    std::array<OpSamples, kOpSlots> ops;
+    std::uint64_t sink = 0;         // output sizes, stored to g_sink at the end
+};
+
+// Runs one query the way ydict_app served it; returns whether it found anything.
+static bool run_query(const ydict::Dictionary& dict, const ydict::QueryRecord& q, std::uint64_t& sink)
+{
+    const auto fmt = static_cast<ydict::OutputFormat>(std::min<int>(q.format, static_cast<int>(ydict::OutputFormat::Json)));
+    const std::size_t limit = q.limit ? q.limit : 15;
+
+    switch (q.op) {
+    case ydict::QueryOp::Lookup:
+        return dict.findWord(q.key) >= 0;
+    case ydict::QueryOp::Suggest: {
+        const auto hits = dict.suggest(q.key, limit);
+        sink += hits.size();
+        return !hits.empty();
+    }
+    case ydict::QueryOp::Fuzzy: {
+        const auto hits = dict.fuzzy(q.key, limit, q.max_distance);
+        sink += hits.size();
+        return !hits.empty();
+    }
+    case ydict::QueryOp::Render: {
+        const int idx = dict.findWord(q.key);
+        const auto doc = idx >= 0 ? dict.document(idx) : nullptr;
+        if (!doc)
+            return false;
+        sink += ydict::renderDocument(*doc, fmt).size();
+        return true;
+    }
+    case ydict::QueryOp::RenderDirect: {
+        const int idx = dict.findWord(q.key);
+        if (idx < 0)
+            return false;
+        sink += ydict::renderRtf(dict.readRtf(idx), fmt).size();
+        return true;
+    }
+    }
+    return false;
+}
+
+static void replay_thread(const ydict::Dictionary& dict, const std::vector<ydict::QueryRecord>& log,
+                          const ReplayOptions& opt, std::atomic<std::size_t>& next, Clock::time_point start,
+                          std::uint64_t roundUs, ThreadResult& out)
+{
+    const std::size_t total = log.size() * opt.repeat;
+    for (std::size_t i = next.fetch_add(1); i < total; i = next.fetch_add(1)) {
+        const ydict::QueryRecord& q = log[i % log.size()];
+
+        Clock::time_point t0 = Clock::now();
+        if (opt.speed > 0) {
+            // Due time: recorded offset (later repeats follow on), scaled by the speed factor.
+            const double dueUs = static_cast<double>(q.time_us + (i / log.size()) * roundUs) / opt.speed;
+            const Clock::time_point due = start + std::chrono::microseconds(static_cast<std::int64_t>(dueUs));
+            if (due > t0)
+                std::this_thread::sleep_until(due);
+            t0 = due;
+        }
+
+        const bool hit = run_query(dict, q, out.sink);
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+
+        OpSamples& s = out.ops[static_cast<std::size_t>(q.op)];
+        s.latency_ns.push_back(static_cast<std::uint64_t>(ns));
+        s.hits += hit ? 1 : 0;
+    }
+}
+
+static double percentile_us(const std::vector<std::uint64_t>& sorted, double q)
+{
+    if (sorted.empty())
+        return 0.0;
+    const std::size_t i = std::min(sorted.size() - 1, static_cast<std::size_t>(q * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[i]) / 1e3;
+}
+
+static void print_row(const char* name, std::vector<std::uint64_t>& lat, std::uint64_t hits)
+{
+    std::sort(lat.begin(), lat.end());
+    std::printf("%-14s %9zu %9llu %10.1f %10.1f %10.1f %10.1f\n", name, lat.size(),
+                static_cast<unsigned long long>(hits), percentile_us(lat, 0.50), percentile_us(lat, 0.99),
+                percentile_us(lat, 0.999), lat.empty() ? 0.0 : static_cast<double>(lat.back()) / 1e3);
+}
+
+static void printUsage(const char* exe)
+{
+    std::cout
+        << "Usage:\n"
+        << "  " << exe << " --log <file> --idx <path> --dat <path> [options]\n"
+        << "\n"
+        << "Options:\n"
+        << "  --threads <n>                 Replay threads (default 1)\n"
+        << "  --speed max|original|<x>      Closed loop (default), recorded pace, or x times it\n"
+        << "  --repeat <n>                  Replay the log n times (default 1)\n"
+        << "  --cache <n>                   Document cache entries (default 64, as ydict_app)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ReplayOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (a == "--log" && hasValue) {
+            opt.log_path = argv[++i];
+        } else if (a == "--idx" && hasValue) {
+            opt.idx_path = argv[++i];
+        } else if (a == "--dat" && hasValue) {
+            opt.dat_path = argv[++i];
+        } else if (a == "--threads" && hasValue) {
+            opt.threads = std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "--speed" && hasValue) {
+            const std::string_view v = argv[++i];
+            opt.speed = v == "max" ? 0.0 : v == "original" ? 1.0 : std::atof(argv[i]);
+            if (opt.speed < 0.0 || (opt.speed == 0.0 && v != "max")) {
+                printUsage(argv[0]);
+                return 2;
+            }
+        } else if (a == "--repeat" && hasValue) {
+            opt.repeat = std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "--cache" && hasValue) {
+            opt.cache = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            printUsage(argv[0]);
+            return a == "--help" || a == "-h" ? 0 : 2;
+        }
+    }
+    if (opt.log_path.empty() || opt.idx_path.empty() || opt.dat_path.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<ydict::QueryRecord> log;
+    std::string why;
+    if (!ydict::readQueryLog(opt.log_path, log, &why)) {
+        std::cerr << opt.log_path << ": " << why << "\n";
+        return 1;
+    }
+    if (log.empty()) {
+        std::cerr << opt.log_path << ": no queries\n";
+        return 1;
+    }
+
+    ydict::Config cfg;
+    cfg.idx_path = opt.idx_path;
+    cfg.dat_path = opt.dat_path;
+    cfg.document_cache_entries = opt.cache;
+    const auto dict = ydict::Dictionary::open(cfg);
+    if (!dict) {
+        std::cerr << "Cannot load " << opt.idx_path << " / " << opt.dat_path << "\n";
+        return 1;
+    }
+
+    // A repeat starts one mean inter-arrival gap after the previous round's last query.
+    const std::uint64_t roundUs = log.back().time_us + log.back().time_us / log.size() + 1;
+
+    std::vector<ThreadResult> results(opt.threads);
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> next{0};
+    const Clock::time_point start = Clock::now();
+    for (std::size_t t = 0; t < opt.threads; ++t) {
+        threads.emplace_back(replay_thread, std::cref(*dict), std::cref(log), std::cref(opt), std::ref(next), start,
+                             roundUs, std::ref(results[t]));
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::array<std::vector<std::uint64_t>, kOpSlots> perOp;
+    std::array<std::uint64_t, kOpSlots> hits{};
+    std::vector<std::uint64_t> all;
+    std::uint64_t allHits = 0;
+    std::uint64_t sink = 0;
+    for (ThreadResult& r : results) {
+        sink += r.sink;
+        for (std::size_t k = 0; k < kOpSlots; ++k) {
+            perOp[k].insert(perOp[k].end(), r.ops[k].latency_ns.begin(), r.ops[k].latency_ns.end());
+            hits[k] += r.ops[k].hits;
+            allHits += r.ops[k].hits;
+        }
+    }
+    for (const auto& v : perOp) {
+        all.insert(all.end(), v.begin(), v.end());
+    }
+
+    std::printf("replay        %zu queries x%zu, %zu thread(s), %s\n", log.size(), opt.repeat, opt.threads,
+                opt.speed > 0 ? (opt.speed == 1.0 ? "original speed" : "scaled speed") : "max speed");
+    if (opt.speed > 0)
+        std::printf("              speed x%.2f; latency counted from each query's due time\n", opt.speed);
+    std::printf("throughput    %.0f queries/s (%.3f s)\n", static_cast<double>(all.size()) / wall, wall);
+    std::printf("\n%-14s %9s %9s %10s %10s %10s %10s\n", "op", "count", "hits", "p50 us", "p99 us", "p99.9 us",
+                "max us");
+    for (std::size_t k = 1; k < kOpSlots; ++k) {
+        if (!perOp[k].empty())
+            print_row(ydict::queryOpName(static_cast<ydict::QueryOp>(k)), perOp[k], hits[k]);
+    }
+    print_row("all", all, allHits);
+
+    g_sink = sink;
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "ydict/app_batch.h"
+#include "ydict/app_io.h"
+#include "ydict/thread_pool.h"
+#include "ydict/trace.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool parseSeparator(std::string_view arg, std::string& out)
+{
+    out.clear();
+    for (size_t i = 0; i < arg.size(); ++i) {
+        if (arg[i] != '\\') {
+            out.push_back(arg[i]);
+            continue;
+        }
+        if (i + 1 >= arg.size())
+            return false;
+        switch (arg[++i]) {
+        case 'n':  out.push_back('\n'); break;
+        case 't':  out.push_back('\t'); break;
+        case 'r':  out.push_back('\r'); break;
+        case '0':  out.push_back('\0'); break;
+        case '\\': out.push_back('\\'); break;
+        case 'x': {
+            const int h1 = i + 1 < arg.size() ? hex_digit(arg[i + 1]) : -1;
+            const int h2 = i + 2 < arg.size() ? hex_digit(arg[i + 2]) : -1;
+            if (h1 < 0 || h2 < 0)
+                return false;
+            out.push_back(static_cast<char>((h1 << 4) | h2));
+            i += 2;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string_view trim_query(std::string_view s)
+{
+    auto isWs = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    while (!s.empty() && isWs(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isWs(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+// One record: rendered definition ending in '\n', or the not-found line.
+static void render_record(const ydict::Dictionary& dict, const BatchOptions& opt,
+                          std::string_view word, std::string& out, bool& found)
+{
+    ydict::TraceSpan trace("lookup", "request", word);
+    if (opt.query_log)
+        opt.query_log->append(ydict::QueryOp::RenderDirect, word, 0, static_cast<std::uint8_t>(opt.format));
+    out.clear();
+    const int idx = dict.findWord(word);
+    found = idx >= 0;
+
+    if (found) {
+        out = ydict::renderRtf(dict.readRtf(idx), opt.format);
+    } else {
+        out.append("word=\"").append(word).append("\" NOT FOUND");
+    }
+    if (out.empty() || out.back() != '\n')
+        out.push_back('\n');
+}
+
+int runBatch(const ydict::Dictionary& dict, const BatchOptions& opt)
+{
+    LineReader in(opt.input);
+    if (!in.ok()) {
+        std::cerr << "Cannot open batch input: " << opt.input << "\n";
+        return 1;
+    }
+    BufferedWriter out("-");
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // Without --jobs the caller does all the work; the pool only adds helpers.
+    const size_t jobs = opt.jobs == 0 ? ydict::ThreadPool::defaultThreads() : opt.jobs;
+    std::unique_ptr<ydict::ThreadPool> pool;
+    if (jobs > 1)
+        pool = std::make_unique<ydict::ThreadPool>(jobs - 1);
+
+    // Enough lines per window to keep every worker busy, few enough to start output early.
+    const size_t window = jobs > 1 ? 256 * jobs : 64;
+
+    std::vector<std::string> queries(window);
+    std::vector<std::string> records(window);
+    std::unique_ptr<bool[]> found(new bool[window]);
+
+    size_t total = 0;
+    size_t misses = 0;
+    std::string line;
+    bool eof = false;
+
+    while (!eof) {
+        size_t n = 0;
+        while (n < window) {
+            if (!in.next(line)) {
+                eof = true;
+                break;
+            }
+            const std::string_view q = trim_query(line);
+            if (q.empty())
+                continue;
+            queries[n++].assign(q.data(), q.size());
+        }
+
+        auto lookup = [&](size_t i) { render_record(dict, opt, queries[i], records[i], found[i]); };
+        if (pool) {
+            pool->parallelFor(n, lookup);
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                lookup(i);
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            out.write(records[i]);
+            out.write(opt.separator);
+            if (!found[i])
+                ++misses;
+        }
+        total += n;
+    }
+
+    const bool written = out.flush();
+
+    if (opt.diagnostics) {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cerr << "batch: " << total << " queries, " << misses << " not found, "
+                  << jobs << " job(s), " << ms << " ms\n";
+    }
+    return written ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ydict/query_log.h"
+#include "ydict/ydict.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Batch mode (ydict_app --batch)
+ * ------------------------------
+ * One dictionary init, then one lookup per input line (newline-delimited,
+ * trailing CR/whitespace trimmed, empty lines skipped). Each record is the
+ * rendered definition, always ending in '\n', followed by the separator;
+ * a miss is the single line `word="..." NOT FOUND`.
+ *
+ * Lookups run in windows of input lines; with jobs > 1 a window is spread
+ * over a worker pool and its records are still written in input order,
+ * through one large output buffer.
+ */
+struct BatchOptions
+{
+    std::string input = "-";       // file path, or "-" for stdin
+    std::string separator = "\n";  // written after every record
+    ydict::OutputFormat format = ydict::OutputFormat::Cli;
+    std::size_t jobs = 1;          // 0 = one per hardware thread
+    bool diagnostics = false;      // summary line on stderr
+    ydict::QueryLogWriter* query_log = nullptr;  // record every lookup (--query-log)
+};
+
+// Returns the process exit code.
+int runBatch(const ydict::Dictionary& dict, const BatchOptions& opt);
+
+// Decode a --separator argument: \n \t \r \0 \\ and \xHH escapes.
+bool parseSeparator(std::string_view arg, std::string& out);
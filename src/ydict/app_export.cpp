@@ -0,0 +1,176 @@
+#include "ydict/app_export.h"
+#include "ydict/app_io.h"
+#include "ydict/json.h"
+#include "ydict/thread_pool.h"
+#include "ydict/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static constexpr std::size_t kChunkEntries = 64;
+static constexpr std::size_t kChunksAheadPerJob = 4;   // rendered-but-unwritten chunks allowed per worker
+static constexpr std::size_t kWriteBuffer = 8u << 20;
+
+bool parseExportFormat(std::string_view name, ExportFormat& fmt)
+{
+    if (name == "jsonl") { fmt = ExportFormat::Jsonl; return true; }
+    if (name == "tsv")   { fmt = ExportFormat::Tsv;   return true; }
+    return false;
+}
+
+static void append_tsv_field(std::string& out, std::string_view s)
+{
+    for (const char c : s) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\r': out += "\\r"; break;
+        case '\n': out += "\\n"; break;
+        default:   out.push_back(c); break;
+        }
+    }
+}
+
+// Appends entry `idx`'s record to `out`; false if its definition cannot be read.
+static bool export_record(const ydict::Dictionary& dict, ExportFormat format, int idx, std::string& out)
+{
+    const auto e = dict.wordAt(idx);
+    const std::string rtf = e ? dict.readRtf(idx) : std::string();
+    if (rtf.empty())
+        return false;
+
+    const ydict::Document doc = ydict::parseDocument(rtf);
+    const std::string plain = ydict::renderDocument(doc, ydict::OutputFormat::Plain);
+
+    if (format == ExportFormat::Tsv) {
+        out += std::to_string(idx);
+        out.push_back('\t');
+        append_tsv_field(out, e->word);
+        out.push_back('\t');
+        append_tsv_field(out, plain);
+        out.push_back('\n');
+        return true;
+    }
+
+    out += "{\"index\":";
+    out += std::to_string(idx);
+    out += ",\"headword\":";
+    ydict::appendJsonString(out, e->word);
+    out += ",\"plain\":";
+    ydict::appendJsonString(out, plain);
+    out += ",\"rendered\":";
+    ydict::appendJsonString(out, ydict::renderDocument(doc, ydict::OutputFormat::Cli));
+    out += "}\n";
+    return true;
+}
+
+/*
+ * Writes chunks out in sequence, whatever order they finish in. A finished
+ * chunk is parked; the worker that parks the next one to go out drains every
+ * consecutive ready chunk to the file outside the lock, so rendering never
+ * waits on I/O except for the one worker doing it. acquire() holds a worker
+ * back while it is too far ahead of the output, bounding memory.
+ */
+class OrderedChunkWriter {
+public:
+    OrderedChunkWriter(BufferedWriter& out, std::size_t maxAhead) : out_(out), maxAhead_(maxAhead) {}
+
+    // Wait until chunk `k` may be rendered.
+    void acquire(std::size_t k)
+    {
+        std::unique_lock<std::mutex> lock(mu_);
+        roomCv_.wait(lock, [&] { return k < next_ + maxAhead_; });
+    }
+
+    void commit(std::size_t k, std::string chunk)
+    {
+        std::unique_lock<std::mutex> lock(mu_);
+        ready_.emplace(k, std::move(chunk));
+        if (writing_)
+            return; // the current writer picks it up
+        writing_ = true;
+        while (!ready_.empty() && ready_.begin()->first == next_) {
+            std::string out = std::move(ready_.begin()->second);
+            ready_.erase(ready_.begin());
+            lock.unlock();
+            out_.write(out);
+            lock.lock();
+            ++next_;
+            roomCv_.notify_all();
+        }
+        writing_ = false;
+    }
+
+private:
+    BufferedWriter& out_;
+    const std::size_t maxAhead_;
+    std::mutex mu_;
+    std::condition_variable roomCv_;
+    std::map<std::size_t, std::string> ready_;
+    std::size_t next_ = 0;
+    bool writing_ = false;
+};
+
+int runExport(const ydict::Dictionary& dict, const ExportOptions& opt)
+{
+    BufferedWriter out(opt.output, kWriteBuffer);
+    if (!out.ok()) {
+        std::cerr << "Cannot open export output: " << opt.output << "\n";
+        return 1;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // .dat offset order: consecutive entries read consecutive ranges of the file.
+    const int count = dict.wordCount();
+    const std::vector<int> order = dict.entriesInDatOrder();
+
+    // As in batch mode, the calling thread works too; the pool only adds helpers.
+    const std::size_t jobs = opt.jobs == 0 ? ydict::ThreadPool::defaultThreads() : opt.jobs;
+    std::unique_ptr<ydict::ThreadPool> pool;
+    if (jobs > 1)
+        pool = std::make_unique<ydict::ThreadPool>(jobs - 1);
+
+    const std::size_t chunks = (order.size() + kChunkEntries - 1) / kChunkEntries;
+    OrderedChunkWriter writer(out, kChunksAheadPerJob * jobs);
+    std::atomic<std::size_t> failed{0};
+
+    auto exportChunk = [&](std::size_t k) {
+        ydict::TraceSpan trace("export.chunk", "export");
+        writer.acquire(k);
+        std::string chunk;
+        const std::size_t end = std::min(order.size(), (k + 1) * kChunkEntries);
+        for (std::size_t i = k * kChunkEntries; i < end; ++i) {
+            if (!export_record(dict, opt.format, order[i], chunk))
+                failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        writer.commit(k, std::move(chunk));
+    };
+    if (pool) {
+        pool->parallelFor(chunks, exportChunk);
+    } else {
+        for (std::size_t k = 0; k < chunks; ++k) {
+            exportChunk(k);
+        }
+    }
+
+    const bool written = out.flush();
+
+    if (failed.load() > 0)
+        std::cerr << "export: " << failed.load() << " entries could not be read (skipped)\n";
+    if (opt.diagnostics) {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cerr << "export: " << count - static_cast<int>(failed.load()) << " records, " << jobs << " job(s), "
+                  << ms << " ms\n";
+    }
+    if (!written)
+        std::cerr << "Cannot write export output: " << opt.output << "\n";
+    return written ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ydict/ydict.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Whole-dictionary export (ydict_app --export <jsonl|tsv> <out>)
+ * --------------------------------------------------------------
+ * Every entry, one record per line:
+ *
+ *   jsonl  {"index":N,"headword":W,"plain":P,"rendered":R}
+ *          plain = OutputFormat::Plain, rendered = OutputFormat::Cli
+ *   tsv    index<TAB>headword<TAB>plain, with \ TAB CR LF in the fields
+ *          escaped as \\ \t \r \n
+ *
+ * Records come in .dat offset order (for ydpdict data, the index order),
+ * so the definitions are read front to back. Entries are rendered in chunks
+ * on a worker pool; finished chunks are written in order through one large
+ * buffer by whichever worker completes the next one, and workers never run
+ * more than a few chunks ahead of the output. Entries that cannot be read
+ * are skipped and counted.
+ */
+enum class ExportFormat { Jsonl, Tsv };
+
+struct ExportOptions
+{
+    ExportFormat format = ExportFormat::Jsonl;
+    std::string output;             // file path, or "-" for stdout
+    std::size_t jobs = 0;           // 0 = one per hardware thread
+    bool diagnostics = false;       // summary line on stderr
+};
+
+bool parseExportFormat(std::string_view name, ExportFormat& fmt);
+
+// Returns the process exit code.
+int runExport(const ydict::Dictionary& dict, const ExportOptions& opt);
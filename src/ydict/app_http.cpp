@@ -0,0 +1,761 @@
+#include "ydict/app_http.h"
+
+#include <iostream>
+
+#ifndef __linux__
+
+int runHttpServer(ydict::LiveDictionary&, const HttpOptions&)
+{
+    std::cerr << "--http is only supported on Linux\n";
+    return 1;
+}
+
+#else
+
+#include "ydict/json.h"
+#include "ydict/thread_pool.h"
+#include "ydict/trace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kMaxHeaderBytes = 16 * 1024;
+constexpr std::size_t kMaxRequestsPerConn = 100000;
+
+struct HttpRequest
+{
+    std::string_view method;
+    std::string_view path;
+    std::string_view query;
+    bool keep_alive = true;
+    std::size_t content_length = 0;
+};
+
+struct HttpResponse
+{
+    int status = 200;
+    const char* content_type = "application/json";
+    std::string body;
+};
+
+const char* status_text(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 431: return "Request Header Fields Too Large";
+    default:  return "Error";
+    }
+}
+
+bool iequals(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        const char x = static_cast<char>(std::tolower(static_cast<unsigned char>(a[i])));
+        const char y = static_cast<char>(std::tolower(static_cast<unsigned char>(b[i])));
+        if (x != y)
+            return false;
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string url_decode(std::string_view s)
+{
+    std::string out;
+    out.reserve(s.size());
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            out.push_back(' ');
+        } else if (s[i] == '%' && i + 2 < s.size() && hex_digit(s[i + 1]) >= 0 && hex_digit(s[i + 2]) >= 0) {
+            out.push_back(static_cast<char>((hex_digit(s[i + 1]) << 4) | hex_digit(s[i + 2])));
+            i += 2;
+        } else {
+            out.push_back(s[i]);
+        }
+    }
+    return out;
+}
+
+// Value of `name` in an x-www-form-urlencoded query string (decoded), or false.
+bool query_param(std::string_view query, std::string_view name, std::string& value)
+{
+    while (!query.empty()) {
+        const std::size_t amp = query.find('&');
+        const std::string_view pair = query.substr(0, amp);
+        const std::size_t eq = pair.find('=');
+        if (pair.substr(0, eq) == name) {
+            value = eq == std::string_view::npos ? std::string() : url_decode(pair.substr(eq + 1));
+            return true;
+        }
+        if (amp == std::string_view::npos)
+            break;
+        query.remove_prefix(amp + 1);
+    }
+    return false;
+}
+
+// Parses the request head (up to and including the blank line).
+bool parse_head(std::string_view head, HttpRequest& req)
+{
+    const std::size_t eol = head.find("\r\n");
+    const std::string_view line = head.substr(0, eol);
+
+    const std::size_t sp1 = line.find(' ');
+    const std::size_t sp2 = line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 == sp1)
+        return false;
+    req.method = line.substr(0, sp1);
+    const std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    const std::string_view version = line.substr(sp2 + 1);
+    if (version != "HTTP/1.1" && version != "HTTP/1.0")
+        return false;
+    req.keep_alive = version == "HTTP/1.1";
+
+    const std::size_t q = target.find('?');
+    req.path = target.substr(0, q);
+    req.query = q == std::string_view::npos ? std::string_view() : target.substr(q + 1);
+
+    std::string_view rest = head.substr(eol + 2);
+    while (!rest.empty()) {
+        const std::size_t e = rest.find("\r\n");
+        const std::string_view h = rest.substr(0, e);
+        rest.remove_prefix(e == std::string_view::npos ? rest.size() : e + 2);
+        const std::size_t colon = h.find(':');
+        if (colon == std::string_view::npos)
+            continue;
+        const std::string_view name = trim(h.substr(0, colon));
+        const std::string_view value = trim(h.substr(colon + 1));
+        if (iequals(name, "Connection")) {
+            if (iequals(value, "close"))
+                req.keep_alive = false;
+            else if (iequals(value, "keep-alive"))
+                req.keep_alive = true;
+        } else if (iequals(name, "Content-Length")) {
+            req.content_length = static_cast<std::size_t>(std::strtoull(std::string(value).c_str(), nullptr, 10));
+        }
+    }
+    return true;
+}
+
+void json_error(HttpResponse& res, int status, std::string_view message)
+{
+    res.status = status;
+    res.content_type = "application/json";
+    res.body = "{\"error\":";
+    ydict::appendJsonString(res.body, message);
+    res.body += "}";
+}
+
+const char* content_type_for(ydict::OutputFormat fmt)
+{
+    switch (fmt) {
+    case ydict::OutputFormat::Html: return "text/html; charset=utf-8";
+    case ydict::OutputFormat::Json: return "application/json";
+    default:                        return "text/plain; charset=utf-8";
+    }
+}
+
+void handle(const ydict::Dictionary& dict, const HttpRequest& req, HttpResponse& res, ydict::QueryLogWriter* log)
+{
+    if (req.path == "/lookup") {
+        std::string word;
+        if (!query_param(req.query, "word", word) || word.empty())
+            return json_error(res, 400, "missing word");
+        if (log)
+            log->append(ydict::QueryOp::Lookup, word);
+        const int idx = dict.findWord(word);
+        res.status = idx >= 0 ? 200 : 404;
+        res.body = "{\"word\":";
+        ydict::appendJsonString(res.body, word);
+        res.body += idx >= 0 ? ",\"found\":true,\"index\":" + std::to_string(idx) + "}"
+                             : std::string(",\"found\":false}");
+        return;
+    }
+
+    if (req.path == "/suggest") {
+        std::string prefix;
+        std::string limitStr;
+        if (!query_param(req.query, "prefix", prefix))
+            return json_error(res, 400, "missing prefix");
+        std::size_t limit = 15;
+        if (query_param(req.query, "limit", limitStr)) {
+            limit = static_cast<std::size_t>(std::strtoul(limitStr.c_str(), nullptr, 10));
+            if (limit == 0 || limit > 1000)
+                return json_error(res, 400, "limit must be 1..1000");
+        }
+        std::string deadlineStr;
+        ydict::QueryBudget budget;
+        if (query_param(req.query, "deadline_ms", deadlineStr)) {
+            const unsigned long ms = std::strtoul(deadlineStr.c_str(), nullptr, 10);
+            if (ms > 60000)
+                return json_error(res, 400, "deadline_ms must be 0..60000");
+            if (ms > 0)
+                budget = ydict::QueryBudget::within(std::chrono::milliseconds(ms));
+        }
+        if (log)
+            log->append(ydict::QueryOp::Suggest, prefix, static_cast<std::uint32_t>(limit));
+        res.body = "{\"prefix\":";
+        ydict::appendJsonString(res.body, prefix);
+        res.body += ",\"words\":[";
+        bool first = true;
+        bool truncated = false;
+        for (const int i : dict.suggest(prefix, limit, budget, &truncated)) {
+            const auto e = dict.wordAt(i);
+            if (!e)
+                continue;
+            if (!first)
+                res.body.push_back(',');
+            first = false;
+            ydict::appendJsonString(res.body, e->word);
+        }
+        res.body += truncated ? "],\"truncated\":true}" : "],\"truncated\":false}";
+        return;
+    }
+
+    if (req.path == "/render") {
+        std::string word;
+        std::string formatName = "json";
+        if (!query_param(req.query, "word", word) || word.empty())
+            return json_error(res, 400, "missing word");
+        query_param(req.query, "format", formatName);
+        ydict::OutputFormat fmt;
+        if (!ydict::parseOutputFormat(formatName, fmt))
+            return json_error(res, 400, "unknown format");
+        if (log)
+            log->append(ydict::QueryOp::Render, word, 0, static_cast<std::uint8_t>(fmt));
+
+        const int idx = dict.findWord(word);
+        const auto doc = idx >= 0 ? dict.document(idx) : nullptr;
+        if (!doc)
+            return json_error(res, 404, "not found");
+        res.content_type = content_type_for(fmt);
+        res.body = ydict::renderDocument(*doc, fmt);
+        return;
+    }
+
+    json_error(res, 404, "unknown endpoint");
+}
+
+void append_response(std::string& out, const HttpResponse& res, bool keepAlive, bool head)
+{
+    out += "HTTP/1.1 ";
+    out += std::to_string(res.status);
+    out += ' ';
+    out += status_text(res.status);
+    out += "\r\nContent-Type: ";
+    out += res.content_type;
+    out += "\r\nContent-Length: ";
+    out += std::to_string(res.body.size());
+    out += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    if (!head)
+        out += res.body;
+}
+
+// One request taken off a connection, owning its strings so a worker can run it.
+struct HttpJob
+{
+    std::string path;
+    std::string query;
+    HttpResponse res;
+    bool answered = false;      // res already holds the reply (bad request)
+    bool keep_alive = true;
+    bool head = false;
+};
+
+// Loop wake-up tags: fixed descriptors first; connections count up from kFirstConn.
+enum : std::uint64_t { kTagListen = 1, kTagWake = 2, kTagSignal = 3, kFirstConn = 16 };
+
+constexpr std::size_t kMaxBacklog = 8u << 20;   // stop reading while this much output is queued
+
+/*
+ * HttpServer
+ * ----------
+ * As in --serve, one epoll loop thread owns every socket: it reads, splits the
+ * input into requests and writes responses, so an idle keep-alive connection
+ * costs a map entry, not a worker. Each batch of complete requests (several
+ * when pipelined) goes to the pool as one task; its responses come back
+ * through `done_` and are sent with one send(). A connection has at most one
+ * batch in flight and is not read meanwhile, which keeps responses in request
+ * order. Connections are keyed by a never-reused tag, so a batch finishing
+ * after its connection closed is dropped.
+ */
+class HttpServer {
+public:
+    HttpServer(ydict::LiveDictionary& live, const HttpOptions& opt) : live_(live), opt_(opt) {}
+
+    ~HttpServer();
+
+    bool start();
+    void run();
+
+    std::uint64_t accepted() const { return accepted_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Conn
+    {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        std::size_t out_pos = 0;
+        std::uint32_t events = 0;
+        std::size_t served = 0;
+        bool busy = false;      // a batch is on the pool
+        bool closing = false;   // close once `out` is sent
+        Clock::time_point last_active;
+    };
+
+    struct Completion
+    {
+        std::uint64_t conn = 0;
+        std::string out;
+    };
+
+    bool add_fd(int fd, std::uint64_t tag, std::uint32_t events);
+    void accept_all();
+    void on_readable(std::uint64_t tag, Conn& c);
+    void dispatch(std::uint64_t tag, Conn& c);
+    void flush(std::uint64_t tag, Conn& c);
+    void update_interest(std::uint64_t tag, Conn& c);
+    void close_conn(std::uint64_t tag);
+    void drain_completions();
+    void post(std::uint64_t tag, std::string out);
+    void close_idle();
+
+    ydict::LiveDictionary& live_;
+    HttpOptions opt_;
+    std::unique_ptr<ydict::ThreadPool> pool_;
+
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    int signal_fd_ = -1;
+
+    std::unordered_map<std::uint64_t, Conn> conns_;
+    std::uint64_t next_tag_ = kFirstConn;
+
+    std::mutex done_mu_;
+    std::vector<Completion> done_;   // filled by workers, drained by the loop
+
+    std::uint64_t accepted_ = 0;
+};
+
+HttpServer::~HttpServer()
+{
+    // Finish in-flight batches first: they post to wake_fd_ and done_.
+    pool_.reset();
+
+    for (auto& [tag, c] : conns_) {
+        ::close(c.fd);
+    }
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    if (epoll_fd_ >= 0)  ::close(epoll_fd_);
+    if (wake_fd_ >= 0)   ::close(wake_fd_);
+    if (signal_fd_ >= 0) ::close(signal_fd_);
+}
+
+bool HttpServer::add_fd(int fd, std::uint64_t tag, std::uint32_t events)
+{
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = tag;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool HttpServer::start()
+{
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "socket() failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    const int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt_.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local tools only
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd_, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on 127.0.0.1:" << opt_.port << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // Block the shutdown/reload signals before the workers start, so only signal_fd_ sees them.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    sigdelset(&mask, SIGPIPE);
+
+    pool_ = std::make_unique<ydict::ThreadPool>(opt_.jobs);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0 || signal_fd_ < 0 ||
+        !add_fd(listen_fd_, kTagListen, EPOLLIN) ||
+        !add_fd(wake_fd_, kTagWake, EPOLLIN) ||
+        !add_fd(signal_fd_, kTagSignal, EPOLLIN)) {
+        std::cerr << "epoll setup failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::run()
+{
+    if (opt_.diagnostics) {
+        std::cerr << "http on 127.0.0.1:" << opt_.port << " (" << pool_->size() << " workers)\n";
+    }
+
+    // Idle connections are swept a few times per timeout period.
+    const int sweepMs = opt_.idle_timeout_ms > 0 ? std::max(50, opt_.idle_timeout_ms / 4) : -1;
+    Clock::time_point nextSweep = Clock::now() + std::chrono::milliseconds(std::max(sweepMs, 0));
+
+    std::vector<epoll_event> events(256);
+    for (;;) {
+        const int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), sweepMs);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << "\n";
+            return;
+        }
+
+        for (int k = 0; k < n; ++k) {
+            const std::uint64_t tag = events[k].data.u64;
+            const std::uint32_t ev = events[k].events;
+
+            if (tag == kTagListen) {
+                accept_all();
+                continue;
+            }
+            if (tag == kTagWake) {
+                drain_completions();
+                continue;
+            }
+            if (tag == kTagSignal) {
+                signalfd_siginfo si;
+                bool hup = false, stop = false;
+                while (::read(signal_fd_, &si, sizeof(si)) == sizeof(si)) {
+                    (si.ssi_signo == SIGHUP ? hup : stop) = true;
+                }
+                if (stop)
+                    return;
+                if (hup)
+                    live_.reload();
+                continue;
+            }
+
+            auto it = conns_.find(tag);
+            if (it == conns_.end())
+                continue;
+            if (ev & (EPOLLERR | EPOLLHUP)) {
+                close_conn(tag);
+                continue;
+            }
+            if (ev & EPOLLOUT) {
+                flush(tag, it->second);
+                it = conns_.find(tag);
+            }
+            if ((ev & EPOLLIN) && it != conns_.end())
+                on_readable(tag, it->second);
+        }
+
+        if (sweepMs > 0 && Clock::now() >= nextSweep) {
+            close_idle();
+            nextSweep = Clock::now() + std::chrono::milliseconds(sweepMs);
+        }
+    }
+}
+
+void HttpServer::accept_all()
+{
+    for (;;) {
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return; // EAGAIN, or a transient error: keep serving
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ++accepted_;
+        const std::uint64_t tag = next_tag_++;
+        Conn& c = conns_[tag];
+        c.fd = fd;
+        c.events = EPOLLIN;
+        c.last_active = Clock::now();
+        if (!add_fd(fd, tag, c.events))
+            close_conn(tag);
+    }
+}
+
+void HttpServer::on_readable(std::uint64_t tag, Conn& c)
+{
+    char buf[16 * 1024];
+    const ssize_t r = ::read(c.fd, buf, sizeof(buf));
+    if (r < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+    if (r <= 0) {
+        // Client closed its side (or an error): answer what it already sent, then close.
+        c.closing = true;
+        if (!c.busy && c.out_pos == c.out.size())
+            close_conn(tag);
+        else
+            update_interest(tag, c);
+        return;
+    }
+    c.last_active = Clock::now();
+    c.in.append(buf, static_cast<std::size_t>(r));
+    dispatch(tag, c);
+}
+
+/*
+ * Takes every complete request buffered on `c` and hands them to the pool as
+ * one batch. Requests that cannot be served are answered here (in the batch,
+ * so ordering holds); the batch ends at the first one that closes the
+ * connection.
+ */
+void HttpServer::dispatch(std::uint64_t tag, Conn& c)
+{
+    if (c.busy || c.closing)
+        return;
+
+    std::vector<HttpJob> batch;
+    std::size_t pos = 0;
+    for (;;) {
+        const std::size_t end = c.in.find("\r\n\r\n", pos);
+        if (end == std::string::npos) {
+            if (c.in.size() - pos > kMaxHeaderBytes) {
+                HttpJob& job = batch.emplace_back();
+                json_error(job.res, 431, "request head too large");
+                job.answered = true;
+                job.keep_alive = false;
+                c.closing = true;
+            }
+            break;
+        }
+
+        HttpRequest req;
+        HttpJob& job = batch.emplace_back();
+        const std::string_view head(c.in.data() + pos, end + 4 - pos);
+        if (!parse_head(head, req)) {
+            json_error(job.res, 400, "malformed request");
+            job.answered = true;
+            req.keep_alive = false;
+        } else if (req.content_length > 0) {
+            json_error(job.res, 400, "request bodies are not accepted");
+            job.answered = true;
+            req.keep_alive = false;
+        } else if (req.method != "GET" && req.method != "HEAD") {
+            json_error(job.res, 405, "only GET and HEAD");
+            job.answered = true;
+        } else {
+            job.path = std::string(req.path);
+            job.query = std::string(req.query);
+        }
+        job.head = req.method == "HEAD";
+
+        ++c.served;
+        job.keep_alive = req.keep_alive && c.served < kMaxRequestsPerConn;
+        pos = end + 4;
+        if (!job.keep_alive) {
+            c.closing = true;
+            break;
+        }
+    }
+    c.in.erase(0, c.closing ? c.in.size() : pos);
+
+    if (batch.empty()) {
+        update_interest(tag, c);
+        return;
+    }
+
+    c.busy = true;
+    update_interest(tag, c);
+    pool_->submit([this, tag, batch = std::move(batch)]() mutable {
+        std::string out;
+        for (HttpJob& job : batch) {
+            if (!job.answered) {
+                // Per request, not per connection: keep-alive clients see a reload too.
+                ydict::TraceSpan trace("http.request", "request", job.path);
+                const HttpRequest req{job.head ? "HEAD" : "GET", job.path, job.query, job.keep_alive, 0};
+                handle(*live_.snapshot(), req, job.res, opt_.query_log);
+            }
+            append_response(out, job.res, job.keep_alive, job.head);
+        }
+        post(tag, std::move(out));
+    });
+}
+
+void HttpServer::post(std::uint64_t tag, std::string out)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(done_mu_);
+        wake = done_.empty();
+        done_.push_back(Completion{tag, std::move(out)});
+    }
+    if (wake) {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const ssize_t w = ::write(wake_fd_, &one, sizeof(one));
+    }
+}
+
+void HttpServer::drain_completions()
+{
+    std::uint64_t counter = 0;
+    [[maybe_unused]] const ssize_t r = ::read(wake_fd_, &counter, sizeof(counter));
+
+    std::vector<Completion> batch;
+    {
+        std::lock_guard<std::mutex> lock(done_mu_);
+        batch.swap(done_);
+    }
+
+    for (Completion& d : batch) {
+        auto it = conns_.find(d.conn);
+        if (it == conns_.end())
+            continue; // client went away
+        Conn& c = it->second;
+        c.busy = false;
+        c.last_active = Clock::now();
+        c.out += d.out;
+        flush(d.conn, c);
+        // Pipelined requests that arrived while the batch ran.
+        it = conns_.find(d.conn);
+        if (it != conns_.end())
+            dispatch(d.conn, it->second);
+    }
+}
+
+void HttpServer::flush(std::uint64_t tag, Conn& c)
+{
+    while (c.out_pos < c.out.size()) {
+        const ssize_t w = ::send(c.fd, c.out.data() + c.out_pos, c.out.size() - c.out_pos, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                break;
+            close_conn(tag);
+            return;
+        }
+        c.out_pos += static_cast<std::size_t>(w);
+    }
+    if (c.out_pos == c.out.size()) {
+        c.out.clear();
+        c.out_pos = 0;
+        if (c.closing && !c.busy) {
+            close_conn(tag);
+            return;
+        }
+    } else if (c.out_pos > (1u << 20)) {
+        c.out.erase(0, c.out_pos);
+        c.out_pos = 0;
+    }
+    update_interest(tag, c);
+}
+
+void HttpServer::update_interest(std::uint64_t tag, Conn& c)
+{
+    const std::size_t backlog = c.out.size() - c.out_pos;
+    const bool reading = !c.busy && !c.closing && backlog < kMaxBacklog;
+    const std::uint32_t want = (reading ? EPOLLIN : 0u) | (backlog > 0 ? EPOLLOUT : 0u);
+    if (want == c.events)
+        return;
+
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.u64 = tag;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c.fd, &ev) == 0)
+        c.events = want;
+}
+
+void HttpServer::close_conn(std::uint64_t tag)
+{
+    auto it = conns_.find(tag);
+    if (it == conns_.end())
+        return;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    ::close(it->second.fd);
+    conns_.erase(it);
+}
+
+// Closes connections with nothing in flight that sent nothing for idle_timeout_ms.
+void HttpServer::close_idle()
+{
+    const Clock::time_point cutoff = Clock::now() - std::chrono::milliseconds(opt_.idle_timeout_ms);
+    std::vector<std::uint64_t> idle;
+    for (const auto& [tag, c] : conns_) {
+        if (!c.busy && c.out_pos == c.out.size() && c.last_active < cutoff)
+            idle.push_back(tag);
+    }
+    for (const std::uint64_t tag : idle) {
+        close_conn(tag);
+    }
+}
+
+} // namespace
+
+int runHttpServer(ydict::LiveDictionary& live, const HttpOptions& opt)
+{
+    std::uint64_t accepted = 0;
+    {
+        HttpServer server(live, opt);
+        if (!server.start())
+            return 1;
+        server.run();
+        accepted = server.accepted();
+    }
+    if (opt.diagnostics) {
+        std::cerr << "http: served " << accepted << " connections\n";
+    }
+    return 0;
+}
+
+#endif // __linux__
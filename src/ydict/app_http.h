@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ydict/live_dictionary.h"
+#include "ydict/query_log.h"
+#include "ydict/ydict.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Local HTTP endpoint (ydict_app --http <port>)
+ * ---------------------------------------------
+ * Minimal HTTP/1.1 server on 127.0.0.1: GET/HEAD only, keep-alive (and
+ * pipelined requests) by default, Connection: close honoured. One epoll
+ * loop thread owns all connections and hands only complete requests to a
+ * fixed worker pool, so idle keep-alive connections hold no worker. A
+ * connection closes when the client closes it, sends Connection: close, or
+ * stays idle for `idle_timeout_ms`.
+ *
+ *   GET /lookup?word=W              {"word":W,"found":true,"index":N}
+ *   GET /suggest?prefix=P&limit=N   {"prefix":P,"words":[...],"truncated":B}
+ *       [&deadline_ms=D]            (scan stops after D ms, see ydict::QueryBudget)
+ *   GET /render?word=W&format=F     the definition in F (cli, plain, ansi,
+ *                                   html, json; default json), as
+ *                                   text/plain, text/html or application/json
+ *
+ * Misses return 404 with a JSON body; bad parameters 400. Rendering goes
+ * through Dictionary::document(), so repeated words hit the parse cache.
+ * SIGHUP reloads the dictionary files (see LiveDictionary).
+ *
+ * Linux only; elsewhere the mode reports that and fails.
+ */
+struct HttpOptions
+{
+    std::uint16_t port = 0;
+    std::size_t jobs = 0;              // workers; 0 = one per hardware thread
+    int idle_timeout_ms = 5000;        // keep-alive idle limit
+    bool diagnostics = false;
+    ydict::QueryLogWriter* query_log = nullptr;  // record every query (--query-log)
+};
+
+// Returns the process exit code.
+int runHttpServer(ydict::LiveDictionary& live, const HttpOptions& opt);
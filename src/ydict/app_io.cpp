@@ -0,0 +1,127 @@
+#include "ydict/app_io.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static std::FILE* open_std_or_file(const std::string& path, bool write, bool& owned)
+{
+    if (path == "-") {
+        owned = false;
+        std::FILE* f = write ? stdout : stdin;
+#ifdef _WIN32
+        // Bytes in, bytes out: no CRLF translation on the standard streams.
+        _setmode(_fileno(f), _O_BINARY);
+#endif
+        return f;
+    }
+    owned = true;
+    return std::fopen(path.c_str(), write ? "wb" : "rb");
+}
+
+LineReader::LineReader(const std::string& path)
+{
+    f_ = open_std_or_file(path, /*write=*/false, owned_);
+    buf_.resize(64 * 1024);
+}
+
+LineReader::~LineReader()
+{
+    if (f_ && owned_)
+        std::fclose(f_);
+}
+
+bool LineReader::refill()
+{
+    // Keep the unconsumed tail (a partial line) at the front.
+    if (pos_ > 0) {
+        std::memmove(buf_.data(), buf_.data() + pos_, end_ - pos_);
+        end_ -= pos_;
+        pos_ = 0;
+    }
+    if (end_ == buf_.size())
+        buf_.resize(buf_.size() * 2); // line longer than the buffer
+
+    const std::size_t n = std::fread(buf_.data() + end_, 1, buf_.size() - end_, f_);
+    end_ += n;
+    return n > 0;
+}
+
+bool LineReader::next(std::string& line)
+{
+    if (!f_)
+        return false;
+
+    std::size_t scanFrom = pos_;
+    for (;;) {
+        const void* nl = std::memchr(buf_.data() + scanFrom, '\n', end_ - scanFrom);
+        if (nl) {
+            const std::size_t eol = static_cast<std::size_t>(static_cast<const char*>(nl) - buf_.data());
+            line.assign(buf_.data() + pos_, eol - pos_);
+            pos_ = eol + 1;
+            return true;
+        }
+
+        const std::size_t scanned = end_ - pos_;
+        if (!refill()) {
+            if (pos_ == end_)
+                return false;
+            line.assign(buf_.data() + pos_, end_ - pos_); // last line without '\n'
+            pos_ = end_;
+            return true;
+        }
+        scanFrom = pos_ + scanned;
+    }
+}
+
+BufferedWriter::BufferedWriter(const std::string& path, std::size_t bufferBytes)
+    : cap_(bufferBytes)
+{
+    f_ = open_std_or_file(path, /*write=*/true, owned_);
+    buf_.reserve(cap_);
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    flush();
+    if (f_ && owned_)
+        std::fclose(f_);
+}
+
+void BufferedWriter::write(std::string_view s)
+{
+    if (buf_.size() + s.size() > cap_) {
+        flush();
+        if (s.size() >= cap_) {
+            // Large block: skip the copy.
+            if (f_ && std::fwrite(s.data(), 1, s.size(), f_) != s.size())
+                failed_ = true;
+            return;
+        }
+    }
+    buf_.append(s.data(), s.size());
+}
+
+void BufferedWriter::put(char c)
+{
+    if (buf_.size() >= cap_)
+        flush();
+    buf_.push_back(c);
+}
+
+bool BufferedWriter::flush()
+{
+    if (!f_)
+        return false;
+    if (!buf_.empty()) {
+        if (std::fwrite(buf_.data(), 1, buf_.size(), f_) != buf_.size())
+            failed_ = true;
+        buf_.clear();
+    }
+    if (std::fflush(f_) != 0)
+        failed_ = true;
+    return !failed_;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+/*
+ * Buffered line input / block output for the app's bulk modes.
+ * Both wrap a C stdio FILE* and do their own buffering, so a million short
+ * lines cost a handful of read()/write() calls instead of one per line.
+ */
+
+class LineReader {
+public:
+    // path "-" reads stdin.
+    explicit LineReader(const std::string& path);
+    ~LineReader();
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    bool ok() const { return f_ != nullptr; }
+
+    // Next line without its '\n' (a trailing '\r' is kept). False at EOF.
+    bool next(std::string& line);
+
+private:
+    bool refill();
+
+    std::FILE* f_ = nullptr;
+    bool owned_ = false;
+    std::string buf_;
+    std::size_t pos_ = 0;
+    std::size_t end_ = 0;
+};
+
+class BufferedWriter {
+public:
+    // path "-" writes stdout.
+    explicit BufferedWriter(const std::string& path, std::size_t bufferBytes = 1u << 20);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool ok() const { return f_ != nullptr && !failed_; }
+
+    void write(std::string_view s);
+    void put(char c);
+
+    // Hand buffered bytes to the OS. Returns false once any write failed.
+    bool flush();
+
+private:
+    std::FILE* f_ = nullptr;
+    bool owned_ = false;
+    bool failed_ = false;
+    std::string buf_;
+    std::size_t cap_ = 0;
+};
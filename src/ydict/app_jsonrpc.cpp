@@ -0,0 +1,687 @@
+#include "ydict/app_jsonrpc.h"
+#include "ydict/app_io.h"
+#include "ydict/json.h"
+#include "ydict/thread_pool.h"
+#include "ydict/trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kMaxLineBytes = 1u << 20;
+constexpr std::size_t kMaxInFlight = 4096;   // stdin is not read further until requests finish
+constexpr int kMaxJsonDepth = 32;
+
+constexpr int kParseError = -32700;
+constexpr int kInvalidRequest = -32600;
+constexpr int kMethodNotFound = -32601;
+constexpr int kInvalidParams = -32602;
+constexpr int kNotFound = -32001;
+constexpr int kCancelled = -32800;
+
+/*
+ * Minimal JSON reader
+ * -------------------
+ * Just enough for request objects: the full grammar, strings decoded to
+ * UTF-8 (\u escapes incl. surrogate pairs), numbers kept as double plus
+ * their source text so ids can be echoed back verbatim.
+ */
+struct JsonValue
+{
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string str;                                      // String
+    std::string raw;                                      // source text (Number, String)
+    std::vector<JsonValue> items;                         // Array
+    std::vector<std::pair<std::string, JsonValue>> members; // Object
+
+    const JsonValue* get(std::string_view key) const
+    {
+        for (const auto& m : members) {
+            if (m.first == key)
+                return &m.second;
+        }
+        return nullptr;
+    }
+};
+
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : s_(text) {}
+
+    bool parse(JsonValue& out)
+    {
+        if (!value(out, 0))
+            return false;
+        ws();
+        return pos_ == s_.size();
+    }
+
+private:
+    void ws()
+    {
+        while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\t' || s_[pos_] == '\r' || s_[pos_] == '\n'))
+            ++pos_;
+    }
+
+    bool literal(std::string_view word)
+    {
+        if (s_.substr(pos_, word.size()) != word)
+            return false;
+        pos_ += word.size();
+        return true;
+    }
+
+    bool value(JsonValue& v, int depth)
+    {
+        ws();
+        if (pos_ >= s_.size() || depth > kMaxJsonDepth)
+            return false;
+
+        const char c = s_[pos_];
+        if (c == '{') return object(v, depth);
+        if (c == '[') return array(v, depth);
+        if (c == '"') {
+            const std::size_t start = pos_;
+            v.type = JsonValue::Type::String;
+            if (!string(v.str))
+                return false;
+            v.raw.assign(s_.substr(start, pos_ - start));
+            return true;
+        }
+        if (c == 't' || c == 'f') {
+            v.type = JsonValue::Type::Bool;
+            v.boolean = c == 't';
+            return literal(v.boolean ? "true" : "false");
+        }
+        if (c == 'n') {
+            v.type = JsonValue::Type::Null;
+            return literal("null");
+        }
+        return number(v);
+    }
+
+    bool number(JsonValue& v)
+    {
+        const std::size_t start = pos_;
+        auto digits = [&]() {
+            const std::size_t d = pos_;
+            while (pos_ < s_.size() && s_[pos_] >= '0' && s_[pos_] <= '9')
+                ++pos_;
+            return pos_ > d;
+        };
+
+        if (pos_ < s_.size() && s_[pos_] == '-')
+            ++pos_;
+        if (pos_ < s_.size() && s_[pos_] == '0') {
+            ++pos_;
+        } else if (!digits()) {
+            return false;
+        }
+        if (pos_ < s_.size() && s_[pos_] == '.') {
+            ++pos_;
+            if (!digits())
+                return false;
+        }
+        if (pos_ < s_.size() && (s_[pos_] == 'e' || s_[pos_] == 'E')) {
+            ++pos_;
+            if (pos_ < s_.size() && (s_[pos_] == '+' || s_[pos_] == '-'))
+                ++pos_;
+            if (!digits())
+                return false;
+        }
+
+        v.type = JsonValue::Type::Number;
+        v.raw.assign(s_.substr(start, pos_ - start));
+        v.number = std::strtod(v.raw.c_str(), nullptr);
+        return true;
+    }
+
+    bool hex4(unsigned& cp)
+    {
+        if (pos_ + 4 > s_.size())
+            return false;
+        cp = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = s_[pos_++];
+            cp <<= 4;
+            if (c >= '0' && c <= '9') cp |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') cp |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') cp |= static_cast<unsigned>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    static void append_utf8(std::string& out, unsigned cp)
+    {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    bool string(std::string& out)
+    {
+        ++pos_; // opening quote
+        out.clear();
+        while (pos_ < s_.size()) {
+            const char c = s_[pos_++];
+            if (c == '"')
+                return true;
+            if (static_cast<unsigned char>(c) < 0x20)
+                return false;
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (pos_ >= s_.size())
+                return false;
+            switch (s_[pos_++]) {
+            case '"':  out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/':  out.push_back('/'); break;
+            case 'b':  out.push_back('\b'); break;
+            case 'f':  out.push_back('\f'); break;
+            case 'n':  out.push_back('\n'); break;
+            case 'r':  out.push_back('\r'); break;
+            case 't':  out.push_back('\t'); break;
+            case 'u': {
+                unsigned cp = 0;
+                if (!hex4(cp))
+                    return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    unsigned lo = 0;
+                    if (!literal("\\u") || !hex4(lo) || lo < 0xDC00 || lo > 0xDFFF)
+                        return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return false;
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool array(JsonValue& v, int depth)
+    {
+        v.type = JsonValue::Type::Array;
+        ++pos_;
+        ws();
+        if (pos_ < s_.size() && s_[pos_] == ']') {
+            ++pos_;
+            return true;
+        }
+        for (;;) {
+            v.items.emplace_back();
+            if (!value(v.items.back(), depth + 1))
+                return false;
+            ws();
+            if (pos_ >= s_.size())
+                return false;
+            const char c = s_[pos_++];
+            if (c == ']')
+                return true;
+            if (c != ',')
+                return false;
+        }
+    }
+
+    bool object(JsonValue& v, int depth)
+    {
+        v.type = JsonValue::Type::Object;
+        ++pos_;
+        ws();
+        if (pos_ < s_.size() && s_[pos_] == '}') {
+            ++pos_;
+            return true;
+        }
+        for (;;) {
+            ws();
+            if (pos_ >= s_.size() || s_[pos_] != '"')
+                return false;
+            v.members.emplace_back();
+            if (!string(v.members.back().first))
+                return false;
+            ws();
+            if (pos_ >= s_.size() || s_[pos_++] != ':')
+                return false;
+            if (!value(v.members.back().second, depth + 1))
+                return false;
+            ws();
+            if (pos_ >= s_.size())
+                return false;
+            const char c = s_[pos_++];
+            if (c == '}')
+                return true;
+            if (c != ',')
+                return false;
+        }
+    }
+
+    std::string_view s_;
+    std::size_t pos_ = 0;
+};
+
+// Responses: `id` is the request's id as it appeared on the wire ("null" if unknown).
+std::string result_line(const std::string& id, const std::string& result)
+{
+    return "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"result\":" + result + "}\n";
+}
+
+std::string error_line(const std::string& id, int code, std::string_view message)
+{
+    std::string out = "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"error\":{\"code\":" + std::to_string(code) + ",\"message\":";
+    ydict::appendJsonString(out, message);
+    out += "}}\n";
+    return out;
+}
+
+bool string_param(const JsonValue* params, std::string_view key, std::string& out)
+{
+    const JsonValue* v = params ? params->get(key) : nullptr;
+    if (!v || v->type != JsonValue::Type::String)
+        return false;
+    out = v->str;
+    return true;
+}
+
+// Absent -> `fallback`; present but not an integer in [lo, hi] -> false.
+bool int_param(const JsonValue* params, std::string_view key, long lo, long hi, long fallback, long& out)
+{
+    const JsonValue* v = params ? params->get(key) : nullptr;
+    if (!v) {
+        out = fallback;
+        return true;
+    }
+    if (v->type != JsonValue::Type::Number || v->number < static_cast<double>(lo) || v->number > static_cast<double>(hi))
+        return false;
+    out = static_cast<long>(v->number);
+    return static_cast<double>(out) == v->number;
+}
+
+enum class Method { Lookup, Suggest, Fuzzy, Render };
+
+bool parse_method(std::string_view name, Method& m)
+{
+    if (name == "lookup")  { m = Method::Lookup;  return true; }
+    if (name == "suggest") { m = Method::Suggest; return true; }
+    if (name == "fuzzy")   { m = Method::Fuzzy;   return true; }
+    if (name == "render")  { m = Method::Render;  return true; }
+    return false;
+}
+
+const char* trace_name(Method m)
+{
+    switch (m) {
+    case Method::Lookup:  return "jsonrpc.lookup";
+    case Method::Suggest: return "jsonrpc.suggest";
+    case Method::Fuzzy:   return "jsonrpc.fuzzy";
+    case Method::Render:  return "jsonrpc.render";
+    }
+    return "jsonrpc";
+}
+
+// Scan budget for suggest/fuzzy: the optional "deadline_ms", plus the request's cancel flag.
+bool budget_param(const JsonValue* params, const std::atomic<bool>* cancel, ydict::QueryBudget& budget)
+{
+    long ms = 0;
+    if (!int_param(params, "deadline_ms", 0, 60000, 0, ms))
+        return false;
+    budget = ms > 0 ? ydict::QueryBudget::within(std::chrono::milliseconds(ms), cancel)
+                    : ydict::QueryBudget{std::chrono::steady_clock::time_point::max(), cancel};
+    return true;
+}
+
+// Runs one request; returns its response line. `params` may be null; `cancel` stops suggest/fuzzy scans.
+std::string execute(const ydict::Dictionary& dict, Method method, const JsonValue* params, const std::string& id,
+                    ydict::QueryLogWriter* log, const std::atomic<bool>* cancel)
+{
+    ydict::QueryBudget budget;
+    bool truncated = false;
+
+    std::string word;
+    std::string result;
+
+    switch (method) {
+    case Method::Lookup: {
+        if (!string_param(params, "word", word) || word.empty())
+            return error_line(id, kInvalidParams, "missing word");
+        if (log)
+            log->append(ydict::QueryOp::Lookup, word);
+        const int idx = dict.findWord(word);
+        result = "{\"word\":";
+        ydict::appendJsonString(result, word);
+        result += idx >= 0 ? ",\"found\":true,\"index\":" + std::to_string(idx) + "}"
+                           : std::string(",\"found\":false}");
+        return result_line(id, result);
+    }
+
+    case Method::Suggest: {
+        long limit = 0;
+        if (!string_param(params, "prefix", word))
+            return error_line(id, kInvalidParams, "missing prefix");
+        if (!int_param(params, "limit", 1, 1000, 15, limit))
+            return error_line(id, kInvalidParams, "limit must be 1..1000");
+        if (!budget_param(params, cancel, budget))
+            return error_line(id, kInvalidParams, "deadline_ms must be 0..60000");
+        if (log)
+            log->append(ydict::QueryOp::Suggest, word, static_cast<std::uint32_t>(limit));
+        result = "{\"prefix\":";
+        ydict::appendJsonString(result, word);
+        result += ",\"words\":[";
+        bool first = true;
+        for (const int i : dict.suggest(word, static_cast<std::size_t>(limit), budget, &truncated)) {
+            const auto e = dict.wordAt(i);
+            if (!e)
+                continue;
+            if (!first)
+                result.push_back(',');
+            first = false;
+            ydict::appendJsonString(result, e->word);
+        }
+        result += truncated ? "],\"truncated\":true}" : "],\"truncated\":false}";
+        return result_line(id, result);
+    }
+
+    case Method::Fuzzy: {
+        long limit = 0;
+        long maxDistance = 0;
+        if (!string_param(params, "word", word) || word.empty())
+            return error_line(id, kInvalidParams, "missing word");
+        if (!int_param(params, "limit", 1, 1000, 15, limit))
+            return error_line(id, kInvalidParams, "limit must be 1..1000");
+        if (!int_param(params, "max_distance", 0, 3, 2, maxDistance))
+            return error_line(id, kInvalidParams, "max_distance must be 0..3");
+        if (!budget_param(params, cancel, budget))
+            return error_line(id, kInvalidParams, "deadline_ms must be 0..60000");
+        if (log)
+            log->append(ydict::QueryOp::Fuzzy, word, static_cast<std::uint32_t>(limit), 0,
+                        static_cast<std::uint8_t>(maxDistance));
+        result = "{\"word\":";
+        ydict::appendJsonString(result, word);
+        result += ",\"matches\":[";
+        bool first = true;
+        for (const ydict::FuzzyMatch& m :
+             dict.fuzzy(word, static_cast<std::size_t>(limit), static_cast<int>(maxDistance), budget, &truncated)) {
+            const auto e = dict.wordAt(m.index);
+            if (!e)
+                continue;
+            if (!first)
+                result.push_back(',');
+            first = false;
+            result += "{\"word\":";
+            ydict::appendJsonString(result, e->word);
+            result += ",\"distance\":" + std::to_string(m.distance) + "}";
+        }
+        result += truncated ? "],\"truncated\":true}" : "],\"truncated\":false}";
+        return result_line(id, result);
+    }
+
+    case Method::Render: {
+        std::string formatName = "json";
+        if (!string_param(params, "word", word) || word.empty())
+            return error_line(id, kInvalidParams, "missing word");
+        if (params && params->get("format") && !string_param(params, "format", formatName))
+            return error_line(id, kInvalidParams, "format must be a string");
+        ydict::OutputFormat fmt;
+        if (!ydict::parseOutputFormat(formatName, fmt))
+            return error_line(id, kInvalidParams, "unknown format");
+        if (log)
+            log->append(ydict::QueryOp::Render, word, 0, static_cast<std::uint8_t>(fmt));
+
+        const int idx = dict.findWord(word);
+        const auto doc = idx >= 0 ? dict.document(idx) : nullptr;
+        if (!doc)
+            return error_line(id, kNotFound, "not found");
+
+        result = "{\"word\":";
+        ydict::appendJsonString(result, word);
+        result += ",\"format\":";
+        ydict::appendJsonString(result, ydict::outputFormatName(fmt));
+        if (fmt == ydict::OutputFormat::Json) {
+            std::string json = ydict::renderDocument(*doc, fmt);
+            while (!json.empty() && (json.back() == '\n' || json.back() == '\r'))
+                json.pop_back(); // one response per line
+            result += ",\"document\":";
+            result += json;
+        } else {
+            result += ",\"text\":";
+            ydict::appendJsonString(result, ydict::renderDocument(*doc, fmt));
+        }
+        result += "}";
+        return result_line(id, result);
+    }
+    }
+    return error_line(id, kMethodNotFound, "unknown method");
+}
+
+/*
+ * Requests in flight, keyed by their id's wire text. Each entry carries the
+ * cancel flag its worker checks before starting and again before answering.
+ */
+class InFlight {
+public:
+    using Flag = std::shared_ptr<std::atomic<bool>>;
+
+    // Null if `id` is already in flight.
+    Flag add(const std::string& id)
+    {
+        std::unique_lock<std::mutex> lock(mu_);
+        roomCv_.wait(lock, [&] { return map_.size() < kMaxInFlight; });
+        auto [it, inserted] = map_.try_emplace(id);
+        if (!inserted)
+            return nullptr;
+        it->second = std::make_shared<std::atomic<bool>>(false);
+        return it->second;
+    }
+
+    void remove(const std::string& id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            map_.erase(id);
+        }
+        roomCv_.notify_one();
+    }
+
+    bool cancel(const std::string& id)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        const auto it = map_.find(id);
+        if (it == map_.end())
+            return false;
+        it->second->store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::mutex mu_;
+    std::condition_variable roomCv_;
+    std::unordered_map<std::string, Flag> map_;
+};
+
+// stdout is shared by the workers: one response line per locked write.
+class ResponseWriter {
+public:
+    ResponseWriter() : out_("-", 64 * 1024) {}
+
+    bool ok() const { return out_.ok(); }
+
+    void send(std::string_view line)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        out_.write(line);
+        out_.flush(); // a peer is waiting on every answer
+    }
+
+private:
+    std::mutex mu_;
+    BufferedWriter out_;
+};
+
+} // namespace
+
+int runJsonRpc(ydict::LiveDictionary& live, const JsonRpcOptions& opt)
+{
+    LineReader in("-");
+    ResponseWriter out;
+    if (!in.ok() || !out.ok()) {
+        std::cerr << "Cannot open stdin/stdout\n";
+        return 1;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    InFlight inFlight;
+    std::atomic<std::uint64_t> answered{0};
+    std::atomic<std::uint64_t> cancelled{0};
+    std::uint64_t received = 0;
+
+    {
+        ydict::ThreadPool pool(opt.jobs);
+        if (opt.diagnostics) {
+            std::cerr << "jsonrpc on stdin/stdout (" << pool.size() << " workers)\n";
+        }
+
+        std::string line;
+        while (in.next(line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            ++received;
+
+            auto req = std::make_shared<JsonValue>();
+            if (line.size() > kMaxLineBytes) {
+                out.send(error_line("null", kInvalidRequest, "request too large"));
+                continue;
+            }
+            if (!JsonReader(line).parse(*req)) {
+                out.send(error_line("null", kParseError, "parse error"));
+                continue;
+            }
+            // Only an object can be a notification; anything else gets an answer.
+            if (req->type != JsonValue::Type::Object) {
+                out.send(error_line("null", kInvalidRequest, "invalid request"));
+                continue;
+            }
+
+            const JsonValue* idValue = req->get("id");
+            const JsonValue* methodValue = req->get("method");
+            const JsonValue* params = req->get("params");
+            const bool notification = idValue == nullptr;
+            std::string id = "null";
+            if (idValue) {
+                if (idValue->type != JsonValue::Type::Number && idValue->type != JsonValue::Type::String &&
+                    idValue->type != JsonValue::Type::Null) {
+                    out.send(error_line("null", kInvalidRequest, "id must be a number or string"));
+                    continue;
+                }
+                if (idValue->type != JsonValue::Type::Null)
+                    id = idValue->raw;
+            }
+            if (!methodValue || methodValue->type != JsonValue::Type::String ||
+                (params && params->type != JsonValue::Type::Object)) {
+                if (!notification)
+                    out.send(error_line(id, kInvalidRequest, "invalid request"));
+                continue;
+            }
+
+            const std::string& name = methodValue->str;
+            if (name == "cancel" || name == "$/cancelRequest") {
+                const JsonValue* target = params ? params->get("id") : nullptr;
+                if (!target || (target->type != JsonValue::Type::Number && target->type != JsonValue::Type::String)) {
+                    if (!notification)
+                        out.send(error_line(id, kInvalidParams, "missing id"));
+                    continue;
+                }
+                const bool hit = inFlight.cancel(target->raw);
+                if (!notification)
+                    out.send(result_line(id, hit ? "{\"cancelled\":true}" : "{\"cancelled\":false}"));
+                continue;
+            }
+
+            if (name == "reload") {
+                if (notification) {
+                    live.reload();
+                    continue;
+                }
+                // On a worker: the build takes a while, and queries keep running on the old snapshot.
+                pool.submit([&live, &out, &answered, id]() {
+                    const bool ok = live.reloadNow();
+                    out.send(result_line(id, std::string("{\"reloaded\":") + (ok ? "true" : "false") +
+                                                 ",\"generation\":" + std::to_string(live.generation()) + "}"));
+                    ++answered;
+                });
+                continue;
+            }
+
+            Method method;
+            if (!parse_method(name, method)) {
+                if (!notification)
+                    out.send(error_line(id, kMethodNotFound, "unknown method"));
+                continue;
+            }
+            if (notification)
+                continue; // nobody would see the answer
+
+            InFlight::Flag flag = inFlight.add(id);
+            if (!flag) {
+                out.send(error_line(id, kInvalidRequest, "id already in flight"));
+                continue;
+            }
+
+            pool.submit([&live, &opt, &inFlight, &out, &answered, &cancelled, req, method, id, flag]() {
+                ydict::TraceSpan trace(trace_name(method), "request", id);
+                std::string response;
+                if (!flag->load(std::memory_order_relaxed))
+                    response = execute(*live.snapshot(), method, req->get("params"), id, opt.query_log, flag.get());
+                // Re-check: a cancel that arrived while working still wins.
+                if (flag->load(std::memory_order_relaxed)) {
+                    response = error_line(id, kCancelled, "request cancelled");
+                    ++cancelled;
+                }
+                inFlight.remove(id);
+                out.send(response);
+                ++answered;
+            });
+        }
+        // ~ThreadPool: every submitted request is answered before returning.
+    }
+
+    if (opt.diagnostics) {
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cerr << "jsonrpc: " << received << " messages, " << answered.load() << " dispatched, "
+                  << cancelled.load() << " cancelled, " << secs << " s\n";
+    }
+    return out.ok() ? 0 : 1;
+}
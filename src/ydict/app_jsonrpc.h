@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ydict/live_dictionary.h"
+#include "ydict/query_log.h"
+#include "ydict/ydict.h"
+
+#include <cstddef>
+
+/*
+ * JSON-RPC co-process mode (ydict_app --jsonrpc)
+ * ----------------------------------------------
+ * For editors and launchers that keep ydict running as a child process.
+ * Requests are JSON-RPC 2.0 objects, one per stdin line; responses are
+ * written to stdout one per line, in completion order (match them by id).
+ * Work runs on a fixed pool, so a slow render does not hold up lookups.
+ *
+ *   lookup   {"word":W}                            {"word":W,"found":true,"index":N}
+ *   suggest  {"prefix":P,"limit":N}                {"prefix":P,"words":[...],"truncated":B}
+ *   fuzzy    {"word":W,"limit":N,"max_distance":D} {"word":W,"matches":[{"word":..,"distance":..}],
+ *                                                   "truncated":B}
+ *   render   {"word":W,"format":F}                 {"word":W,"format":F,"text":"..."}
+ *                                                  (format json: "document":{...} instead of "text")
+ *   cancel   {"id":X}                              {"cancelled":true|false}
+ *   reload   (none)                                {"reloaded":true|false,"generation":N}
+ *
+ * `cancel` (also accepted as "$/cancelRequest") is meant for typeahead: when
+ * a newer query supersedes an older one, the client cancels the older id.
+ * A request that has not finished yet is answered with error -32800 instead
+ * of its result; cancelling an unknown or finished id is a no-op.
+ *
+ * suggest and fuzzy also take "deadline_ms" (0 = none): the scan stops when
+ * it passes and answers with what it found, "truncated":true (see
+ * ydict::QueryBudget). Cancelling one of them stops its scan too.
+ *
+ * `reload` re-reads the dictionary files (see LiveDictionary) and answers
+ * once the new snapshot is live; requests already running finish on the
+ * old one. A failed reload keeps the current dictionary.
+ *
+ * Errors use the standard codes: -32700 parse error, -32600 invalid request
+ * (also: id already in flight), -32601 unknown method, -32602 bad params;
+ * a miss on lookup/render is -32001 "not found". Requests without an id are
+ * notifications and get no response. The mode ends at EOF on stdin, after
+ * every outstanding request has been answered.
+ */
+struct JsonRpcOptions
+{
+    std::size_t jobs = 0;       // workers; 0 = one per hardware thread
+    bool diagnostics = false;   // summary line on stderr
+    ydict::QueryLogWriter* query_log = nullptr;  // record every query (--query-log)
+};
+
+// Returns the process exit code.
+int runJsonRpc(ydict::LiveDictionary& live, const JsonRpcOptions& opt);
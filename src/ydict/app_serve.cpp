@@ -0,0 +1,754 @@
+#include "ydict/app_serve.h"
+
+#include <iostream>
+#include <string_view>
+
+bool parseServeOp(std::string_view name, ServeOp& op)
+{
+    if (name == "lookup")  { op = ServeOp::Lookup;  return true; }
+    if (name == "suggest") { op = ServeOp::Suggest; return true; }
+    if (name == "render")  { op = ServeOp::Render;  return true; }
+    return false;
+}
+
+#ifndef __linux__
+
+int runServer(ydict::LiveDictionary&, const ServeOptions&)
+{
+    std::cerr << "--serve is only supported on Linux\n";
+    return 1;
+}
+
+int runClient(const ClientOptions&)
+{
+    std::cerr << "--client is only supported on Linux\n";
+    return 1;
+}
+
+#else
+
+#include "ydict/app_io.h"
+#include "ydict/thread_pool.h"
+#include "ydict/trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::uint32_t kMaxFrame = 1u << 20;       // request payload cap
+constexpr std::size_t kRequestHeader = 4 + 4 + 1 + 1 + 2;
+constexpr std::size_t kResponseHeader = 4 + 4 + 1;
+constexpr std::size_t kMaxBacklog = 8u << 20;       // stop reading while this much output is queued
+constexpr std::size_t kRenderReserve = 64u << 10;   // backlog charged for each render still on the pool
+
+enum : std::uint8_t { kStatusOk = 0, kStatusNotFound = 1, kStatusBadRequest = 2 };
+
+// epoll tags below this are fixed descriptors; connections count up from it.
+enum : std::uint64_t { kTagListen = 1, kTagWake = 2, kTagSignal = 3, kFirstConn = 16 };
+
+void put_u16(std::string& out, std::uint16_t v)
+{
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>(v >> 8));
+}
+
+void put_u32(std::string& out, std::uint32_t v)
+{
+    for (int k = 0; k < 4; ++k) {
+        out.push_back(static_cast<char>((v >> (8 * k)) & 0xFF));
+    }
+}
+
+std::uint16_t get_u16(const char* p)
+{
+    const auto* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<std::uint16_t>(b[0] | (b[1] << 8));
+}
+
+std::uint32_t get_u32(const char* p)
+{
+    const auto* b = reinterpret_cast<const unsigned char*>(p);
+    return std::uint32_t(b[0]) | (std::uint32_t(b[1]) << 8) |
+           (std::uint32_t(b[2]) << 16) | (std::uint32_t(b[3]) << 24);
+}
+
+void append_response(std::string& out, std::uint32_t id, std::uint8_t status, std::string_view body)
+{
+    put_u32(out, static_cast<std::uint32_t>(4 + 1 + body.size()));
+    put_u32(out, id);
+    out.push_back(static_cast<char>(status));
+    out.append(body.data(), body.size());
+}
+
+bool valid_format(std::uint8_t f)
+{
+    return f <= static_cast<std::uint8_t>(ydict::OutputFormat::Json);
+}
+
+std::uint8_t run_cheap_op(const ydict::Dictionary& dict, ServeOp op, std::uint16_t limit,
+                          std::string_view key, std::string& body)
+{
+    if (op == ServeOp::Lookup) {
+        const int idx = dict.findWord(key);
+        if (idx < 0)
+            return kStatusNotFound;
+        body = std::to_string(idx);
+        return kStatusOk;
+    }
+
+    // Suggest
+    const std::vector<int> hits = dict.suggest(key, limit);
+    for (const int i : hits) {
+        const auto e = dict.wordAt(i);
+        if (!e)
+            continue;
+        if (!body.empty())
+            body.push_back('\n');
+        body += e->word;
+    }
+    return hits.empty() ? kStatusNotFound : kStatusOk;
+}
+
+std::uint8_t run_render(const ydict::Dictionary& dict, ydict::OutputFormat fmt,
+                        std::string_view key, std::string& body)
+{
+    const int idx = dict.findWord(key);
+    if (idx < 0)
+        return kStatusNotFound;
+    const std::string rtf = dict.readRtf(idx);
+    if (rtf.empty())
+        return kStatusNotFound;
+    body = ydict::renderRtf(rtf, fmt);
+    return kStatusOk;
+}
+
+bool make_address(const std::string& path, sockaddr_un& addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+/*
+ * Server
+ * ------
+ * Connections are keyed by a never-reused 64-bit tag (also the epoll data),
+ * so a worker finishing after its connection closed just has its response
+ * dropped instead of landing on a new connection with the same fd.
+ */
+class Server {
+public:
+    Server(ydict::LiveDictionary& live, const ServeOptions& opt)
+        : live_(live), opt_(opt) {}
+
+    ~Server();
+
+    bool start();
+    void run();
+
+private:
+    struct Conn
+    {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        std::size_t out_pos = 0;
+        std::uint32_t events = 0;
+        std::size_t renders = 0;    // submitted to the pool, not yet drained back
+    };
+
+    // Unsent output plus what the renders in flight will add: reading stops above kMaxBacklog.
+    static std::size_t backlog(const Conn& c) { return c.out.size() - c.out_pos + c.renders * kRenderReserve; }
+
+    struct Completion
+    {
+        std::uint64_t conn = 0;
+        std::string frame;
+    };
+
+    bool add_fd(int fd, std::uint64_t tag, std::uint32_t events);
+    void accept_all();
+    void on_readable(std::uint64_t tag);
+    void parse_frames(std::uint64_t tag, Conn& c);
+    void flush(std::uint64_t tag, Conn& c);
+    void update_interest(std::uint64_t tag, Conn& c);
+    void close_conn(std::uint64_t tag);
+    void drain_completions();
+    void post(std::uint64_t tag, std::string frame);
+
+    ydict::LiveDictionary& live_;
+    ServeOptions opt_;
+    std::unique_ptr<ydict::ThreadPool> pool_;
+
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    int signal_fd_ = -1;
+    bool bound_ = false;
+
+    std::unordered_map<std::uint64_t, Conn> conns_;
+    std::uint64_t next_tag_ = kFirstConn;
+
+    std::mutex done_mu_;
+    std::vector<Completion> done_;   // filled by workers, drained by the loop
+
+    std::uint64_t requests_ = 0;
+};
+
+Server::~Server()
+{
+    // Finish in-flight renders first: they post to wake_fd_ and done_.
+    pool_.reset();
+
+    for (auto& [tag, c] : conns_) {
+        ::close(c.fd);
+    }
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    if (epoll_fd_ >= 0)  ::close(epoll_fd_);
+    if (wake_fd_ >= 0)   ::close(wake_fd_);
+    if (signal_fd_ >= 0) ::close(signal_fd_);
+    if (bound_)
+        ::unlink(opt_.socket_path.c_str());
+}
+
+bool Server::add_fd(int fd, std::uint64_t tag, std::uint32_t events)
+{
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = tag;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool Server::start()
+{
+    sockaddr_un addr;
+    if (!make_address(opt_.socket_path, addr)) {
+        std::cerr << "Invalid socket path: " << opt_.socket_path << "\n";
+        return false;
+    }
+
+    // A leftover socket file from a dead server is replaced; a live one is not.
+    {
+        const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe >= 0) {
+            const bool live = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+            const int err = errno;
+            ::close(probe);
+            if (live) {
+                std::cerr << "Another server is listening on " << opt_.socket_path << "\n";
+                return false;
+            }
+            if (err == ECONNREFUSED)
+                ::unlink(opt_.socket_path.c_str());
+        }
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0 ||
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "Cannot bind " << opt_.socket_path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    bound_ = true;
+    if (::listen(listen_fd_, SOMAXCONN) != 0) {
+        std::cerr << "listen() failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // SIGINT/SIGTERM arrive through the event loop, so shutdown unlinks the socket;
+    // SIGHUP reloads the dictionary files.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    sigdelset(&mask, SIGPIPE);
+
+    // Workers inherit the blocked mask, so the signals only reach signal_fd_.
+    pool_ = std::make_unique<ydict::ThreadPool>(opt_.jobs);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0 || signal_fd_ < 0 ||
+        !add_fd(listen_fd_, kTagListen, EPOLLIN) ||
+        !add_fd(wake_fd_, kTagWake, EPOLLIN) ||
+        !add_fd(signal_fd_, kTagSignal, EPOLLIN)) {
+        std::cerr << "epoll setup failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+void Server::run()
+{
+    if (opt_.diagnostics) {
+        std::cerr << "serving on " << opt_.socket_path << " (" << pool_->size() << " render workers)\n";
+    }
+
+    std::vector<epoll_event> events(256);
+    for (;;) {
+        const int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << "\n";
+            return;
+        }
+
+        for (int k = 0; k < n; ++k) {
+            const std::uint64_t tag = events[k].data.u64;
+            const std::uint32_t ev = events[k].events;
+
+            if (tag == kTagListen) {
+                accept_all();
+                continue;
+            }
+            if (tag == kTagWake) {
+                drain_completions();
+                continue;
+            }
+            if (tag == kTagSignal) {
+                signalfd_siginfo si;
+                bool hup = false, stop = false;
+                while (::read(signal_fd_, &si, sizeof(si)) == sizeof(si)) {
+                    (si.ssi_signo == SIGHUP ? hup : stop) = true;
+                }
+                if (stop) {
+                    if (opt_.diagnostics)
+                        std::cerr << "shutting down after " << requests_ << " requests\n";
+                    return;
+                }
+                if (hup)
+                    live_.reload();
+                continue;
+            }
+
+            auto it = conns_.find(tag);
+            if (it == conns_.end())
+                continue;
+            if (ev & (EPOLLERR | EPOLLHUP)) {
+                close_conn(tag);
+                continue;
+            }
+            if (ev & EPOLLOUT) {
+                flush(tag, it->second);
+                // Output drained: frames held back by the backlog limit can run now.
+                it = conns_.find(tag);
+                if (it != conns_.end() && !it->second.in.empty() && backlog(it->second) < kMaxBacklog)
+                    parse_frames(tag, it->second);
+            }
+            if ((ev & EPOLLIN) && conns_.count(tag))
+                on_readable(tag);
+        }
+    }
+}
+
+void Server::accept_all()
+{
+    for (;;) {
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return; // EAGAIN, or a transient error: keep serving
+        const std::uint64_t tag = next_tag_++;
+        Conn& c = conns_[tag];
+        c.fd = fd;
+        c.events = EPOLLIN;
+        if (!add_fd(fd, tag, c.events))
+            close_conn(tag);
+    }
+}
+
+void Server::on_readable(std::uint64_t tag)
+{
+    Conn& c = conns_[tag];
+
+    char buf[64 * 1024];
+    const ssize_t r = ::read(c.fd, buf, sizeof(buf));
+    if (r == 0 || (r < 0 && errno != EAGAIN && errno != EINTR)) {
+        close_conn(tag);
+        return;
+    }
+    if (r < 0)
+        return;
+
+    c.in.append(buf, static_cast<std::size_t>(r));
+    parse_frames(tag, c);
+}
+
+void Server::parse_frames(std::uint64_t tag, Conn& c)
+{
+    std::size_t pos = 0;
+    // Frames left in `in` once the backlog is full wait for drain_completions().
+    while (c.in.size() - pos >= 4 && backlog(c) < kMaxBacklog) {
+        const std::uint32_t len = get_u32(c.in.data() + pos);
+        if (len < kRequestHeader - 4 || len > kMaxFrame) {
+            close_conn(tag); // not our protocol; no way to resync
+            return;
+        }
+        if (c.in.size() - pos < 4 + std::size_t(len))
+            break;
+
+        const char* p = c.in.data() + pos + 4;
+        const std::uint32_t id = get_u32(p);
+        const auto op = static_cast<ServeOp>(static_cast<std::uint8_t>(p[4]));
+        const auto fmt = static_cast<std::uint8_t>(p[5]);
+        const std::uint16_t limit = get_u16(p + 6);
+        const std::string_view key(p + 8, len - 8);
+        pos += 4 + std::size_t(len);
+        ++requests_;
+
+        // Each request runs start to finish on the snapshot current when it was parsed.
+        std::shared_ptr<const ydict::Dictionary> dict = live_.snapshot();
+
+        if (opt_.query_log) {
+            switch (op) {
+            case ServeOp::Lookup:  opt_.query_log->append(ydict::QueryOp::Lookup, key); break;
+            case ServeOp::Suggest: opt_.query_log->append(ydict::QueryOp::Suggest, key, limit); break;
+            case ServeOp::Render:  opt_.query_log->append(ydict::QueryOp::RenderDirect, key, 0, fmt); break;
+            default: break;
+            }
+        }
+
+        switch (op) {
+        case ServeOp::Lookup:
+        case ServeOp::Suggest: {
+            ydict::TraceSpan trace(op == ServeOp::Lookup ? "serve.lookup" : "serve.suggest", "request", key);
+            std::string body;
+            const std::uint8_t status = run_cheap_op(*dict, op, limit, key, body);
+            append_response(c.out, id, status, body);
+            break;
+        }
+        case ServeOp::Render: {
+            if (!valid_format(fmt)) {
+                append_response(c.out, id, kStatusBadRequest, {});
+                break;
+            }
+            ++c.renders;
+            pool_->submit([this, dict = std::move(dict), tag, id, fmt, word = std::string(key)]() {
+                ydict::TraceSpan trace("serve.render", "request", word);
+                std::string body;
+                const std::uint8_t status = run_render(*dict, static_cast<ydict::OutputFormat>(fmt), word, body);
+                std::string frame;
+                frame.reserve(kResponseHeader + body.size());
+                append_response(frame, id, status, body);
+                post(tag, std::move(frame));
+            });
+            break;
+        }
+        default:
+            append_response(c.out, id, kStatusBadRequest, {});
+            break;
+        }
+    }
+    c.in.erase(0, pos);
+
+    flush(tag, c);
+}
+
+void Server::post(std::uint64_t tag, std::string frame)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(done_mu_);
+        wake = done_.empty();
+        done_.push_back(Completion{tag, std::move(frame)});
+    }
+    if (wake) {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const ssize_t w = ::write(wake_fd_, &one, sizeof(one));
+    }
+}
+
+void Server::drain_completions()
+{
+    std::uint64_t counter = 0;
+    [[maybe_unused]] const ssize_t r = ::read(wake_fd_, &counter, sizeof(counter));
+
+    std::vector<Completion> batch;
+    {
+        std::lock_guard<std::mutex> lock(done_mu_);
+        batch.swap(done_);
+    }
+
+    std::vector<std::uint64_t> touched;
+    for (Completion& d : batch) {
+        auto it = conns_.find(d.conn);
+        if (it == conns_.end())
+            continue; // client went away
+        Conn& c = it->second;
+        --c.renders;
+        c.out += d.frame;
+        touched.push_back(d.conn);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (const std::uint64_t tag : touched) {
+        auto it = conns_.find(tag);
+        if (it == conns_.end())
+            continue;
+        // Frames held back while the backlog was full, or just the send and read interest.
+        if (!it->second.in.empty())
+            parse_frames(tag, it->second);
+        else
+            flush(tag, it->second);
+    }
+}
+
+void Server::flush(std::uint64_t tag, Conn& c)
+{
+    while (c.out_pos < c.out.size()) {
+        const ssize_t w = ::send(c.fd, c.out.data() + c.out_pos, c.out.size() - c.out_pos, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                break;
+            close_conn(tag);
+            return;
+        }
+        c.out_pos += static_cast<std::size_t>(w);
+    }
+    if (c.out_pos == c.out.size()) {
+        c.out.clear();
+        c.out_pos = 0;
+    } else if (c.out_pos > (1u << 20)) {
+        c.out.erase(0, c.out_pos);
+        c.out_pos = 0;
+    }
+    update_interest(tag, c);
+}
+
+void Server::update_interest(std::uint64_t tag, Conn& c)
+{
+    const bool unsent = c.out.size() > c.out_pos;
+    const std::uint32_t want = (backlog(c) < kMaxBacklog ? EPOLLIN : 0u) | (unsent ? EPOLLOUT : 0u);
+    if (want == c.events)
+        return;
+
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.u64 = tag;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c.fd, &ev) == 0)
+        c.events = want;
+}
+
+void Server::close_conn(std::uint64_t tag)
+{
+    auto it = conns_.find(tag);
+    if (it == conns_.end())
+        return;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    ::close(it->second.fd);
+    conns_.erase(it);
+}
+
+// ---- client ----
+
+bool write_all(int fd, const char* p, std::size_t n)
+{
+    while (n > 0) {
+        const ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+struct Response
+{
+    std::uint32_t id = 0;
+    std::uint8_t status = 0;
+    std::string body;
+};
+
+// Buffered frame reader for the blocking client socket.
+class ResponseReader {
+public:
+    explicit ResponseReader(int fd) : fd_(fd) {}
+
+    bool next(Response& r)
+    {
+        for (;;) {
+            if (buf_.size() - pos_ >= 4) {
+                const std::uint32_t len = get_u32(buf_.data() + pos_);
+                if (len < kResponseHeader - 4)
+                    return false;
+                if (buf_.size() - pos_ >= 4 + std::size_t(len)) {
+                    const char* p = buf_.data() + pos_ + 4;
+                    r.id = get_u32(p);
+                    r.status = static_cast<std::uint8_t>(p[4]);
+                    r.body.assign(p + 5, len - 5);
+                    pos_ += 4 + std::size_t(len);
+                    return true;
+                }
+            }
+            if (pos_ > 0) {
+                buf_.erase(0, pos_);
+                pos_ = 0;
+            }
+            char tmp[64 * 1024];
+            const ssize_t n = ::read(fd_, tmp, sizeof(tmp));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            buf_.append(tmp, static_cast<std::size_t>(n));
+        }
+    }
+
+private:
+    int fd_;
+    std::string buf_;
+    std::size_t pos_ = 0;
+};
+
+void append_request(std::string& out, std::uint32_t id, const ClientOptions& opt, std::string_view key)
+{
+    put_u32(out, static_cast<std::uint32_t>(kRequestHeader - 4 + key.size()));
+    put_u32(out, id);
+    out.push_back(static_cast<char>(opt.op));
+    out.push_back(static_cast<char>(opt.format));
+    put_u16(out, opt.limit);
+    out.append(key.data(), key.size());
+}
+
+// Same record shape as --batch: body ending in '\n', or the not-found line, then the separator.
+void write_record(BufferedWriter& out, std::string_view key, const Response& r, std::string_view separator)
+{
+    if (r.status == kStatusOk) {
+        out.write(r.body);
+        if (r.body.empty() || r.body.back() != '\n')
+            out.put('\n');
+    } else {
+        out.write("word=\"");
+        out.write(key);
+        out.write(r.status == kStatusNotFound ? "\" NOT FOUND\n" : "\" BAD REQUEST\n");
+    }
+    out.write(separator);
+}
+
+} // namespace
+
+int runServer(ydict::LiveDictionary& live, const ServeOptions& opt)
+{
+    Server server(live, opt);
+    if (!server.start())
+        return 1;
+    server.run();
+    return 0;
+}
+
+int runClient(const ClientOptions& opt)
+{
+    sockaddr_un addr;
+    if (!make_address(opt.socket_path, addr)) {
+        std::cerr << "Invalid socket path: " << opt.socket_path << "\n";
+        return 1;
+    }
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "Cannot connect to " << opt.socket_path << ": " << std::strerror(errno) << "\n";
+        if (fd >= 0)
+            ::close(fd);
+        return 1;
+    }
+
+    std::vector<std::string> keys;
+    if (!opt.word.empty()) {
+        keys.push_back(opt.word);
+    } else {
+        LineReader in("-");
+        std::string line;
+        auto isWs = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+        while (in.next(line)) {
+            std::string_view q = line;
+            while (!q.empty() && isWs(q.front())) q.remove_prefix(1);
+            while (!q.empty() && isWs(q.back())) q.remove_suffix(1);
+            if (!q.empty())
+                keys.emplace_back(q);
+        }
+    }
+
+    BufferedWriter out("-");
+    ResponseReader reader(fd);
+
+    // Pipeline in windows: send a window of requests, then collect its responses by id.
+    constexpr std::size_t kWindow = 256;
+    std::vector<Response> window;
+    std::size_t misses = 0;
+    bool ok = true;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t base = 0; base < keys.size() && ok; base += kWindow) {
+        const std::size_t n = std::min(kWindow, keys.size() - base);
+
+        std::string frames;
+        for (std::size_t i = 0; i < n; ++i) {
+            append_request(frames, static_cast<std::uint32_t>(base + i), opt, keys[base + i]);
+        }
+        if (!write_all(fd, frames.data(), frames.size())) {
+            ok = false;
+            break;
+        }
+
+        window.assign(n, Response{});
+        for (std::size_t got = 0; got < n; ++got) {
+            Response r;
+            if (!reader.next(r) || r.id < base || r.id >= base + n) {
+                ok = false;
+                break;
+            }
+            window[r.id - base] = std::move(r);
+        }
+        if (!ok)
+            break;
+
+        for (std::size_t i = 0; i < n; ++i) {
+            if (window[i].status != kStatusOk)
+                ++misses;
+            write_record(out, keys[base + i], window[i], opt.separator);
+        }
+    }
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    ::close(fd);
+    out.flush();
+
+    if (!ok) {
+        std::cerr << "Connection to " << opt.socket_path << " failed mid-request\n";
+        return 1;
+    }
+    if (opt.diagnostics && !keys.empty()) {
+        std::cerr << "client: " << keys.size() << " requests, " << misses << " not found, "
+                  << us << " us total, " << us / static_cast<double>(keys.size()) << " us/request\n";
+    }
+    return (opt.word.empty() || misses == 0) ? 0 : 1;
+}
+
+#endif // __linux__
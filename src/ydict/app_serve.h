@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ydict/live_dictionary.h"
+#include "ydict/query_log.h"
+#include "ydict/ydict.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Lookup daemon (ydict_app --serve <socket>) and its client (--client)
+ * --------------------------------------------------------------------
+ * The server loads the dictionary once and answers requests on an AF_UNIX
+ * stream socket: one epoll loop thread does all socket I/O and the cheap
+ * ops (lookup, suggest) inline; rendering goes to a fixed worker pool.
+ *
+ * Wire format (all integers little-endian), any number of frames in flight
+ * per connection (pipelining):
+ *
+ *   request:  u32 len | u32 id | u8 op | u8 format | u16 limit | key bytes
+ *   response: u32 len | u32 id | u8 status | body bytes
+ *
+ * `len` counts the bytes after itself (request frames are capped at 1 MiB).
+ * Responses carry the request's id and may arrive out of order.
+ *
+ *   op 1 lookup   key = word    body = entry index (decimal)
+ *   op 2 suggest  key = prefix  body = up to `limit` words, '\n'-separated
+ *   op 3 render   key = word    body = definition rendered in `format`
+ *                               (OutputFormat value: 0 cli .. 4 json)
+ *
+ *   status 0 ok, 1 not found, 2 bad request
+ *
+ * SIGHUP reloads the dictionary files (see LiveDictionary); requests
+ * already in flight finish on the snapshot they started with.
+ *
+ * Linux only (epoll); elsewhere both modes report that and fail.
+ */
+
+enum class ServeOp : std::uint8_t {
+    Lookup = 1,
+    Suggest = 2,
+    Render = 3,
+};
+
+struct ServeOptions
+{
+    std::string socket_path;
+    std::size_t jobs = 0;       // render workers; 0 = one per hardware thread
+    bool diagnostics = false;
+    ydict::QueryLogWriter* query_log = nullptr;  // record every query (--query-log)
+};
+
+struct ClientOptions
+{
+    std::string socket_path;
+    ServeOp op = ServeOp::Render;
+    ydict::OutputFormat format = ydict::OutputFormat::Cli;
+    std::uint16_t limit = 15;   // suggest
+    std::string word;           // empty: one query per stdin line, pipelined
+    std::string separator = "\n"; // written after every record, as in --batch
+    bool diagnostics = false;   // timing summary on stderr
+};
+
+bool parseServeOp(std::string_view name, ServeOp& op);
+
+// Both return the process exit code.
+int runServer(ydict::LiveDictionary& live, const ServeOptions& opt);
+int runClient(const ClientOptions& opt);
@@ -0,0 +1,258 @@
+#include "ydict/app_validate.h"
+#include "ydict/app_io.h"
+#include "ydict/thread_pool.h"
+#include "ydict/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+static constexpr std::size_t kChunkEntries = 64;
+static constexpr std::size_t kExamples = 10;       // entries listed per problem
+static constexpr std::size_t kTopWords = 40;       // unknown control words listed
+static constexpr std::size_t kStatusCount = static_cast<std::size_t>(ydict::DefinitionStatus::ReadError) + 1;
+
+enum Problem : std::size_t { RecordError, Oversized, EmptyRender, Unbalanced, UnmappedPhonetic, UnknownWords,
+                             kProblemCount };
+
+static const char* problem_name(std::size_t p)
+{
+    switch (p) {
+    case RecordError:      return "unreadable record";
+    case Oversized:        return "oversized";
+    case EmptyRender:      return "empty output";
+    case Unbalanced:       return "unbalanced groups";
+    case UnmappedPhonetic: return "unmapped phonetic";
+    case UnknownWords:     return "unknown control words";
+    }
+    return "?";
+}
+
+// Findings for a range of entries; chunks tally separately and merge at the end.
+struct ValidateTally
+{
+    std::uint64_t status[kStatusCount] = {};
+    std::uint64_t entries[kProblemCount] = {};      // entries showing each problem
+    std::vector<int> examples[kProblemCount];       // their lowest indices, at most kExamples
+    std::uint64_t rtf_bytes = 0;
+    std::uint32_t largest = 0;
+    int largest_index = -1;
+    ydict::RtfLint lint;
+
+    void note(Problem p, int idx)
+    {
+        ++entries[p];
+        examples[p].push_back(idx);
+    }
+
+    void merge(ValidateTally& other)
+    {
+        for (std::size_t s = 0; s < kStatusCount; ++s) {
+            status[s] += other.status[s];
+        }
+        for (std::size_t p = 0; p < kProblemCount; ++p) {
+            entries[p] += other.entries[p];
+            examples[p].insert(examples[p].end(), other.examples[p].begin(), other.examples[p].end());
+            std::sort(examples[p].begin(), examples[p].end());
+            if (examples[p].size() > kExamples)
+                examples[p].resize(kExamples);
+        }
+        rtf_bytes += other.rtf_bytes;
+        if (other.largest > largest || (other.largest == largest && other.largest_index < largest_index)) {
+            largest = other.largest;
+            largest_index = other.largest_index;
+        }
+        lint.merge(other.lint);
+    }
+};
+
+static void validate_entry(const ydict::Dictionary& dict, const ValidateOptions& opt, int idx, ValidateTally& t)
+{
+    std::uint32_t len = 0;
+    ydict::DefinitionStatus st = dict.checkDefinition(idx, &len);
+    std::string rtf;
+    if (st == ydict::DefinitionStatus::Ok) {
+        rtf = dict.readRtf(idx);
+        if (rtf.size() != len)
+            st = ydict::DefinitionStatus::ReadError;
+    }
+    ++t.status[static_cast<std::size_t>(st)];
+    if (st != ydict::DefinitionStatus::Ok) {
+        t.note(RecordError, idx);
+        return;
+    }
+
+    t.rtf_bytes += len;
+    if (len > t.largest || t.largest_index < 0) {
+        t.largest = len;
+        t.largest_index = idx;
+    }
+    if (len > opt.oversized_bytes)
+        t.note(Oversized, idx);
+
+    const ydict::RtfLintCounts c = ydict::lintRtf(rtf, t.lint);
+    if (c.unmatched_closes > 0 || c.unclosed_groups > 0)
+        t.note(Unbalanced, idx);
+    if (c.unmapped_phonetic > 0)
+        t.note(UnmappedPhonetic, idx);
+    if (c.unknown_words > 0)
+        t.note(UnknownWords, idx);
+
+    if (ydict::parseDocument(rtf).empty())
+        t.note(EmptyRender, idx);
+}
+
+static std::string entry_label(const ydict::Dictionary& dict, int idx)
+{
+    const auto e = dict.wordAt(idx);
+    return "#" + std::to_string(idx) + " \"" + std::string(e ? e->word : std::string_view()) + "\"";
+}
+
+static void write_report(BufferedWriter& out, const ydict::Dictionary& dict, const ValidateOptions& opt,
+                         const ValidateTally& t, std::size_t jobs, double ms)
+{
+    char line[256];
+    auto row = [&](const char* name, std::uint64_t n, const char* note = "") {
+        std::snprintf(line, sizeof(line), "  %-26s %10llu%s\n", name, static_cast<unsigned long long>(n), note);
+        out.write(line);
+    };
+
+    std::snprintf(line, sizeof(line), "validate: %d entries, %llu RTF bytes, %zu job(s), %.1f ms\n",
+                  dict.wordCount(), static_cast<unsigned long long>(t.rtf_bytes), jobs, ms);
+    out.write(line);
+
+    out.write("\nrecords\n");
+    for (std::size_t s = 0; s < kStatusCount; ++s) {
+        const auto st = static_cast<ydict::DefinitionStatus>(s);
+        if (st != ydict::DefinitionStatus::BadIndex)
+            row(ydict::definitionStatusName(st), t.status[s]);
+    }
+    std::snprintf(line, sizeof(line), "oversized (> %u B)", static_cast<unsigned>(opt.oversized_bytes));
+    const std::string oversizedName = line;
+    row(oversizedName.c_str(), t.entries[Oversized]);
+    if (t.largest_index >= 0) {
+        std::snprintf(line, sizeof(line), "  largest                    %10u B  ", static_cast<unsigned>(t.largest));
+        out.write(line);
+        out.write(entry_label(dict, t.largest_index));
+        out.put('\n');
+    }
+
+    const ydict::RtfLintCounts& c = t.lint.counts;
+    out.write("\nrender\n");
+    row("empty output", t.entries[EmptyRender], " entries");
+    std::snprintf(line, sizeof(line), " entries (%llu unmatched '}', %llu unclosed '{')",
+                  static_cast<unsigned long long>(c.unmatched_closes), static_cast<unsigned long long>(c.unclosed_groups));
+    const std::string unbalancedNote = line;
+    row("unbalanced groups", t.entries[Unbalanced], unbalancedNote.c_str());
+
+    std::snprintf(line, sizeof(line), " bytes in %llu entries", static_cast<unsigned long long>(t.entries[UnmappedPhonetic]));
+    const std::string unmappedNote = line;
+    row("unmapped phonetic", c.unmapped_phonetic, unmappedNote.c_str());
+    for (std::size_t slot = 0; slot < 32; ++slot) {
+        if (t.lint.unmapped_phonetic_by_slot[slot] == 0)
+            continue;
+        std::snprintf(line, sizeof(line), "    slot 0x%02X               %10llu\n", static_cast<unsigned>(0x80 + slot),
+                      static_cast<unsigned long long>(t.lint.unmapped_phonetic_by_slot[slot]));
+        out.write(line);
+    }
+
+    std::vector<std::pair<std::string, std::uint64_t>> words(t.lint.unknown_words.begin(), t.lint.unknown_words.end());
+    std::sort(words.begin(), words.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    std::snprintf(line, sizeof(line), " occurrences of %zu words in %llu entries", words.size(),
+                  static_cast<unsigned long long>(t.entries[UnknownWords]));
+    const std::string unknownNote = line;
+    row("unknown control words", c.unknown_words, unknownNote.c_str());
+    for (std::size_t i = 0; i < words.size() && i < kTopWords; ++i) {
+        std::snprintf(line, sizeof(line), "    \\%-22.64s %10llu\n", words[i].first.c_str(),
+                      static_cast<unsigned long long>(words[i].second));
+        out.write(line);
+    }
+    if (words.size() > kTopWords) {
+        std::snprintf(line, sizeof(line), "    ... %zu more\n", words.size() - kTopWords);
+        out.write(line);
+    }
+
+    bool header = false;
+    for (std::size_t p = 0; p < kProblemCount; ++p) {
+        if (t.examples[p].empty())
+            continue;
+        if (!header) {
+            std::snprintf(line, sizeof(line), "\nexamples (first %zu by index)\n", kExamples);
+            out.write(line);
+            header = true;
+        }
+        out.write("  ");
+        out.write(problem_name(p));
+        out.write(":\n");
+        for (const int idx : t.examples[p]) {
+            out.write("    ");
+            out.write(entry_label(dict, idx));
+            if (p == RecordError) {
+                out.write(" (");
+                out.write(ydict::definitionStatusName(dict.checkDefinition(idx)));
+                out.put(')');
+            }
+            out.put('\n');
+        }
+    }
+}
+
+int runValidate(const ydict::Dictionary& dict, const ValidateOptions& opt)
+{
+    BufferedWriter out(opt.report);
+    if (!out.ok()) {
+        std::cerr << "Cannot open validation report: " << opt.report << "\n";
+        return 1;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::vector<int> order = dict.entriesInDatOrder();
+
+    // As in batch mode, the calling thread works too; the pool only adds helpers.
+    const std::size_t jobs = opt.jobs == 0 ? ydict::ThreadPool::defaultThreads() : opt.jobs;
+    std::unique_ptr<ydict::ThreadPool> pool;
+    if (jobs > 1)
+        pool = std::make_unique<ydict::ThreadPool>(jobs - 1);
+
+    ValidateTally total;
+    std::mutex totalMu;
+    const std::size_t chunks = (order.size() + kChunkEntries - 1) / kChunkEntries;
+    auto validateChunk = [&](std::size_t k) {
+        ydict::TraceSpan trace("validate.chunk", "validate");
+        ValidateTally t;
+        const std::size_t end = std::min(order.size(), (k + 1) * kChunkEntries);
+        for (std::size_t i = k * kChunkEntries; i < end; ++i) {
+            validate_entry(dict, opt, order[i], t);
+        }
+        std::lock_guard<std::mutex> lock(totalMu);
+        total.merge(t);
+    };
+    if (pool) {
+        pool->parallelFor(chunks, validateChunk);
+    } else {
+        for (std::size_t k = 0; k < chunks; ++k) {
+            validateChunk(k);
+        }
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    write_report(out, dict, opt, total, jobs, ms);
+    if (!out.flush()) {
+        std::cerr << "Cannot write validation report: " << opt.report << "\n";
+        return 1;
+    }
+
+    const std::uint64_t unreadable = total.entries[RecordError];
+    if (opt.diagnostics) {
+        std::cerr << "validate: " << order.size() << " entries, " << unreadable << " unreadable, " << jobs
+                  << " job(s), " << ms << " ms\n";
+    }
+    return unreadable > 0 ? 1 : 0;
+}
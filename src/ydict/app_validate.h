@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ydict/ydict.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Whole-dictionary validation (ydict_app --validate [report])
+ * -----------------------------------------------------------
+ * Checks every entry of the dictionary and writes a summary report:
+ *
+ *   records  definition records that cannot be read (offset or record
+ *            past the end of the .dat, bad length; see
+ *            Dictionary::checkDefinition()), and entries larger than
+ *            `oversized_bytes`
+ *   render   entries that parse to no output, unbalanced groups,
+ *            unmapped phonetic slots by byte value and control words the
+ *            renderers ignore, by frequency (see ydict::lintRtf())
+ *
+ * plus the first few entries showing each problem. Entries are visited in
+ * .dat offset order and checked in chunks on a worker pool; every chunk
+ * tallies on its own and is merged once, so workers do not contend.
+ * Returns 1 if any record cannot be read, 0 otherwise (render findings
+ * alone are reported but are not failures).
+ */
+struct ValidateOptions
+{
+    std::string report = "-";               // file path, or "-" for stdout
+    std::size_t jobs = 0;                   // 0 = one per hardware thread
+    std::uint32_t oversized_bytes = 64 * 1024;
+    bool diagnostics = false;               // summary line on stderr
+};
+
+// Returns the process exit code.
+int runValidate(const ydict::Dictionary& dict, const ValidateOptions& opt);
@@ -0,0 +1,150 @@
+#include "ydict/dat_file.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ydict {
+
+DatFile::~DatFile()
+{
+    close();
+}
+
+DatFile::DatFile(DatFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+DatFile& DatFile::operator=(DatFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+#ifdef _WIN32
+        handle_ = std::exchange(other.handle_, nullptr);
+#else
+        fd_ = std::exchange(other.fd_, -1);
+#endif
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool DatFile::open(const std::string& path)
+{
+    close();
+
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(h, &sz)) {
+        CloseHandle(h);
+        return false;
+    }
+
+    handle_ = h;
+    size_ = static_cast<std::uint64_t>(sz.QuadPart);
+    return true;
+}
+
+void DatFile::close()
+{
+    if (handle_)
+        CloseHandle(static_cast<HANDLE>(handle_));
+    handle_ = nullptr;
+    size_ = 0;
+}
+
+bool DatFile::isOpen() const
+{
+    return handle_ != nullptr;
+}
+
+std::size_t DatFile::readAt(std::uint64_t offset, void* dst, std::size_t n) const
+{
+    std::size_t done = 0;
+    while (done < n) {
+        OVERLAPPED ov{};
+        const std::uint64_t at = offset + done;
+        ov.Offset = static_cast<DWORD>(at & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(at >> 32);
+
+        const DWORD want = static_cast<DWORD>(std::min<std::size_t>(n - done, 1u << 30));
+        DWORD got = 0;
+        if (!ReadFile(static_cast<HANDLE>(handle_), static_cast<char*>(dst) + done, want, &got, &ov) || got == 0)
+            break;
+        done += got;
+    }
+    return done;
+}
+
+#else
+
+bool DatFile::open(const std::string& path)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    size_ = static_cast<std::uint64_t>(st.st_size);
+    return true;
+}
+
+void DatFile::close()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+}
+
+bool DatFile::isOpen() const
+{
+    return fd_ >= 0;
+}
+
+std::size_t DatFile::readAt(std::uint64_t offset, void* dst, std::size_t n) const
+{
+    std::size_t done = 0;
+    while (done < n) {
+        const ssize_t r = ::pread(fd_, static_cast<char*>(dst) + done, n - done, static_cast<off_t>(offset + done));
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            break;
+        done += static_cast<std::size_t>(r);
+    }
+    return done;
+}
+
+#endif
+
+} // namespace ydict
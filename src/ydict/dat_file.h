@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ydict {
+
+/*
+ * Read-only file for positional reads
+ * -----------------------------------
+ * Opened once; readAt() takes an explicit offset (pread / ReadFile with an
+ * OVERLAPPED offset) and keeps no shared file position, so any number of
+ * threads can read through the same descriptor without locking.
+ */
+class DatFile {
+public:
+    DatFile() = default;
+    ~DatFile();
+
+    DatFile(DatFile&& other) noexcept;
+    DatFile& operator=(DatFile&& other) noexcept;
+
+    DatFile(const DatFile&) = delete;
+    DatFile& operator=(const DatFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const;
+
+    // Size when opened.
+    std::uint64_t size() const { return size_; }
+
+    // Reads up to `n` bytes at `offset`; returns the count read (short at EOF or on error).
+    std::size_t readAt(std::uint64_t offset, void* dst, std::size_t n) const;
+
+private:
+#ifdef _WIN32
+    void* handle_ = nullptr; // HANDLE
+#else
+    int fd_ = -1;
+#endif
+    std::uint64_t size_ = 0;
+};
+
+} // namespace ydict
@@ -0,0 +1,256 @@
+#include "ydict/dictionary_set.h"
+#include "ydict/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace ydict {
+
+struct DictionarySet::Slot {
+    DictionarySource source;
+    std::shared_ptr<const Dictionary> dict; // set once, before `loaded`
+
+    std::mutex loadMu;                 // serializes the (one) load
+    bool loadFailed = false;           // guarded by loadMu
+    std::atomic<bool> loaded{false};   // dict is initialized and read-only from here on
+    std::atomic<bool> enabled{false};
+};
+
+DictionarySet::DictionarySet() = default;
+DictionarySet::~DictionarySet() = default;
+
+bool DictionarySet::load(Slot& slot)
+{
+    if (slot.loaded.load(std::memory_order_acquire))
+        return true;
+
+    std::lock_guard<std::mutex> lock(slot.loadMu);
+    if (slot.loaded.load(std::memory_order_relaxed))
+        return true;
+    if (slot.loadFailed)
+        return false;
+
+    slot.dict = Dictionary::open(slot.source.config);
+    slot.loadFailed = !slot.dict;
+    slot.loaded.store(!slot.loadFailed, std::memory_order_release);
+    return !slot.loadFailed;
+}
+
+bool DictionarySet::init(std::vector<DictionarySource> sources, std::size_t threads)
+{
+    pool_.reset();
+    slots_.clear();
+
+    for (DictionarySource& src : sources) {
+        auto slot = std::make_unique<Slot>();
+        slot->source = std::move(src);
+        slots_.push_back(std::move(slot));
+    }
+
+    // The calling thread takes part in parallelFor(), so n sources need n - 1 helpers.
+    const std::size_t fanOut = std::min(threads == 0 ? ThreadPool::defaultThreads() : threads, slots_.size());
+    if (fanOut > 1)
+        pool_ = std::make_unique<ThreadPool>(fanOut - 1);
+
+    std::vector<Slot*> eager;
+    for (const auto& slot : slots_) {
+        if (!slot->source.lazy)
+            eager.push_back(slot.get());
+    }
+
+    std::atomic<bool> allLoaded{true};
+    auto loadOne = [&](std::size_t i) {
+        if (load(*eager[i]))
+            eager[i]->enabled.store(true, std::memory_order_release);
+        else
+            allLoaded.store(false, std::memory_order_relaxed);
+    };
+    if (pool_) {
+        pool_->parallelFor(eager.size(), loadOne);
+    } else {
+        for (std::size_t i = 0; i < eager.size(); ++i) {
+            loadOne(i);
+        }
+    }
+
+    return allLoaded.load();
+}
+
+int DictionarySet::size() const
+{
+    return static_cast<int>(slots_.size());
+}
+
+const std::string& DictionarySet::name(int source) const
+{
+    static const std::string kNone;
+    if (source < 0 || source >= size())
+        return kNone;
+    return slots_[source]->source.name;
+}
+
+int DictionarySet::find(std::string_view name) const
+{
+    for (int i = 0; i < size(); ++i) {
+        if (slots_[i]->source.name == name)
+            return i;
+    }
+    return -1;
+}
+
+bool DictionarySet::isEnabled(int source) const
+{
+    if (source < 0 || source >= size())
+        return false;
+    return slots_[source]->enabled.load(std::memory_order_acquire);
+}
+
+bool DictionarySet::enable(int source)
+{
+    if (source < 0 || source >= size())
+        return false;
+    Slot& slot = *slots_[source];
+    if (!load(slot))
+        return false;
+    slot.enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+void DictionarySet::disable(int source)
+{
+    if (source >= 0 && source < size())
+        slots_[source]->enabled.store(false, std::memory_order_release);
+}
+
+const Dictionary* DictionarySet::dictionary(int source) const
+{
+    if (source < 0 || source >= size())
+        return nullptr;
+    const Slot& slot = *slots_[source];
+    return slot.loaded.load(std::memory_order_acquire) ? slot.dict.get() : nullptr;
+}
+
+std::shared_ptr<const Dictionary> DictionarySet::snapshot(int source) const
+{
+    if (source < 0 || source >= size())
+        return nullptr;
+    const Slot& slot = *slots_[source];
+    return slot.loaded.load(std::memory_order_acquire) ? slot.dict : nullptr;
+}
+
+const Config& DictionarySet::config(int source) const
+{
+    static const Config kNone;
+    if (source < 0 || source >= size())
+        return kNone;
+    return slots_[source]->source.config;
+}
+
+std::optional<WordEntry> DictionarySet::wordAt(const SourcedHit& hit) const
+{
+    const Dictionary* dict = dictionary(hit.source);
+    return dict ? dict->wordAt(hit.index) : std::nullopt;
+}
+
+std::vector<int> DictionarySet::activeSources() const
+{
+    std::vector<int> active;
+    for (int i = 0; i < size(); ++i) {
+        // enabled implies loaded, and the acquire makes the loaded Dictionary visible.
+        if (slots_[i]->enabled.load(std::memory_order_acquire))
+            active.push_back(i);
+    }
+    return active;
+}
+
+std::vector<SourcedHit> DictionarySet::findWord(std::string_view word) const
+{
+    // One binary search per source: cheaper inline than a hand-off to the pool.
+    std::vector<SourcedHit> hits;
+    for (const int s : activeSources()) {
+        const int idx = slots_[s]->dict->findWord(word);
+        if (idx >= 0)
+            hits.push_back(SourcedHit{s, idx});
+    }
+    return hits;
+}
+
+// ASCII case-insensitive three-way compare (same folding as Dictionary::suggest).
+static int compare_icase(std::string_view a, std::string_view b)
+{
+    const std::size_t n = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < n; ++i) {
+        unsigned char x = static_cast<unsigned char>(a[i]);
+        unsigned char y = static_cast<unsigned char>(b[i]);
+        if (x >= 'A' && x <= 'Z') x = static_cast<unsigned char>(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = static_cast<unsigned char>(y - 'A' + 'a');
+        if (x != y)
+            return x < y ? -1 : 1;
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+std::vector<SourcedHit> DictionarySet::suggest(std::string_view prefix, std::size_t maxResults) const
+{
+    return suggest(prefix, maxResults, QueryBudget{}, nullptr);
+}
+
+std::vector<SourcedHit> DictionarySet::suggest(std::string_view prefix, std::size_t maxResults,
+                                               const QueryBudget& budget, bool* truncated) const
+{
+    const std::vector<int> active = activeSources();
+    std::vector<std::vector<int>> perSource(active.size());
+    std::unique_ptr<bool[]> cut(new bool[active.size()]()); // not vector<bool>: written concurrently
+
+    auto scan = [&](std::size_t k) {
+        const Dictionary& dict = *slots_[active[k]]->dict;
+        // suggest() keeps the first N in .idx (byte) order, where "Zebra" < "apex", so its cut is not the
+        // case-insensitive top N: take every match, then cut in the merge's order (ties by index).
+        std::vector<int> hits = dict.suggest(prefix, static_cast<std::size_t>(dict.wordCount()), budget, &cut[k]);
+        const std::size_t keep = std::min(hits.size(), maxResults);
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(keep), hits.end(),
+                          [&dict](int a, int b) {
+            const auto x = dict.wordAt(a);
+            const auto y = dict.wordAt(b);
+            const int c = compare_icase(x ? x->word : std::string_view(), y ? y->word : std::string_view());
+            return c != 0 ? c < 0 : a < b;
+        });
+        hits.resize(keep);
+        perSource[k] = std::move(hits);
+    };
+    if (pool_ && active.size() > 1) {
+        pool_->parallelFor(active.size(), scan);
+    } else {
+        for (std::size_t k = 0; k < active.size(); ++k) {
+            scan(k);
+        }
+    }
+
+    // k-way merge of the (few) per-source lists.
+    std::vector<SourcedHit> out;
+    std::vector<std::size_t> head(active.size(), 0);
+    while (out.size() < maxResults) {
+        int best = -1;
+        std::string_view bestWord;
+        for (std::size_t k = 0; k < active.size(); ++k) {
+            if (head[k] >= perSource[k].size())
+                continue;
+            const auto e = slots_[active[k]]->dict->wordAt(perSource[k][head[k]]);
+            const std::string_view w = e ? e->word : std::string_view();
+            if (best < 0 || compare_icase(w, bestWord) < 0) {
+                best = static_cast<int>(k);
+                bestWord = w;
+            }
+        }
+        if (best < 0)
+            break;
+        out.push_back(SourcedHit{active[best], perSource[best][head[best]]});
+        ++head[best];
+    }
+    if (truncated)
+        *truncated = std::any_of(cut.get(), cut.get() + active.size(), [](bool c) { return c; });
+    return out;
+}
+
+} // namespace ydict
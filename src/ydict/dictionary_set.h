@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ydict/ydict.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ydict {
+
+class ThreadPool;
+
+struct DictionarySource {
+    std::string name;     // tag reported with every result, e.g. "en-pl"
+    Config config;
+    bool lazy = false;    // not loaded by init(); enable() loads it on demand
+};
+
+struct SourcedHit {
+    int source = -1;      // position in the DictionarySet's source list
+    int index = -1;       // entry index within that dictionary
+};
+
+/*
+ * Several dictionaries behind one query path
+ * ------------------------------------------
+ * ydpdict data comes as separate pairs (dict100 EN->PL, dict101 PL->EN, ...).
+ * init() loads all non-lazy sources concurrently, so startup takes as long
+ * as the slowest single load. Queries go to every enabled source and tag
+ * each result with the source it came from; suggest() scans the sources in
+ * parallel (each one is a linear prefix scan) and merges the lists.
+ *
+ * init() must not race with anything else. After it, enable()/disable()
+ * and all queries may be called from any thread.
+ */
+class DictionarySet {
+public:
+    DictionarySet();
+    ~DictionarySet();
+
+    DictionarySet(const DictionarySet&) = delete;
+    DictionarySet& operator=(const DictionarySet&) = delete;
+
+    // `threads` caps the load/query fan-out; 0 = one per source (up to the hardware threads).
+    // Returns true if every non-lazy source loaded; failed ones stay disabled.
+    bool init(std::vector<DictionarySource> sources, std::size_t threads = 0);
+
+    int size() const;
+    const std::string& name(int source) const;
+    int find(std::string_view name) const;                 // -1 if no such source
+
+    bool isEnabled(int source) const;
+    bool enable(int source);                               // loads a lazy source first; false if that fails
+    void disable(int source);
+
+    const Config& config(int source) const;
+
+    // Loaded dictionary (enabled or not), nullptr if not loaded.
+    const Dictionary* dictionary(int source) const;
+    std::shared_ptr<const Dictionary> snapshot(int source) const;
+    std::optional<WordEntry> wordAt(const SourcedHit& hit) const;
+
+    // Exact match in every enabled source, in source order.
+    std::vector<SourcedHit> findWord(std::string_view word) const;
+
+    /*
+     * The first `maxResults` prefix matches over all enabled sources in
+     * ASCII case-insensitive word order (ties: source order). Every source
+     * scans all its matches and keeps its own case-insensitive top N
+     * before the merge; Dictionary::suggest() alone cuts in .idx order.
+     */
+    std::vector<SourcedHit> suggest(std::string_view prefix, std::size_t maxResults = 15) const;
+
+    // Same, every source's scan bounded by `budget`; `truncated` if any of them was cut short.
+    std::vector<SourcedHit> suggest(std::string_view prefix, std::size_t maxResults, const QueryBudget& budget,
+                                    bool* truncated) const;
+
+private:
+    struct Slot;
+
+    bool load(Slot& slot);
+    std::vector<int> activeSources() const;
+
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+} // namespace ydict
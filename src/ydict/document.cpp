@@ -0,0 +1,427 @@
+#include "ydict/document.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ydict {
+
+static std::string_view trim_ws(std::string_view s)
+{
+    auto isWs = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+    while (!s.empty() && isWs(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isWs(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+std::string_view Document::spanText(const DocSpan& s) const
+{
+    return std::string_view(text).substr(s.text_begin, s.text_end - s.text_begin);
+}
+
+std::string_view Document::lineText(const DocLine& l) const
+{
+    return std::string_view(text).substr(l.text_begin, l.text_end - l.text_begin);
+}
+
+std::string_view Document::headword() const
+{
+    if (head_line == kNone)
+        return {};
+
+    const DocLine& l = lines[head_line];
+    std::uint32_t end = l.text_end;
+    for (std::uint32_t s = l.span_begin; s < l.span_end; ++s) {
+        if (spans[s].phonetic) {
+            end = spans[s].text_begin;
+            break;
+        }
+    }
+    return trim_ws(std::string_view(text).substr(l.text_begin, end - l.text_begin));
+}
+
+std::vector<std::string_view> Document::phonetics() const
+{
+    std::vector<std::string_view> out;
+    if (head_line == kNone)
+        return out;
+
+    const DocLine& l = lines[head_line];
+    for (std::uint32_t s = l.span_begin; s < l.span_end; ++s) {
+        if (!spans[s].phonetic)
+            continue;
+
+        // Adjacent phonetic runs (e.g. differing only in \cfN) form one transcription.
+        std::uint32_t e = s;
+        while (e + 1 < l.span_end && spans[e + 1].phonetic) {
+            ++e;
+        }
+        std::string_view p = trim_ws(std::string_view(text).substr(
+            spans[s].text_begin, spans[e].text_end - spans[s].text_begin));
+        if (p.size() >= 2 && p.front() == '[' && p.back() == ']')
+            p = trim_ws(p.substr(1, p.size() - 2));
+        if (!p.empty())
+            out.push_back(p);
+        s = e;
+    }
+    return out;
+}
+
+std::size_t Document::heapBytes() const
+{
+    // A string within its small-buffer capacity has no heap block.
+    const std::size_t textHeap = text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+    return textHeap + spans.capacity() * sizeof(DocSpan) + lines.capacity() * sizeof(DocLine) +
+           blocks.capacity() * sizeof(DocBlock) + senses.capacity() * sizeof(DocSense) +
+           examples.capacity() * sizeof(std::uint32_t);
+}
+
+/* --- output format names --- */
+
+bool parseOutputFormat(std::string_view name, OutputFormat& fmt)
+{
+    if (name == "cli")   { fmt = OutputFormat::Cli;   return true; }
+    if (name == "plain") { fmt = OutputFormat::Plain; return true; }
+    if (name == "ansi")  { fmt = OutputFormat::Ansi;  return true; }
+    if (name == "html")  { fmt = OutputFormat::Html;  return true; }
+    if (name == "json")  { fmt = OutputFormat::Json;  return true; }
+    return false;
+}
+
+const char* outputFormatName(OutputFormat fmt)
+{
+    switch (fmt) {
+    case OutputFormat::Cli:   return "cli";
+    case OutputFormat::Plain: return "plain";
+    case OutputFormat::Ansi:  return "ansi";
+    case OutputFormat::Html:  return "html";
+    case OutputFormat::Json:  return "json";
+    }
+    return "?";
+}
+
+/*
+ * Serialization
+ * -------------
+ *   "YDOC" u32 version
+ *   u32 head_line
+ *   u32 counts: text, spans, lines, blocks, senses, examples
+ *   text bytes, then each array field by field (u32 LE; flags as u8)
+ */
+
+static constexpr char kDocMagic[4] = {'Y', 'D', 'O', 'C'};
+static constexpr std::uint32_t kDocVersion = 1;
+
+static void put_u8(std::string& out, std::uint8_t v)
+{
+    out.push_back(static_cast<char>(v));
+}
+
+static void put_u32(std::string& out, std::uint32_t v)
+{
+    const char b[4] = {
+        static_cast<char>(v & 0xFF),
+        static_cast<char>((v >> 8) & 0xFF),
+        static_cast<char>((v >> 16) & 0xFF),
+        static_cast<char>((v >> 24) & 0xFF),
+    };
+    out.append(b, 4);
+}
+
+class ByteReader
+{
+public:
+    explicit ByteReader(std::string_view in) : in_(in) {}
+
+    bool u8(std::uint8_t& v)
+    {
+        if (in_.size() - pos_ < 1) return false;
+        v = static_cast<std::uint8_t>(in_[pos_++]);
+        return true;
+    }
+
+    bool u32(std::uint32_t& v)
+    {
+        if (in_.size() - pos_ < 4) return false;
+        const auto* p = reinterpret_cast<const unsigned char*>(in_.data() + pos_);
+        v = (std::uint32_t(p[0])      ) |
+            (std::uint32_t(p[1]) <<  8) |
+            (std::uint32_t(p[2]) << 16) |
+            (std::uint32_t(p[3]) << 24);
+        pos_ += 4;
+        return true;
+    }
+
+    bool bytes(std::string& out, size_t n)
+    {
+        if (in_.size() - pos_ < n) return false;
+        out.assign(in_.data() + pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+    size_t remaining() const { return in_.size() - pos_; }
+
+private:
+    std::string_view in_;
+    size_t pos_ = 0;
+};
+
+std::string serializeDocument(const Document& doc)
+{
+    std::string out;
+    out.reserve(40 + doc.text.size() + doc.spans.size() * 21 + doc.lines.size() * 31 +
+                doc.blocks.size() * 12 + doc.senses.size() * 12 + doc.examples.size() * 4);
+
+    out.append(kDocMagic, 4);
+    put_u32(out, kDocVersion);
+    put_u32(out, doc.head_line);
+    put_u32(out, static_cast<std::uint32_t>(doc.text.size()));
+    put_u32(out, static_cast<std::uint32_t>(doc.spans.size()));
+    put_u32(out, static_cast<std::uint32_t>(doc.lines.size()));
+    put_u32(out, static_cast<std::uint32_t>(doc.blocks.size()));
+    put_u32(out, static_cast<std::uint32_t>(doc.senses.size()));
+    put_u32(out, static_cast<std::uint32_t>(doc.examples.size()));
+
+    out += doc.text;
+
+    for (const DocSpan& s : doc.spans) {
+        put_u32(out, s.text_begin);
+        put_u32(out, s.text_end);
+        put_u32(out, s.src_begin);
+        put_u32(out, s.src_end);
+        put_u32(out, static_cast<std::uint32_t>(s.cf));
+        put_u8(out, s.phonetic ? 1 : 0);
+    }
+    for (const DocLine& l : doc.lines) {
+        put_u8(out, static_cast<std::uint8_t>(l.kind));
+        put_u8(out, l.newlines_after);
+        put_u8(out, l.margin ? 1 : 0);
+        put_u32(out, static_cast<std::uint32_t>(l.cf));
+        put_u32(out, l.text_begin);
+        put_u32(out, l.text_end);
+        put_u32(out, l.span_begin);
+        put_u32(out, l.span_end);
+        put_u32(out, l.src_begin);
+        put_u32(out, l.src_end);
+    }
+    for (const DocBlock& b : doc.blocks) {
+        put_u32(out, b.pos_line);
+        put_u32(out, b.sense_begin);
+        put_u32(out, b.sense_end);
+    }
+    for (const DocSense& s : doc.senses) {
+        put_u32(out, s.line);
+        put_u32(out, s.example_begin);
+        put_u32(out, s.example_end);
+    }
+    for (const std::uint32_t e : doc.examples) {
+        put_u32(out, e);
+    }
+    return out;
+}
+
+static bool valid_range(std::uint32_t b, std::uint32_t e, size_t size)
+{
+    return b <= e && e <= size;
+}
+
+static bool valid_line_ref(std::uint32_t line, const Document& doc, LineKind kind)
+{
+    if (line == Document::kNone)
+        return true;
+    return line < doc.lines.size() && doc.lines[line].kind == kind;
+}
+
+bool deserializeDocument(std::string_view bytes, Document& doc)
+{
+    doc = Document{};
+
+    if (bytes.size() < 4 || std::memcmp(bytes.data(), kDocMagic, 4) != 0)
+        return false;
+
+    ByteReader r(bytes.substr(4));
+
+    std::uint32_t version = 0;
+    std::uint32_t headLine = 0;
+    std::uint32_t nText = 0, nSpans = 0, nLines = 0, nBlocks = 0, nSenses = 0, nExamples = 0;
+    if (!r.u32(version) || version != kDocVersion)
+        return false;
+    if (!r.u32(headLine) || !r.u32(nText) || !r.u32(nSpans) || !r.u32(nLines) ||
+        !r.u32(nBlocks) || !r.u32(nSenses) || !r.u32(nExamples))
+        return false;
+
+    // Reject counts that cannot possibly fit before allocating anything.
+    const std::uint64_t need = std::uint64_t(nText) + std::uint64_t(nSpans) * 21 +
+                               std::uint64_t(nLines) * 31 + std::uint64_t(nBlocks) * 12 +
+                               std::uint64_t(nSenses) * 12 + std::uint64_t(nExamples) * 4;
+    if (need != r.remaining())
+        return false;
+
+    Document d;
+    if (!r.bytes(d.text, nText))
+        return false;
+
+    d.spans.resize(nSpans);
+    for (DocSpan& s : d.spans) {
+        std::uint32_t cf = 0;
+        std::uint8_t phonetic = 0;
+        if (!r.u32(s.text_begin) || !r.u32(s.text_end) || !r.u32(s.src_begin) ||
+            !r.u32(s.src_end) || !r.u32(cf) || !r.u8(phonetic))
+            return false;
+        s.cf = static_cast<std::int32_t>(cf);
+        s.phonetic = phonetic != 0;
+        if (!valid_range(s.text_begin, s.text_end, d.text.size()))
+            return false;
+    }
+
+    d.lines.resize(nLines);
+    for (DocLine& l : d.lines) {
+        std::uint8_t kind = 0, margin = 0;
+        std::uint32_t cf = 0;
+        if (!r.u8(kind) || !r.u8(l.newlines_after) || !r.u8(margin) || !r.u32(cf) ||
+            !r.u32(l.text_begin) || !r.u32(l.text_end) || !r.u32(l.span_begin) ||
+            !r.u32(l.span_end) || !r.u32(l.src_begin) || !r.u32(l.src_end))
+            return false;
+        if (kind > static_cast<std::uint8_t>(LineKind::Example) || l.newlines_after > 2)
+            return false;
+        l.kind = static_cast<LineKind>(kind);
+        l.margin = margin != 0;
+        l.cf = static_cast<std::int32_t>(cf);
+        if (!valid_range(l.text_begin, l.text_end, d.text.size()) ||
+            !valid_range(l.span_begin, l.span_end, d.spans.size()))
+            return false;
+    }
+
+    d.blocks.resize(nBlocks);
+    for (DocBlock& b : d.blocks) {
+        if (!r.u32(b.pos_line) || !r.u32(b.sense_begin) || !r.u32(b.sense_end))
+            return false;
+    }
+    d.senses.resize(nSenses);
+    for (DocSense& s : d.senses) {
+        if (!r.u32(s.line) || !r.u32(s.example_begin) || !r.u32(s.example_end))
+            return false;
+    }
+    d.examples.resize(nExamples);
+    for (std::uint32_t& e : d.examples) {
+        if (!r.u32(e))
+            return false;
+    }
+
+    // Structural validation: every index must point where its type says.
+    if (headLine != Document::kNone && !valid_line_ref(headLine, d, LineKind::Head))
+        return false;
+    for (const DocBlock& b : d.blocks) {
+        if (!valid_line_ref(b.pos_line, d, LineKind::Pos) ||
+            !valid_range(b.sense_begin, b.sense_end, d.senses.size()))
+            return false;
+    }
+    for (const DocSense& s : d.senses) {
+        if (!valid_line_ref(s.line, d, LineKind::Sense) ||
+            !valid_range(s.example_begin, s.example_end, d.examples.size()))
+            return false;
+    }
+    for (const std::uint32_t e : d.examples) {
+        if (e == Document::kNone || !valid_line_ref(e, d, LineKind::Example))
+            return false;
+    }
+
+    d.head_line = headLine;
+    doc = std::move(d);
+    return true;
+}
+
+/* --- DocumentCache --- */
+
+DocumentCache::DocumentCache(std::size_t capacity)
+    : capacity_(capacity)
+    , shardCount_(std::clamp<std::size_t>(capacity, 1, kShards))
+    , shards_(std::make_unique<Shard[]>(shardCount_))
+{
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        // Spread the remainder so the shard capacities add up to `capacity`.
+        shards_[i].capacity = capacity / shardCount_ + (i < capacity % shardCount_ ? 1 : 0);
+    }
+}
+
+std::shared_ptr<const Document> DocumentCache::find(int key)
+{
+    Shard& sh = shardFor(key);
+    std::lock_guard<std::mutex> lock(sh.mu);
+    const auto it = sh.map.find(key);
+    if (it == sh.map.end())
+        return {};
+    sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+    return it->second->second;
+}
+
+void DocumentCache::insert(int key, std::shared_ptr<const Document> doc)
+{
+    if (capacity_ == 0 || !doc)
+        return;
+
+    Shard& sh = shardFor(key);
+    std::lock_guard<std::mutex> lock(sh.mu);
+    const auto it = sh.map.find(key);
+    if (it != sh.map.end()) {
+        it->second->second = std::move(doc);
+        sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+        return;
+    }
+
+    sh.lru.emplace_front(key, std::move(doc));
+    sh.map[key] = sh.lru.begin();
+
+    while (sh.lru.size() > sh.capacity) {
+        sh.map.erase(sh.lru.back().first);
+        sh.lru.pop_back();
+    }
+}
+
+void DocumentCache::clear()
+{
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mu);
+        shards_[i].map.clear();
+        shards_[i].lru.clear();
+    }
+}
+
+std::size_t DocumentCache::size() const
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mu);
+        n += shards_[i].lru.size();
+    }
+    return n;
+}
+
+DocumentCacheUsage DocumentCache::usage() const
+{
+    // Node layouts are the usual ones (two links per list node, one per hash
+    // node, shared_ptr control block of two counts and a vtable pointer).
+    constexpr std::size_t kListNode = 2 * sizeof(void*) + sizeof(Item);
+    constexpr std::size_t kMapNode = sizeof(void*) + sizeof(std::pair<const int, std::list<Item>::iterator>);
+    constexpr std::size_t kControlBlock = 2 * sizeof(void*);
+
+    DocumentCacheUsage u;
+    u.overhead_bytes = shardCount_ * sizeof(Shard);
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        const Shard& sh = shards_[i];
+        std::lock_guard<std::mutex> lock(sh.mu);
+        u.entries += sh.lru.size();
+        u.overhead_bytes += sh.lru.size() * (kListNode + kMapNode) + sh.map.bucket_count() * sizeof(void*);
+        for (const Item& item : sh.lru) {
+            if (item.second)
+                u.document_bytes += kControlBlock + sizeof(Document) + item.second->heapBytes();
+        }
+    }
+    return u;
+}
+
+} // namespace ydict
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ydict {
+
+/*
+ * Structured definition model
+ * ---------------------------
+ * A definition's RTF stream is parsed once into a Document; every output
+ * format (CLI, plain, ANSI, HTML, JSON) is rendered from that model, so no
+ * renderer has to re-parse RTF or guess structure from plain text.
+ *
+ * Layout: all decoded UTF-8 text lives in a single arena string (`text`) and
+ * the structure is kept in flat vectors of 32-bit indices into it. A Document
+ * holds no pointers, so it can be copied, cached and serialized as-is.
+ *
+ *   lines    - visible output lines, in order (already trimmed, hidden \qc
+ *              blocks dropped, blank-line runs compressed)
+ *   spans    - style runs inside lines (\cfN, phonetic font \f1)
+ *   blocks   - part-of-speech blocks ("vt", "n", ...), each a range of senses
+ *   senses   - translation lines, each a range of `examples`
+ *   examples - indices of example lines (indented via \saN)
+ *
+ * Byte offsets into the source RTF are kept per line and per span.
+ */
+
+enum class LineKind : std::uint8_t {
+    Head,    // first line: headword + phonetics
+    Pos,     // part-of-speech heading (\cf2 "vt", "n", "adj", ...)
+    Sense,   // translation / note line
+    Example, // indented line (\saN)
+};
+
+struct DocSpan {
+    std::uint32_t text_begin = 0;   // [text_begin, text_end) in Document::text
+    std::uint32_t text_end = 0;
+    std::uint32_t src_begin = 0;    // [src_begin, src_end) in the source RTF
+    std::uint32_t src_end = 0;
+    std::int32_t  cf = 0;           // \cfN active for this run
+    bool          phonetic = false; // \f1 run
+};
+
+struct DocLine {
+    LineKind      kind = LineKind::Sense;
+    std::uint8_t  newlines_after = 0; // 0..2 line breaks that follow this line
+    bool          margin = false;     // \saN active at line start
+    std::int32_t  cf = 0;             // \cfN active at line start
+    std::uint32_t text_begin = 0;
+    std::uint32_t text_end = 0;
+    std::uint32_t span_begin = 0;     // [span_begin, span_end) in Document::spans
+    std::uint32_t span_end = 0;
+    std::uint32_t src_begin = 0;
+    std::uint32_t src_end = 0;
+};
+
+struct DocSense {
+    std::uint32_t line = 0;          // Sense line, or Document::kNone if examples came first
+    std::uint32_t example_begin = 0; // [example_begin, example_end) in Document::examples
+    std::uint32_t example_end = 0;
+};
+
+struct DocBlock {
+    std::uint32_t pos_line = 0;      // Pos line, or Document::kNone for senses before any heading
+    std::uint32_t sense_begin = 0;   // [sense_begin, sense_end) in Document::senses
+    std::uint32_t sense_end = 0;
+};
+
+struct Document {
+    static constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+
+    std::string text;
+    std::vector<DocSpan> spans;
+    std::vector<DocLine> lines;
+    std::vector<DocBlock> blocks;
+    std::vector<DocSense> senses;
+    std::vector<std::uint32_t> examples;
+    std::uint32_t head_line = kNone;
+
+    bool empty() const { return lines.empty(); }
+
+    std::string_view spanText(const DocSpan& s) const;
+    std::string_view lineText(const DocLine& l) const;
+
+    // Headword: head line text before the first phonetic run (trimmed).
+    std::string_view headword() const;
+
+    // Phonetic runs of the head line, trimmed and without surrounding [ ].
+    std::vector<std::string_view> phonetics() const;
+
+    // Heap bytes owned by the members (allocated capacity, not size); excludes sizeof(Document).
+    std::size_t heapBytes() const;
+};
+
+// Parse an RTF definition stream into a Document.
+Document parseDocument(std::string_view rtf);
+
+// Parse only the first `maxLines` output lines; scanning stops right after the
+// last one (which then has no newlines_after).
+Document parseDocument(std::string_view rtf, std::size_t maxLines);
+
+enum class OutputFormat : std::uint8_t {
+    Cli,   // console text, no colors (same as renderRtfForCli)
+    Plain, // bare lines, no indentation or markers
+    Ansi,  // console text with ANSI SGR colors
+    Html,  // <div>/<p> fragment with ydict-* classes
+    Json,  // structured: headword, phonetics, blocks/senses/examples
+};
+
+// "cli", "plain", "ansi", "html", "json" (case-sensitive). Returns false if unknown.
+bool parseOutputFormat(std::string_view name, OutputFormat& fmt);
+const char* outputFormatName(OutputFormat fmt);
+
+std::string renderDocument(const Document& doc, OutputFormat fmt);
+
+/*
+ * Direct rendering
+ * ----------------
+ * Renders RTF straight into one format without materializing a Document
+ * (output is identical to renderDocument(parseDocument(rtf), fmt)). Each
+ * format is a separate template instantiation of the scanner, so the per-byte
+ * loop only does what that format needs; CLI and plain skip style-run
+ * tracking entirely. Json needs the whole outline and goes through a Document.
+ *
+ * measureRtf() runs the same code against a counting sink and returns the
+ * exact output size without writing anything. renderRtfTo() writes at most
+ * `cap` bytes into `dst` (no NUL) and returns the full size, like snprintf:
+ *
+ *   std::string s(measureRtf(rtf, fmt), '\0');
+ *   renderRtfTo(rtf, fmt, s.data(), s.size());
+ */
+std::string renderRtf(std::string_view rtf, OutputFormat fmt);
+std::string renderRtf(std::string_view rtf, OutputFormat fmt, std::size_t maxLines);
+std::size_t measureRtf(std::string_view rtf, OutputFormat fmt);
+std::size_t renderRtfTo(std::string_view rtf, OutputFormat fmt, char* dst, std::size_t cap);
+
+/*
+ * Streaming rendering
+ * -------------------
+ * Renders a definition that arrives in pieces, e.g. read from the .dat in
+ * fixed-size blocks. Parser state (group stack, a control word cut by a chunk
+ * boundary) carries over between feed() calls, and formatted output goes to
+ * `sink` as soon as lines are complete, in pieces of up to ~16 KiB. The
+ * concatenated output equals renderRtf(whole input, fmt, maxLines).
+ *
+ * Memory stays bounded by the chunk size plus the longest output line, not
+ * the definition size. Json is the exception: its outline needs every line,
+ * so the input is buffered and rendered in finish().
+ */
+class RtfStreamRenderer {
+public:
+    using Sink = std::function<void(std::string_view)>;
+
+    RtfStreamRenderer(OutputFormat fmt, Sink sink, std::size_t maxLines = static_cast<std::size_t>(-1));
+    ~RtfStreamRenderer();
+
+    RtfStreamRenderer(const RtfStreamRenderer&) = delete;
+    RtfStreamRenderer& operator=(const RtfStreamRenderer&) = delete;
+
+    // Returns false once the output is complete (maxLines reached); further input is ignored.
+    bool feed(std::string_view chunk);
+
+    // End of input: renders what is left and flushes the sink. Idempotent.
+    void finish();
+
+    struct Impl;
+
+private:
+    Sink sink_;
+    std::unique_ptr<Impl> impl_;
+    bool finished_ = false;
+    std::uint64_t render_ns_ = 0;   // feed()/finish() time so far (YDICT_STATS builds)
+};
+
+/*
+ * RTF lint
+ * --------
+ * Runs a definition through the renderers' scanner and counts what they
+ * quietly degrade or drop: phonetic-font (\f1) bytes 0x80..0x9F without a
+ * glyph mapping (rendered "?"), control words the renderers ignore, and
+ * groups that do not balance. Hidden (\qc) text is not rendered, so its
+ * phonetic bytes are not counted; its control words are.
+ *
+ * lintRtf() adds to `total` and returns the counts for this definition
+ * alone. One RtfLint per thread, merged at the end, keeps a parallel pass
+ * lock-free.
+ */
+struct RtfLintCounts {
+    std::uint64_t unmapped_phonetic = 0;
+    std::uint64_t unknown_words = 0;
+    std::uint64_t unmatched_closes = 0;     // '}' with no open group
+    std::uint64_t unclosed_groups = 0;      // '{' still open at the end
+};
+
+struct RtfLint {
+    RtfLintCounts counts;
+    std::uint64_t unmapped_phonetic_by_slot[32] = {};    // index = byte - 0x80
+    std::unordered_map<std::string, std::uint64_t> unknown_words;  // word (no backslash) -> occurrences
+
+    void merge(const RtfLint& other);
+};
+
+RtfLintCounts lintRtf(std::string_view rtf, RtfLint& total);
+
+/*
+ * Binary (de)serialization, e.g. for on-disk or out-of-process caches.
+ * The format is versioned and little-endian; deserializeDocument validates
+ * all indices and returns false on malformed or foreign input.
+ */
+std::string serializeDocument(const Document& doc);
+bool deserializeDocument(std::string_view bytes, Document& doc);
+
+/*
+ * Small thread-safe LRU cache of parsed documents, keyed by entry index.
+ * Entries are shared_ptr<const Document>, so a cached document stays valid
+ * for its users even after eviction. Keys are spread over up to kShards
+ * independently locked LRU lists, so concurrent readers rarely wait on each
+ * other; eviction is per shard (capacity is split evenly).
+ */
+struct DocumentCacheUsage {
+    std::size_t entries = 0;
+    std::size_t document_bytes = 0;  // cached Documents: object, heap and shared_ptr control block
+    std::size_t overhead_bytes = 0;  // shards, LRU list and hash map nodes, buckets (estimated)
+};
+
+class DocumentCache {
+public:
+    explicit DocumentCache(std::size_t capacity);
+
+    std::shared_ptr<const Document> find(int key);
+    void insert(int key, std::shared_ptr<const Document> doc);
+    void clear();
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t size() const;
+
+    // Walks every shard under its lock; for diagnostics, not hot paths.
+    DocumentCacheUsage usage() const;
+
+private:
+    static constexpr std::size_t kShards = 16;
+
+    using Item = std::pair<int, std::shared_ptr<const Document>>;
+
+    struct Shard {
+        mutable std::mutex mu;
+        std::size_t capacity = 0;
+        std::list<Item> lru; // front = most recently used
+        std::unordered_map<int, std::list<Item>::iterator> map;
+    };
+
+    Shard& shardFor(int key) { return shards_[static_cast<unsigned>(key) % shardCount_]; }
+
+    std::size_t capacity_ = 0;
+    std::size_t shardCount_ = 1;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+} // namespace ydict
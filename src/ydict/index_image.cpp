@@ -0,0 +1,295 @@
+#include "ydict/index_image.h"
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ydict {
+
+// The checksum covers raw header bytes, so the layout must have no padding.
+static_assert(sizeof(IndexImageHeader) == 80 && sizeof(IndexEntry) == 12, "index image layout changed");
+
+static constexpr char kImageMagic[8] = {'Y', 'D', 'I', 'D', 'X', 'I', 'M', 'G'};
+
+static std::uint16_t load_u16_le(const std::byte* p)
+{
+    return static_cast<std::uint16_t>(std::to_integer<unsigned>(p[0]) | (std::to_integer<unsigned>(p[1]) << 8));
+}
+
+static std::uint32_t load_u32_le(const std::byte* p)
+{
+    return (std::to_integer<std::uint32_t>(p[0])      ) |
+           (std::to_integer<std::uint32_t>(p[1]) <<  8) |
+           (std::to_integer<std::uint32_t>(p[2]) << 16) |
+           (std::to_integer<std::uint32_t>(p[3]) << 24);
+}
+
+/*
+ * Fast non-cryptographic 64-bit hash, eight bytes per step. It catches
+ * truncated, torn or stale images; it is not meant to resist tampering
+ * (attach() checks file ownership for that).
+ */
+static std::uint64_t mix_bytes(std::uint64_t h, const std::byte* p, std::size_t n)
+{
+    constexpr std::uint64_t kMul = 0x9E3779B97F4A7C15ull;
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t v;
+        std::memcpy(&v, p, 8);
+        h = (h ^ v) * kMul;
+        h ^= h >> 32;
+    }
+    for (; n > 0; ++p, --n) {
+        h = (h ^ std::to_integer<std::uint64_t>(*p)) * kMul;
+    }
+    return h ^ (h >> 29);
+}
+
+static std::uint64_t image_checksum(std::span<const std::byte> image)
+{
+    const std::size_t headerPart = offsetof(IndexImageHeader, checksum);
+    std::uint64_t h = mix_bytes(0x243F6A8885A308D3ull, image.data(), headerPart);
+    return mix_bytes(h, image.data() + sizeof(IndexImageHeader), image.size() - sizeof(IndexImageHeader));
+}
+
+/*
+ * The .idx word table:
+ *   u32 magic @0, u16 count @8, u32 table offset @16, then per entry
+ *   4 unknown bytes, u32 .dat offset, NUL-terminated word.
+ * Every read is bounds-checked; a truncated table fails the whole parse.
+ */
+bool buildIndexImage(std::span<const std::byte> idx, const IndexStamp& stamp, std::vector<std::byte>& image)
+{
+    constexpr std::uint32_t kIdxMagic = 0x8d4e11d5;
+
+    image.clear();
+    if (idx.size() < 20 || load_u32_le(idx.data()) != kIdxMagic)
+        return false;
+
+    const std::uint16_t count = load_u16_le(idx.data() + 8);
+    size_t pos = load_u32_le(idx.data() + 16);
+
+    std::vector<IndexEntry> entries;
+    entries.reserve(count);
+    std::vector<char> arena;
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+        if (pos > idx.size() || idx.size() - pos < 8)
+            return false;
+        const std::uint32_t datOffset = load_u32_le(idx.data() + pos + 4); // skip unknown 4 bytes
+        pos += 8;
+
+        const char* text = reinterpret_cast<const char*>(idx.data()) + pos;
+        const void* nul = std::memchr(text, 0, idx.size() - pos);
+        if (!nul)
+            return false;
+        const size_t len = static_cast<size_t>(static_cast<const char*>(nul) - text);
+
+        entries.push_back(IndexEntry{static_cast<std::uint32_t>(arena.size()), static_cast<std::uint32_t>(len), datOffset});
+        arena.insert(arena.end(), text, text + len + 1); // with the NUL
+        pos += len + 1;
+    }
+
+    // Words come from the .idx, so the arena is smaller than it; still, offsets are u32.
+    if (arena.size() > 0xFFFFFFFFu - sizeof(IndexImageHeader) - entries.size() * sizeof(IndexEntry))
+        return false;
+
+    IndexImageHeader h{}; // no padding bytes: the struct is all fixed-width fields
+    std::memcpy(h.magic, kImageMagic, sizeof(h.magic));
+    h.version = kIndexImageVersion;
+    h.header_size = sizeof(IndexImageHeader);
+    h.count = count;
+    h.entries_offset = sizeof(IndexImageHeader);
+    h.arena_offset = h.entries_offset + static_cast<std::uint32_t>(entries.size() * sizeof(IndexEntry));
+    h.arena_size = static_cast<std::uint32_t>(arena.size());
+    h.image_size = std::uint64_t(h.arena_offset) + h.arena_size;
+    h.stamp = stamp;
+
+    image.resize(static_cast<size_t>(h.image_size));
+    std::memcpy(image.data(), &h, sizeof(h));
+    if (!entries.empty())
+        std::memcpy(image.data() + h.entries_offset, entries.data(), entries.size() * sizeof(IndexEntry));
+    if (!arena.empty())
+        std::memcpy(image.data() + h.arena_offset, arena.data(), arena.size());
+
+    h.checksum = image_checksum(image);
+    std::memcpy(image.data() + offsetof(IndexImageHeader, checksum), &h.checksum, sizeof(h.checksum));
+    return true;
+}
+
+bool IndexView::bind(std::span<const std::byte> image, std::string* why)
+{
+    clear();
+    auto fail = [why](const char* reason) {
+        if (why)
+            *why = reason;
+        return false;
+    };
+
+    if (image.size() < sizeof(IndexImageHeader))
+        return fail("truncated header");
+
+    // Images start at a heap or page boundary, so the header and entries are aligned.
+    const auto* h = reinterpret_cast<const IndexImageHeader*>(image.data());
+    if (std::memcmp(h->magic, kImageMagic, sizeof(kImageMagic)) != 0)
+        return fail("not an index image");
+    if (h->version != kIndexImageVersion || h->header_size != sizeof(IndexImageHeader))
+        return fail("image format version mismatch");
+    if (h->image_size != image.size())
+        return fail("image size mismatch");
+    if (h->entries_offset < sizeof(IndexImageHeader) || h->entries_offset % alignof(IndexEntry) != 0 ||
+        std::uint64_t(h->entries_offset) + std::uint64_t(h->count) * sizeof(IndexEntry) > h->arena_offset ||
+        std::uint64_t(h->arena_offset) + h->arena_size != h->image_size)
+        return fail("bad image layout");
+    if (image_checksum(image) != h->checksum)
+        return fail("checksum mismatch");
+
+    const auto* entries = reinterpret_cast<const IndexEntry*>(image.data() + h->entries_offset);
+    const char* arena = reinterpret_cast<const char*>(image.data() + h->arena_offset);
+    for (std::uint32_t i = 0; i < h->count; ++i) {
+        const IndexEntry& e = entries[i];
+        if (std::uint64_t(e.word_offset) + e.word_size >= h->arena_size || arena[e.word_offset + e.word_size] != '\0')
+            return fail("entry out of bounds");
+    }
+
+    header_ = h;
+    entries_ = std::span<const IndexEntry>(entries, h->count);
+    arena_ = arena;
+    return true;
+}
+
+SharedIndexFile::~SharedIndexFile()
+{
+    close();
+}
+
+SharedIndexFile::SharedIndexFile(SharedIndexFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+SharedIndexFile& SharedIndexFile::operator=(SharedIndexFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        addr_ = std::exchange(other.addr_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool SharedIndexFile::attach(const std::string&, std::string& why)
+{
+    why = "shared index is not supported on Windows";
+    return false;
+}
+
+void SharedIndexFile::close()
+{
+    addr_ = nullptr;
+    size_ = 0;
+}
+
+bool SharedIndexFile::publish(const std::string&, std::span<const std::byte>, std::string& why)
+{
+    why = "shared index is not supported on Windows";
+    return false;
+}
+
+#else
+
+bool SharedIndexFile::attach(const std::string& path, std::string& why)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) {
+        why = errno == ENOENT ? "missing" : std::string("cannot open: ") + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        why = "not a regular file";
+        return false;
+    }
+    // /dev/shm is world-writable: only trust images this user wrote and nobody else can change.
+    if (st.st_uid != ::geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        ::close(fd);
+        why = "not owned by this user, or writable by others";
+        return false;
+    }
+    if (st.st_size <= 0) {
+        ::close(fd);
+        why = "empty";
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file
+    if (addr == MAP_FAILED) {
+        why = std::string("mmap failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    addr_ = addr;
+    size_ = size;
+    return true;
+}
+
+void SharedIndexFile::close()
+{
+    if (addr_)
+        ::munmap(addr_, size_);
+    addr_ = nullptr;
+    size_ = 0;
+}
+
+bool SharedIndexFile::publish(const std::string& path, std::span<const std::byte> image, std::string& why)
+{
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0644);
+    if (fd < 0) {
+        why = std::string("cannot create: ") + std::strerror(errno);
+        return false;
+    }
+
+    size_t done = 0;
+    while (done < image.size()) {
+        const ssize_t w = ::write(fd, image.data() + done, image.size() - done);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            break;
+        done += static_cast<size_t>(w);
+    }
+    const bool written = done == image.size();
+    if (::close(fd) != 0 || !written) {
+        ::unlink(tmp.c_str());
+        why = "write failed";
+        return false;
+    }
+
+    // Atomic replace: concurrent publishers race harmlessly (each image is complete).
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        why = std::string("cannot replace: ") + std::strerror(errno);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif
+
+} // namespace ydict
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ydict {
+
+/*
+ * Index image
+ * -----------
+ * The loaded .idx word table as one flat, position-independent block: no
+ * pointers, only offsets from the start of the image, so the same bytes
+ * work in a heap buffer or mapped at any address in any process.
+ *
+ *   IndexImageHeader
+ *   IndexEntry[count]        sorted as in the .idx
+ *   headword arena           every word NUL-terminated
+ *
+ * Integers are native-endian: an image is only shared between processes
+ * on one host. The header records where the image was built from (size and
+ * mtime of the .idx and .dat) and a checksum of everything else, so a
+ * reader can tell a current image from a stale or damaged one.
+ */
+struct IndexEntry {
+    std::uint32_t word_offset = 0;   // into the arena
+    std::uint32_t word_size = 0;     // bytes, without the NUL
+    std::uint32_t dat_offset = 0;
+};
+
+// Identity of the files an image was built from (all 0 for in-memory data).
+struct IndexStamp {
+    std::uint64_t idx_size = 0;
+    std::int64_t idx_mtime_ns = 0;
+    std::uint64_t dat_size = 0;
+    std::int64_t dat_mtime_ns = 0;
+
+    bool operator==(const IndexStamp&) const = default;
+};
+
+struct IndexImageHeader {
+    char magic[8];                    // "YDIDXIMG"
+    std::uint32_t version;            // kIndexImageVersion
+    std::uint32_t header_size;        // sizeof(IndexImageHeader)
+    std::uint64_t image_size;
+    std::uint32_t count;
+    std::uint32_t entries_offset;
+    std::uint32_t arena_offset;
+    std::uint32_t arena_size;
+    IndexStamp stamp;
+    std::uint64_t checksum;           // header up to here + everything after the header
+};
+
+constexpr std::uint32_t kIndexImageVersion = 1;
+
+// Parse a .idx (same checks as ever) into a new image. False if the .idx is malformed.
+bool buildIndexImage(std::span<const std::byte> idx, const IndexStamp& stamp, std::vector<std::byte>& image);
+
+/*
+ * Read-only view of an image. bind() validates the header, the checksum
+ * and every entry's bounds, so a view never reads outside the image.
+ */
+class IndexView {
+public:
+    bool bind(std::span<const std::byte> image, std::string* why = nullptr);
+    void clear() { *this = IndexView{}; }
+
+    std::size_t size() const { return entries_.size(); }
+    const IndexStamp& stamp() const { return header_->stamp; }
+    const IndexImageHeader* header() const { return header_; }
+
+    // Entry i; the word is NUL-terminated inside the image.
+    std::string_view word(std::size_t i) const
+    {
+        return std::string_view(arena_ + entries_[i].word_offset, entries_[i].word_size);
+    }
+    std::uint32_t datOffset(std::size_t i) const { return entries_[i].dat_offset; }
+
+private:
+    const IndexImageHeader* header_ = nullptr;
+    std::span<const IndexEntry> entries_;
+    const char* arena_ = nullptr;
+};
+
+/*
+ * Index image in a shared file (typically under /dev/shm)
+ * -------------------------------------------------------
+ * publish() writes an image to a temporary file next to `path` and renames
+ * it into place, so readers only ever see complete images; a process that
+ * already mapped the previous one keeps it until it unmaps. attach() maps
+ * the file read-only: every attached process shares the same physical
+ * pages, so the index costs its size once per host, not once per process.
+ *
+ * attach() refuses files not owned by this user or writable by others;
+ * the caller then falls back to a private copy. Not supported on Windows
+ * (both calls fail).
+ */
+class SharedIndexFile {
+public:
+    SharedIndexFile() = default;
+    ~SharedIndexFile();
+
+    SharedIndexFile(SharedIndexFile&& other) noexcept;
+    SharedIndexFile& operator=(SharedIndexFile&& other) noexcept;
+
+    SharedIndexFile(const SharedIndexFile&) = delete;
+    SharedIndexFile& operator=(const SharedIndexFile&) = delete;
+
+    // Map `path`. On failure `why` says why (missing, wrong owner, ...).
+    bool attach(const std::string& path, std::string& why);
+    void close();
+
+    std::span<const std::byte> bytes() const { return {static_cast<const std::byte*>(addr_), size_}; }
+
+    static bool publish(const std::string& path, std::span<const std::byte> image, std::string& why);
+
+private:
+    void* addr_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace ydict
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace ydict {
+
+/*
+ * Minimal JSON string writer
+ * --------------------------
+ * Appends `s` to `out` as a quoted JSON string. Input is expected to be UTF-8
+ * (which is what all renderers produce); bytes >= 0x80 are passed through,
+ * control characters are escaped.
+ */
+inline void appendJsonString(std::string& out, std::string_view s)
+{
+    static const char kHex[] = "0123456789abcdef";
+
+    out.push_back('"');
+    for (const char c : s) {
+        const unsigned char uc = static_cast<unsigned char>(c);
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (uc < 0x20) {
+                out += "\\u00";
+                out.push_back(kHex[uc >> 4]);
+                out.push_back(kHex[uc & 0x0F]);
+            } else {
+                out.push_back(c);
+            }
+            break;
+        }
+    }
+    out.push_back('"');
+}
+
+} // namespace ydict
@@ -0,0 +1,266 @@
+#include "ydict/live_dictionary.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace ydict {
+
+/*
+ * Start a helper thread with every signal blocked, so process-directed
+ * signals (SIGHUP/SIGTERM the servers read through a signalfd) are never
+ * delivered to it.
+ */
+template <typename Fn>
+static std::thread start_quiet_thread(Fn&& fn)
+{
+#ifdef __linux__
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    std::thread t(std::forward<Fn>(fn));
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+    return t;
+#else
+    return std::thread(std::forward<Fn>(fn));
+#endif
+}
+
+LiveDictionary::LiveDictionary(Config cfg, std::shared_ptr<const Dictionary> initial)
+    : cfg_(std::move(cfg))
+{
+    if (!initial)
+        initial = Dictionary::open(cfg_);
+
+    // The dump belongs to the first load only; don't rewrite it on every reload.
+    cfg_.idx_dump_path.clear();
+
+    if (initial) {
+        current_ = std::move(initial);
+        generation_.store(1, std::memory_order_release);
+    }
+}
+
+LiveDictionary::~LiveDictionary()
+{
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+#ifdef __linux__
+    if (watchStopFd_ >= 0) {
+        const std::uint64_t one = 1;
+        (void)!::write(watchStopFd_, &one, sizeof(one));
+    }
+#endif
+    if (watcher_.joinable())
+        watcher_.join();
+    if (reloader_.joinable())
+        reloader_.join();
+
+#ifdef __linux__
+    if (watchStopFd_ >= 0)
+        ::close(watchStopFd_);
+#endif
+}
+
+std::shared_ptr<const Dictionary> LiveDictionary::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(currentMu_);
+    return current_;
+}
+
+void LiveDictionary::setListener(ReloadListener listener)
+{
+    std::lock_guard<std::mutex> lock(buildMu_);
+    listener_ = std::move(listener);
+}
+
+bool LiveDictionary::reloadNow()
+{
+    std::lock_guard<std::mutex> lock(buildMu_);
+
+    // Built off to the side; readers keep using the current snapshot meanwhile.
+    std::shared_ptr<const Dictionary> fresh = Dictionary::open(cfg_);
+    const bool ok = fresh != nullptr;
+
+    if (ok) {
+        std::shared_ptr<const Dictionary> old;
+        {
+            std::lock_guard<std::mutex> clock(currentMu_);
+            old = std::exchange(current_, fresh);
+            generation_.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        if (old) {
+            std::lock_guard<std::mutex> rlock(retiredMu_);
+            std::erase_if(retired_, [](const std::weak_ptr<const Dictionary>& w) { return w.expired(); });
+            retired_.push_back(old);
+        }
+        // `old` goes out of scope here; if no request holds it, it is freed now.
+    }
+
+    if (listener_)
+        listener_(ok, fresh);
+    return ok;
+}
+
+std::size_t LiveDictionary::retiredInUse() const
+{
+    std::lock_guard<std::mutex> lock(retiredMu_);
+    std::erase_if(retired_, [](const std::weak_ptr<const Dictionary>& w) { return w.expired(); });
+    return retired_.size();
+}
+
+void LiveDictionary::startReloader()
+{
+    // Caller holds mu_.
+    if (!reloader_.joinable())
+        reloader_ = start_quiet_thread([this] { reloaderLoop(); });
+}
+
+void LiveDictionary::reload()
+{
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (stopping_)
+            return;
+        pending_ = true;
+        startReloader();
+    }
+    cv_.notify_one();
+}
+
+void LiveDictionary::reloaderLoop()
+{
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+        cv_.wait(lock, [this] { return pending_ || stopping_; });
+        if (stopping_)
+            return;
+
+        // Everything requested up to here is covered by this one build.
+        pending_ = false;
+        lock.unlock();
+        reloadNow();
+        lock.lock();
+    }
+}
+
+#ifdef __linux__
+
+bool LiveDictionary::watch(std::chrono::milliseconds quiet)
+{
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stopping_ || watcher_.joinable())
+        return false;
+
+    const int in = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (in < 0)
+        return false;
+
+    /*
+     * Watch the directories, not the files: deploys usually rename a new
+     * file over the old one, which a watch on the old inode never reports.
+     * Both must be watched, or changes to one file would go unnoticed.
+     */
+    std::vector<WatchTarget> targets;
+    for (const std::string* path : {&cfg_.idx_path, &cfg_.dat_path}) {
+        const fs::path p(*path);
+        fs::path dir = p.parent_path();
+        if (dir.empty())
+            dir = ".";
+        const int wd = ::inotify_add_watch(in, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0) {
+            ::close(in);
+            return false;
+        }
+        targets.push_back(WatchTarget{wd, p.filename().string()});
+    }
+
+    watchStopFd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (watchStopFd_ < 0) {
+        ::close(in);
+        return false;
+    }
+
+    startReloader();
+    watcher_ = start_quiet_thread([this, in, targets = std::move(targets), quiet]() mutable {
+        watcherLoop(in, std::move(targets), quiet);
+    });
+    return true;
+}
+
+// Owns `in` (set up by watch()) and closes it on exit.
+void LiveDictionary::watcherLoop(int in, std::vector<WatchTarget> targets, std::chrono::milliseconds quiet)
+{
+    bool dirty = false;
+    alignas(inotify_event) char buf[4096];
+    for (;;) {
+        pollfd fds[2] = {{in, POLLIN, 0}, {watchStopFd_, POLLIN, 0}};
+        const int timeout = dirty ? static_cast<int>(quiet.count()) : -1;
+        const int n = ::poll(fds, 2, timeout);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+            break;
+
+        if (n == 0) {
+            // Nothing touched the files for `quiet`: the deploy is done.
+            dirty = false;
+            reload();
+            continue;
+        }
+
+        for (;;) {
+            const ssize_t len = ::read(in, buf, sizeof(buf));
+            if (len <= 0)
+                break;
+            for (ssize_t off = 0; off < len;) {
+                const auto* ev = reinterpret_cast<const inotify_event*>(buf + off);
+                off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+                if (ev->len == 0)
+                    continue;
+                const std::string_view name(ev->name);
+                dirty |= std::any_of(targets.begin(), targets.end(), [&](const WatchTarget& t) {
+                    return t.wd == ev->wd && t.name == name;
+                });
+            }
+        }
+    }
+
+    ::close(in);
+}
+
+#else
+
+bool LiveDictionary::watch(std::chrono::milliseconds)
+{
+    return false;
+}
+
+void LiveDictionary::watcherLoop(int, std::vector<WatchTarget>, std::chrono::milliseconds)
+{
+}
+
+#endif
+
+} // namespace ydict
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ydict/ydict.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ydict {
+
+/*
+ * Hot-reloadable dictionary
+ * -------------------------
+ * Holds the current Dictionary snapshot for a long-running process and
+ * replaces it when the .idx/.dat files change, without a restart:
+ *
+ *   - reload() asks the background thread to build a new snapshot from the
+ *     configured paths; reloadNow() does the same on the calling thread.
+ *   - watch() (Linux, inotify) triggers reload() once the files were written
+ *     or renamed into place and then stayed quiet for `quiet`.
+ *   - A successful build is published with one pointer swap. Readers call
+ *     snapshot() per request and keep the shared_ptr for the duration; they
+ *     never wait for a build (the lock only covers the pointer copy/swap),
+ *     and requests already running finish on the snapshot they started with.
+ *     The old snapshot (index, open .dat, parse cache) is freed when its
+ *     last reader drops it. (std::atomic<std::shared_ptr> would not take
+ *     the lock away: libstdc++ spin-locks inside it, and TSan reports its
+ *     relaxed unlock as a race.)
+ *   - A build that fails (files missing, truncated mid-deploy) keeps the
+ *     current snapshot; the next change triggers another attempt.
+ *
+ * Replace both files before the quiet period ends (ideally by renaming
+ * complete files into place), or a reload may pair a new .idx with the
+ * old .dat.
+ */
+class LiveDictionary {
+public:
+    // ok: whether the build succeeded; dict: the new snapshot (nullptr if !ok).
+    using ReloadListener = std::function<void(bool ok, const std::shared_ptr<const Dictionary>& dict)>;
+
+    // Starts from `initial` (already loaded from `cfg`), or loads `cfg` now if it is null.
+    explicit LiveDictionary(Config cfg, std::shared_ptr<const Dictionary> initial = nullptr);
+    ~LiveDictionary();
+
+    LiveDictionary(const LiveDictionary&) = delete;
+    LiveDictionary& operator=(const LiveDictionary&) = delete;
+
+    // Current snapshot; null only if the initial load failed and no reload succeeded since.
+    std::shared_ptr<const Dictionary> snapshot() const;
+
+    // Bumped by every successful swap (the initial snapshot is generation 1).
+    std::uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    // Called on the building thread after every attempt; set it before reload()/watch().
+    void setListener(ReloadListener listener);
+
+    // Asynchronous: requests arriving while a build runs are folded into one more build.
+    void reload();
+
+    // Synchronous build + swap. False (current snapshot kept) if the files do not load.
+    bool reloadNow();
+
+    // Start watching the configured files. False if unsupported or inotify cannot watch both
+    // files' directories (the watch is set up before this returns).
+    bool watch(std::chrono::milliseconds quiet = std::chrono::milliseconds(500));
+
+    // Replaced snapshots that some reader still holds (0 once old readers have drained).
+    std::size_t retiredInUse() const;
+
+private:
+    void startReloader();
+    void reloaderLoop();
+    struct WatchTarget { int wd; std::string name; };   // watched directory, file name in it
+    void watcherLoop(int inotifyFd, std::vector<WatchTarget> targets, std::chrono::milliseconds quiet);
+
+    Config cfg_;
+    mutable std::mutex currentMu_;                       // held only to copy/swap current_
+    std::shared_ptr<const Dictionary> current_;
+    std::atomic<std::uint64_t> generation_{0};
+
+    std::mutex buildMu_;                                 // one build at a time
+    ReloadListener listener_;
+    mutable std::mutex retiredMu_;
+    mutable std::vector<std::weak_ptr<const Dictionary>> retired_;
+
+    std::mutex mu_;                                      // guards the fields below
+    std::condition_variable cv_;
+    bool pending_ = false;
+    bool stopping_ = false;
+    std::thread reloader_;
+
+    std::thread watcher_;
+    int watchStopFd_ = -1;                               // eventfd that ends watcherLoop (Linux)
+};
+
+} // namespace ydict
@@ -5,8 +5,21 @@
 #include <sstream>
 #include <fstream>
 #include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <string_view>
 #include "ydict/ydict.h"
+#include "ydict/dictionary_set.h"
+#include "ydict/live_dictionary.h"
+#include "ydict/query_log.h"
+#include "ydict/trace.h"
+#include "ydict/app_batch.h"
+#include "ydict/app_export.h"
+#include "ydict/app_validate.h"
+#include "ydict/app_serve.h"
+#include "ydict/app_http.h"
+#include "ydict/app_jsonrpc.h"
 
 #ifdef _WIN32
 #  ifndef NOMINMAX
@@ -40,7 +53,21 @@ static std::string trimCopy(std::string s)
     return s;
 }
 
-static bool loadConfigFromExeDir(ydict::Config& cfg, std::string* err, bool diagnostics)
+/*
+ * ydict.cfg: top-level idx_path/dat_path name the main dictionary ("main").
+ * Further dictionaries go into [name] sections with their own idx_path and
+ * dat_path, plus an optional `lazy = true` (loaded only when --dict asks).
+ * `shared_index = <file>` (any section) shares that dictionary's parsed
+ * index between processes (see Config::shared_index_path):
+ *
+ *   idx_path = data/dict100.idx
+ *   dat_path = data/dict100.dat
+ *   shared_index = /dev/shm/ydict-dict100.index
+ *   [pl-en]
+ *   idx_path = data/dict101.idx
+ *   dat_path = data/dict101.dat
+ */
+static bool loadConfigFromExeDir(std::vector<ydict::DictionarySource>& sources, std::string* err, bool diagnostics)
 {
     const std::filesystem::path exeDir = getExeDir();
     const std::filesystem::path cfgPath = exeDir / "ydict.cfg";
@@ -58,8 +85,9 @@ static bool loadConfigFromExeDir(ydict::Config& cfg, std::string* err, bool diag
         return false;
     }
 
-    std::string idxPath;
-    std::string datPath;
+    sources.clear();
+    sources.emplace_back();
+    sources.back().name = "main";
 
     std::string line;
     while (std::getline(in, line)) {
@@ -67,6 +95,12 @@ static bool loadConfigFromExeDir(ydict::Config& cfg, std::string* err, bool diag
         if (line.empty()) continue;
         if (line[0] == '#' || line[0] == ';') continue;
 
+        if (line.front() == '[' && line.back() == ']') {
+            sources.emplace_back();
+            sources.back().name = trimCopy(line.substr(1, line.size() - 2));
+            continue;
+        }
+
         const size_t eq = line.find('=');
         if (eq == std::string::npos) continue;
 
@@ -77,97 +111,51 @@ static bool loadConfigFromExeDir(ydict::Config& cfg, std::string* err, bool diag
             val = val.substr(1, val.size() - 2);
         }
 
-        if (key == "idx_path") idxPath = val;
-        else if (key == "dat_path") datPath = val;
+        ydict::DictionarySource& src = sources.back();
+        if (key == "idx_path") src.config.idx_path = val;
+        else if (key == "dat_path") src.config.dat_path = val;
+        else if (key == "lazy") src.lazy = (val == "1" || val == "true" || val == "yes");
+        else if (key == "shared_index") src.config.shared_index_path = val;
     }
 
-    if (idxPath.empty() || datPath.empty()) {
-        if (err) {
-            *err = "Invalid ydict.cfg: idx_path/dat_path missing.\n";
+    for (ydict::DictionarySource& src : sources) {
+        if (src.config.idx_path.empty() || src.config.dat_path.empty()) {
+            if (err) {
+                *err = src.name == "main" ? std::string("Invalid ydict.cfg: idx_path/dat_path missing.\n")
+                                          : "Invalid ydict.cfg: [" + src.name + "] idx_path/dat_path missing.\n";
+            }
+            return false;
         }
-        return false;
-    }
 
-    std::filesystem::path idxP(idxPath);
-    std::filesystem::path datP(datPath);
-    if (idxP.is_relative()) idxP = exeDir / idxP;
-    if (datP.is_relative()) datP = exeDir / datP;
+        std::filesystem::path idxP(src.config.idx_path);
+        std::filesystem::path datP(src.config.dat_path);
+        if (idxP.is_relative()) idxP = exeDir / idxP;
+        if (datP.is_relative()) datP = exeDir / datP;
 
-    cfg.idx_path = idxP.string();
-    cfg.dat_path = datP.string();
+        src.config.idx_path = idxP.string();
+        src.config.dat_path = datP.string();
 
-    if (diagnostics) {
-        std::cout << "config: " << cfgPath.string() << "\n"
-                  << "idx_path: " << cfg.idx_path << "\n"
-                  << "dat_path: " << cfg.dat_path << "\n";
+        if (!src.config.shared_index_path.empty()) {
+            std::filesystem::path shP(src.config.shared_index_path);
+            if (shP.is_relative()) shP = exeDir / shP;
+            src.config.shared_index_path = shP.string();
+        }
     }
 
-    return true;
-}
-
-static std::string_view trim(std::string_view s)
-{
-    size_t b = 0;
-    while (b < s.size() && (s[b] == ' ' || s[b] == '\t' || s[b] == '\r' || s[b] == '\n')) {
-        ++b;
-    }
-    size_t e = s.size();
-    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r')) {
-        --e;
+    if (diagnostics) {
+        std::cout << "config: " << cfgPath.string() << "\n";
+        for (const ydict::DictionarySource& src : sources) {
+            const std::string tag = src.name == "main" ? "" : "[" + src.name + "] ";
+            std::cout << tag << "idx_path: " << src.config.idx_path << "\n"
+                      << tag << "dat_path: " << src.config.dat_path << (src.lazy ? " (lazy)" : "") << "\n";
+            if (!src.config.shared_index_path.empty())
+                std::cout << tag << "shared_index: " << src.config.shared_index_path << "\n";
+        }
     }
-    return s.substr(b, e - b);
-}
 
-static bool startsWith(std::string_view s, std::string_view prefix)
-{
-    return s.size() >= prefix.size() && s.substr(0, prefix.size()) == prefix;
-}
-
-static bool endsWithSentencePunct(std::string_view s)
-{
-    if (s.empty()) return false;
-    char c = s.back();
-    return c == '.' || c == '!' || c == '?';
-}
-
-static bool isHeadLine(std::string_view s)
-{
-    // In our plain format, the first line is typically: " word [phonetic]"
-    // and is preceded by "[head]" marker line.
-    return startsWith(s, "[head]");
-}
-
-static bool isPosLine(std::string_view s)
-{
-    // Heuristic: part-of-speech lines are short: "n", "vt", "vi", "adj", "adv", "prep", "cpd" etc.
-    // Keep it permissive; it's used only for formatting.
-    s = trim(s);
-    if (s.empty()) return false;
-
-    // Must be mostly letters and at most 4 chars.
-    if (s.size() > 4) return false;
-    for (char c : s) {
-        if (!std::isalpha(static_cast<unsigned char>(c))) return false;
-    }
     return true;
 }
 
-static bool isExampleLine(std::string_view s)
-{
-    // Example sentences often start with a capital letter or an opening quote.
-    s = trim(s);
-    if (s.empty()) return false;
-
-    const unsigned char c0 = static_cast<unsigned char>(s.front());
-    if (std::isupper(c0)) return true;
-    if (s.front() == '"' || s.front() == '\'') return true;
-
-    // Also allow leading ellipsis.
-    if (startsWith(s, "...")) return true;
-
-    return false;
-}
-
 static void dumpHeadTail(const std::string& s,
                          size_t headMax,
                          size_t tailMax,
@@ -192,112 +180,36 @@ static void dumpHeadTail(const std::string& s,
     std::cout << indent << s.substr(s.size() - tailMax) << "\n";
 }
 
-static std::string formatPlainForCli(const std::string& plain)
-{
-    // Convert the library's "plain" format into a pretty CLI format.
-    //
-    // Input (plain):
-    //   [head]
-    //    word [phon]
-    //
-    //   vt
-    //    translation...
-    //   example.
-    //
-    // Output (pretty):
-    //   word [phon]
-    //
-    //   vt
-    //   translation...
-    //     example.
-    //
-    std::string out;
-    out.reserve(plain.size() + 64);
-
-    std::vector<std::string_view> lines;
-    {
-        std::string_view sv(plain);
-        size_t pos = 0;
-        while (pos <= sv.size()) {
-            size_t eol = sv.find('\n', pos);
-            if (eol == std::string_view::npos) {
-                lines.push_back(sv.substr(pos));
-                break;
-            }
-            lines.push_back(sv.substr(pos, eol - pos));
-            pos = eol + 1;
-        }
-    }
-
-    bool sawHeadMarker = false;
-
-    for (size_t i = 0; i < lines.size(); ++i) {
-        std::string_view t = trim(lines[i]);
-        if (t.empty()) {
-            out.push_back('\n');
-            continue;
-        }
-
-        if (isHeadLine(t)) {
-            // (1) Skip [head] marker line
-            sawHeadMarker = true;
-            continue;
-        }
-
-        if (sawHeadMarker) {
-            // (2) Head content line: print as-is
-            // It often has a leading space in the plain output, trim() removed it.
-            out += t;
-            out.push_back('\n');
-            sawHeadMarker = false;
-            continue;
-        }
-
-        if (isPosLine(t)) {
-            // (3) Part-of-speech lines: print as-is, with a blank line before it (unless already).
-            if (!out.empty() && out.back() != '\n') out.push_back('\n');
-            if (out.size() >= 2 && out[out.size() - 1] == '\n' && out[out.size() - 2] != '\n') {
-                // ok
-            } else if (!out.empty() && out.back() == '\n') {
-                // If there isn't already an empty line, insert one.
-                if (out.size() >= 2 && out[out.size() - 2] != '\n') {
-                    out.push_back('\n');
-                }
-            }
-            out += t;
-            out.push_back('\n');
-            continue;
-        }
-
-        if (isExampleLine(t)) {
-            // (4) Indent example sentences
-            out += "  ";
-            out += t;
-            out.push_back('\n');
-            continue;
-        }
-
-        // (5) Regular translation / note line:
-        // keep original indentation minimal (plain had a leading space in many lines).
-        out += t;
-        out.push_back('\n');
-    }
-
-    // Remove trailing blank lines.
-    while (out.size() >= 2 && out[out.size() - 1] == '\n' && out[out.size() - 2] == '\n') {
-        out.pop_back();
-    }
-    return out;
-}
-
 struct CliOptions
 {
-    bool show_plain = false;        // default: pretty
+    ydict::OutputFormat format = ydict::OutputFormat::Cli; // default: pretty
     bool write_plain_file = false;  // default: do not write <word>.plain.txt
+    bool previews = false;          // default: suggestions list words only
     bool dump_index = false;        // default: do not dump full index
     bool diagnostics = false;       // default: print definition only
     bool smoke_test = false;        // default: do not run internal smoke tests
+    bool check_order = false;       // --check-order: report byte-order inversions in every index
+    bool export_all = false;        // --export <format> <out>
+    ExportOptions export_opt;
+    bool validate = false;          // --validate [report]
+    ValidateOptions validate_opt;
     std::string index_file = "ydict.index.txt";
+    bool batch = false;             // default: one <word> per process
+    BatchOptions batch_opt;
+    bool serve = false;             // --serve <socket>
+    bool client = false;            // --client <socket>
+    ServeOptions serve_opt;
+    ClientOptions client_opt;
+    bool http = false;              // --http <port>
+    HttpOptions http_opt;
+    std::vector<std::string> dicts; // --dict <name> (repeatable); empty = all non-lazy
+    bool jsonrpc = false;           // --jsonrpc (stdin/stdout)
+    JsonRpcOptions jsonrpc_opt;
+    bool watch = false;             // --watch: reload the server's dictionary when its files change
+    bool stats = false;             // --stats: print Dictionary::stats() to stderr on exit
+    std::string trace_path;         // --trace <file>: Chrome trace JSON written on exit
+    std::string query_log_path;     // --query-log <file>: binary log of every query (see ydict_replay)
+    bool jobs_set = false;
     bool help = false;
     std::string_view word;          // first non-option argument
 };
@@ -307,22 +219,49 @@ static void printUsage(const char* exe)
     std::cout
         << "Usage:\n"
         << "  " << exe << " [options] <word>\n"
+        << "  " << exe << " [options] --batch [file|-]\n"
+        << "  " << exe << " [options] --serve <socket>\n"
+        << "  " << exe << " [options] --client <socket> [--op lookup|suggest|render] [<word>]\n"
+        << "  " << exe << " [options] --http <port>\n"
+        << "  " << exe << " [options] --jsonrpc\n"
+        << "  " << exe << " [options] --export <jsonl|tsv> <out|->\n"
+        << "  " << exe << " [options] --validate [report|-]\n"
+        << "  " << exe << " [options] --check-order\n"
         << "  " << exe << " [options] --smoke-test\n"
         << "  " << exe << " --help\n"
         << "\n"
         << "Options:\n"
         << "  --diagnostics, --verbose, -v      Print diagnostic output (init/version/full dump)\n"
-        << "  --show-plain, --plain             Print raw plain text (instead of pretty)\n"
-        << "  --show-pretty, --pretty           Print pretty text (default)\n"
+        << "  --show-plain, --plain             Print plain text (same as --format plain)\n"
+        << "  --show-pretty, --pretty           Print pretty text (default, same as --format cli)\n"
+        << "  --format <cli|plain|ansi|html|json>  Output format for the definition\n"
         << "  --write-plain-file, --save-plain  Write <word>.plain.txt to disk\n"
+        << "  --preview                         Show a short preview under each suggestion\n"
         << "  --dump-index, --dump-idx          Write full index dump to ydict.index.txt\n"
         << "  --index-file <path>               Set index dump path (implies --dump-index)\n"
+        << "  --batch [file|-]                  Look up one word per line (default: stdin)\n"
+        << "  --separator <str>                 Batch/client record separator (default \"\\n\"; escapes \\n \\t \\0 \\xHH)\n"
+        << "  --jobs, -j <n>                    Worker threads for --batch (default 1) / --serve, --http, --jsonrpc, --export, --validate (default all; 0 = all cores)\n"
+        << "  --serve <socket>                  Serve lookups on a Unix socket (Linux)\n"
+        << "  --client <socket>                 Query a --serve daemon (<word>, or one per stdin line)\n"
+        << "  --op <lookup|suggest|render>      Client request type (default render)\n"
+        << "  --http <port>                     Serve /lookup, /suggest, /render on 127.0.0.1 (Linux)\n"
+        << "  --dict <name>                     Use this ydict.cfg dictionary (repeatable; default: all non-lazy)\n"
+        << "  --jsonrpc                         JSON-RPC requests on stdin, responses on stdout (one per line)\n"
+        << "  --watch                           With --serve/--http/--jsonrpc: reload when the .idx/.dat change (Linux)\n"
+        << "  --stats                           On exit, print per-phase timings and counters to stderr\n"
+        << "  --trace <file>                    Record spans (init, lookups, reads, renders) as Chrome trace JSON\n"
+        << "  --query-log <file>                Record every query with its time and type (replay with ydict_replay)\n"
+        << "  --export <jsonl|tsv> <out>        Write every entry of the primary dictionary to <out> (\"-\": stdout)\n"
+        << "  --validate [report|-]             Check and render every entry; write a summary report (default: stdout)\n"
+        << "  --check-order                     List index entries out of byte order and what the lookup fallback costs\n"
         << "  --smoke-test                       Run internal smoke tests (developer)\n"
         << "\n"
         << "Notes:\n"
         << "  - Default output is rendered from the original RTF stream (pretty, no colors).\n"
-        << "  - Use --show-plain to print raw plain text instead (debug / regression checks).\n"
+        << "  - Every format is rendered from the same parsed definition (see ydict/document.h).\n"
         << "  - By default, no files are written.\n"
+        << "  - --serve and --http also reload the dictionary on SIGHUP.\n"
         << "  - If no <word> is provided, the program prints a short hint; use -h/--help for usage.\n";
 }
 
@@ -343,17 +282,142 @@ static CliOptions parseCli(int argc, char** argv)
         }
 
         if (a == "--show-plain" || a == "--plain") {
-            opt.show_plain = true;
+            opt.format = ydict::OutputFormat::Plain;
             continue;
         }
         if (a == "--show-pretty" || a == "--pretty") {
-            opt.show_plain = false;
+            opt.format = ydict::OutputFormat::Cli;
+            continue;
+        }
+        if (a == "--format") {
+            if (i + 1 >= argc || !ydict::parseOutputFormat(argv[i + 1], opt.format)) {
+                opt.help = true;
+                continue;
+            }
+            ++i;
             continue;
         }
         if (a == "--write-plain-file" || a == "--save-plain" || a == "--save-plain-file") {
             opt.write_plain_file = true;
             continue;
         }
+        if (a == "--preview" || a == "--previews") {
+            opt.previews = true;
+            continue;
+        }
+        if (a == "--batch") {
+            opt.batch = true;
+            // Optional input argument: a path, or "-" for stdin.
+            if (i + 1 < argc && (argv[i + 1][0] != '-' || std::string_view(argv[i + 1]) == "-")) {
+                opt.batch_opt.input = argv[++i];
+            }
+            continue;
+        }
+        if (a == "--separator") {
+            if (i + 1 >= argc || !parseSeparator(argv[i + 1], opt.batch_opt.separator)) {
+                opt.help = true;
+                continue;
+            }
+            ++i;
+            continue;
+        }
+        if (a == "--jobs" || a == "-j") {
+            if (i + 1 >= argc) {
+                opt.help = true;
+                continue;
+            }
+            opt.batch_opt.jobs = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+            opt.jobs_set = true;
+            continue;
+        }
+        if (a == "--serve" || a == "--client") {
+            if (i + 1 >= argc) {
+                opt.help = true;
+                continue;
+            }
+            (a == "--serve" ? opt.serve : opt.client) = true;
+            opt.serve_opt.socket_path = argv[i + 1];
+            opt.client_opt.socket_path = argv[i + 1];
+            ++i;
+            continue;
+        }
+        if (a == "--http") {
+            const unsigned long port = i + 1 < argc ? std::strtoul(argv[i + 1], nullptr, 10) : 0;
+            if (port == 0 || port > 65535) {
+                opt.help = true;
+                continue;
+            }
+            opt.http = true;
+            opt.http_opt.port = static_cast<std::uint16_t>(port);
+            ++i;
+            continue;
+        }
+        if (a == "--dict") {
+            if (i + 1 >= argc) {
+                opt.help = true;
+                continue;
+            }
+            opt.dicts.emplace_back(argv[++i]);
+            continue;
+        }
+        if (a == "--jsonrpc") {
+            opt.jsonrpc = true;
+            continue;
+        }
+        if (a == "--query-log") {
+            if (i + 1 >= argc) {
+                opt.help = true;
+                continue;
+            }
+            opt.query_log_path = argv[++i];
+            continue;
+        }
+        if (a == "--trace") {
+            if (i + 1 >= argc) {
+                opt.help = true;
+                continue;
+            }
+            opt.trace_path = argv[++i];
+            continue;
+        }
+        if (a == "--stats") {
+            opt.stats = true;
+            continue;
+        }
+        if (a == "--check-order") {
+            opt.check_order = true;
+            continue;
+        }
+        if (a == "--export") {
+            if (i + 2 >= argc || !parseExportFormat(argv[i + 1], opt.export_opt.format)) {
+                opt.help = true;
+                continue;
+            }
+            opt.export_all = true;
+            opt.export_opt.output = argv[i + 2];
+            i += 2;
+            continue;
+        }
+        if (a == "--validate") {
+            opt.validate = true;
+            // Optional report argument: a path, or "-" for stdout.
+            if (i + 1 < argc && (argv[i + 1][0] != '-' || std::string_view(argv[i + 1]) == "-")) {
+                opt.validate_opt.report = argv[++i];
+            }
+            continue;
+        }
+        if (a == "--watch") {
+            opt.watch = true;
+            continue;
+        }
+        if (a == "--op") {
+            if (i + 1 >= argc || !parseServeOp(argv[i + 1], opt.client_opt.op)) {
+                opt.help = true;
+                continue;
+            }
+            ++i;
+            continue;
+        }
         if (a == "--dump-index" || a == "--dump-idx") {
             opt.dump_index = true;
             continue;
@@ -386,6 +450,37 @@ static CliOptions parseCli(int argc, char** argv)
         }
     }
 
+    opt.batch_opt.format = opt.format;
+    opt.batch_opt.diagnostics = opt.diagnostics;
+    if (opt.batch && !opt.word.empty()) {
+        opt.help = true; // words come from the batch input
+    }
+
+    // --jobs also sizes the server's render pool (default there: all cores).
+    opt.serve_opt.jobs = opt.jobs_set ? opt.batch_opt.jobs : 0;
+    opt.serve_opt.diagnostics = opt.diagnostics;
+    opt.client_opt.format = opt.format;
+    opt.client_opt.word = std::string(opt.word);
+    opt.client_opt.separator = opt.batch_opt.separator;
+    opt.client_opt.diagnostics = opt.diagnostics;
+    opt.http_opt.jobs = opt.serve_opt.jobs;
+    opt.http_opt.diagnostics = opt.diagnostics;
+    opt.jsonrpc_opt.jobs = opt.serve_opt.jobs;
+    opt.jsonrpc_opt.diagnostics = opt.diagnostics;
+    opt.export_opt.jobs = opt.serve_opt.jobs;
+    opt.export_opt.diagnostics = opt.diagnostics;
+    opt.validate_opt.jobs = opt.serve_opt.jobs;
+    opt.validate_opt.diagnostics = opt.diagnostics;
+    const int servers = int(opt.serve) + int(opt.http) + int(opt.jsonrpc);
+    if (servers > 1 || (servers == 1 && (opt.client || opt.batch || !opt.word.empty())) ||
+        (opt.watch && servers == 0)) {
+        opt.help = true;
+    }
+    if ((opt.export_all || opt.validate) &&
+        (servers > 0 || opt.client || opt.batch || !opt.word.empty() || (opt.export_all && opt.validate))) {
+        opt.help = true;
+    }
+
     return opt;
 }
 
@@ -404,150 +499,362 @@ static std::string sanitizeFilename(std::string s)
     return s;
 }
 
+static void printPreview(const ydict::Dictionary& dict, int index)
+{
+    // Bounded render: reads only a prefix of the entry from .dat.
+    const std::string preview = dict.previewAt(index);
+    std::string_view rest = preview;
+    while (!rest.empty()) {
+        const size_t eol = rest.find('\n');
+        const std::string_view line = rest.substr(0, eol);
+        if (!line.empty())
+            std::cout << "      " << line << "\n";
+        if (eol == std::string_view::npos)
+            break;
+        rest.remove_prefix(eol + 1);
+    }
+}
+
+static void printNotFound(const ydict::Dictionary& dict, std::string_view word, bool previews)
+{
+    std::cout << "word=\"" << word << "\" NOT FOUND\n";
+    std::cout << "\nSuggestions for prefix \"" << word << "\":\n";
+    const auto hits = dict.suggest(word, /*maxResults=*/20);
+    if (hits.empty()) {
+        std::cout << "  (no matches)\n";
+        return;
+    }
+    for (int k = 0; k < static_cast<int>(hits.size()); ++k) {
+        const auto e = dict.wordAt(hits[k]);
+        std::cout << "  [" << k << "] idx=" << hits[k]
+                  << " word=\"" << (e ? e->word : "?") << "\"\n";
+
+        if (previews)
+            printPreview(dict, hits[k]);
+    }
+}
+
+static void writePlainTextFile(std::string_view word, const ydict::Document& doc)
+{
+    // Plain-text file remains useful as a debug artifact.
+    const std::string plain = ydict::renderDocument(doc, ydict::OutputFormat::Plain);
+
+    const std::string fname = sanitizeFilename(std::string(word)) + ".plain.txt";
+    std::ofstream out(fname, std::ios::binary);
+    if (out) {
+        out.write(plain.data(), static_cast<std::streamsize>(plain.size()));
+        std::cout << "(saved to " << fname << ")\n";
+    } else {
+        std::cout << "(failed to save " << fname << ")\n";
+    }
+}
+
 static void dumpMinimalDefinition(const ydict::Dictionary& dict,
                                   std::string_view word,
-                                  bool showPlain,
-                                  bool writePlainFile)
+                                  ydict::OutputFormat format,
+                                  bool writePlainFile,
+                                  bool previews)
 {
     const int idx = dict.findWord(word);
     if (idx < 0) {
         // Keep the existing not-found style (but without the full diagnostic dump).
-        std::cout << "word=\"" << word << "\" NOT FOUND\n";
-        std::cout << "\nSuggestions for prefix \"" << word << "\":\n";
-        const auto hits = dict.suggest(word, /*maxResults=*/20);
-        if (hits.empty()) {
-            std::cout << "  (no matches)\n";
-            return;
-        }
-        for (int k = 0; k < static_cast<int>(hits.size()); ++k) {
-            const auto* e = dict.wordAt(hits[k]);
-            std::cout << "  [" << k << "] idx=" << hits[k]
-                      << " word=\"" << (e ? e->word : "?") << "\"\n";
-        }
+        printNotFound(dict, word, previews);
         return;
     }
 
-    if (showPlain) {
-        const std::string plain = dict.readPlainText(idx);
-        std::cout << plain;
-        if (!plain.empty() && plain.back() != '\n') {
+    if (!writePlainFile) {
+        // Nothing else needs the parsed definition: render it while it is read.
+        char last = '\n';
+        const bool ok = dict.streamDefinition(idx, format, [&](std::string_view chunk) {
+            if (chunk.empty())
+                return;
+            std::cout.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            last = chunk.back();
+        });
+        if (ok && last != '\n') {
             std::cout << "\n";
         }
-    } else {
-        const std::string rtf = dict.readRtf(idx);
-        std::string pretty = ydict::renderRtfForCli(rtf);
+        return;
+    }
 
-        // Safety fallback: if RTF render yields nothing, fall back to the old plain-based formatter.
-        if (pretty.empty()) {
-            const std::string plain = dict.readPlainText(idx);
-            pretty = formatPlainForCli(plain);
-        }
+    // Parse once; the selected format and the plain file are both rendered from it.
+    const ydict::Document doc = dict.readDocument(idx);
 
-        std::cout << pretty;
-        if (!pretty.empty() && pretty.back() != '\n') {
-            std::cout << "\n";
-        }
+    const std::string text = ydict::renderDocument(doc, format);
+    std::cout << text;
+    if (!text.empty() && text.back() != '\n') {
+        std::cout << "\n";
     }
 
-    if (writePlainFile) {
-        // Plain-text file remains useful as a debug artifact (RTF->plain conversion).
-        const std::string plain = dict.readPlainText(idx);
-
-        const std::string fname = sanitizeFilename(std::string(word)) + ".plain.txt";
-        std::ofstream out(fname, std::ios::binary);
-        if (out) {
-            out.write(plain.data(), static_cast<std::streamsize>(plain.size()));
-            std::cout << "(saved to " << fname << ")\n";
-        } else {
-            std::cout << "(failed to save " << fname << ")\n";
-        }
-    }
+    writePlainTextFile(word, doc);
 }
 
-static void dumpFullDefinition(const ydict::Dictionary& dict,
-                               std::string_view word,
-                               bool showPlain,
-                               bool writePlainFile)
+// Several dictionaries enabled: every hit, each under its dictionary's name.
+static void dumpFederatedDefinition(const ydict::DictionarySet& dicts,
+                                    std::string_view word,
+                                    ydict::OutputFormat format,
+                                    bool writePlainFile,
+                                    bool previews)
 {
-    const int idx = dict.findWord(word);
-    if (idx < 0) {
+    const auto hits = dicts.findWord(word);
+    if (hits.empty()) {
         std::cout << "word=\"" << word << "\" NOT FOUND\n";
         std::cout << "\nSuggestions for prefix \"" << word << "\":\n";
-        const auto hits = dict.suggest(word, /*maxResults=*/20);
-        if (hits.empty()) {
+        const auto sugg = dicts.suggest(word, /*maxResults=*/20);
+        if (sugg.empty()) {
             std::cout << "  (no matches)\n";
             return;
         }
-        for (int k = 0; k < static_cast<int>(hits.size()); ++k) {
-            const auto* e = dict.wordAt(hits[k]);
-            std::cout << "  [" << k << "] idx=" << hits[k]
+        for (int k = 0; k < static_cast<int>(sugg.size()); ++k) {
+            const auto e = dicts.wordAt(sugg[k]);
+            std::cout << "  [" << k << "] " << dicts.name(sugg[k].source) << " idx=" << sugg[k].index
                       << " word=\"" << (e ? e->word : "?") << "\"\n";
+
+            if (previews)
+                printPreview(*dicts.dictionary(sugg[k].source), sugg[k].index);
         }
         return;
     }
 
-    const auto* e = dict.wordAt(idx);
+    for (const ydict::SourcedHit& hit : hits) {
+        std::cout << "[" << dicts.name(hit.source) << "]\n";
+        dumpMinimalDefinition(*dicts.dictionary(hit.source), word, format, writePlainFile, previews);
+    }
+}
+
+static void dumpFullDefinition(const ydict::Dictionary& dict,
+                               std::string_view word,
+                               ydict::OutputFormat format,
+                               bool writePlainFile,
+                               bool previews)
+{
+    ydict::LookupExplain how;
+    const int idx = dict.findWordExplain(word, how);
+    std::cout << "lookup: " << ydict::lookupPathName(how.path) << " path, " << how.search_comparisons
+              << " search + " << how.scan_comparisons << " scan comparisons"
+              << (how.order_conflict ? " (index out of byte order here; try --check-order)" : "") << "\n";
+    if (idx < 0) {
+        printNotFound(dict, word, previews);
+        return;
+    }
+
+    const auto e = dict.wordAt(idx);
 
     std::cout << "==== FULL DUMP ====\n";
     std::cout << "word=\"" << word << "\" idx=" << idx << " datOffset=" << (e ? e->dat_offset : 0) << "\n";
 
-    if (showPlain) {
-        const std::string plain = dict.readPlainText(idx);
-        std::cout << "plain bytes=" << plain.size() << "\n";
-        std::cout << "---- BEGIN (plain) ----\n";
-        std::cout << plain << "\n";
-        std::cout << "----  END  (plain) ----\n";
-    } else {
-        std::cout << "---- BEGIN (pretty) ----\n";
+    const std::string rtf = dict.readRtf(idx);
+    const ydict::Document doc = ydict::parseDocument(rtf);
+    const std::string text = ydict::renderDocument(doc, format);
 
-        const std::string rtf = dict.readRtf(idx);
-        std::cout << "rtf bytes=" << rtf.size() << "\n";
+    const char* name = ydict::outputFormatName(format);
+    std::cout << "---- BEGIN (" << name << ") ----\n";
+    std::cout << "rtf bytes=" << rtf.size()
+              << " lines=" << doc.lines.size()
+              << " blocks=" << doc.blocks.size()
+              << " senses=" << doc.senses.size()
+              << " examples=" << doc.examples.size() << "\n";
+    std::cout << text << "\n";
+    std::cout << "----  END  (" << name << ") ----\n";
 
-        std::string pretty = ydict::renderRtfForCli(rtf);
+    if (writePlainFile) {
+        writePlainTextFile(word, doc);
+    }
+}
 
-        // Safety fallback: if RTF render yields nothing, fall back to the old plain-based formatter.
-        if (pretty.empty()) {
-            const std::string plain = dict.readPlainText(idx);
-            pretty = formatPlainForCli(plain);
+/*
+ * --stats report: one table per dictionary, latencies from the log2
+ * histograms (so percentiles are bucket upper bounds), then the counters.
+ * Render phases are process-wide and printed once, after the last table.
+ */
+static void printStats(const std::vector<std::pair<std::string, ydict::DictionaryStats>>& all)
+{
+    if (all.empty())
+        return;
+    if (!all.front().second.enabled) {
+        std::cerr << "stats: not compiled in (configure with -DYDICT_STATS=ON)\n";
+        return;
+    }
+
+    auto row = [](ydict::StatsPhase p, const ydict::LatencySummary& l) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "  %-14s %9llu %11.3f %10.2f %10.2f %10.2f %10.2f\n",
+                      ydict::statsPhaseName(p), static_cast<unsigned long long>(l.count), l.total_ns / 1e6,
+                      l.count ? l.total_ns / 1e3 / static_cast<double>(l.count) : 0.0,
+                      l.percentileNs(0.50) / 1e3, l.percentileNs(0.99) / 1e3, l.max_ns / 1e3);
+        std::cerr << line;
+    };
+    const char* header = "  phase              count    total ms    mean us     p50 us     p99 us     max us\n";
+
+    for (const auto& [name, st] : all) {
+        std::cerr << "stats [" << name << "]\n" << header;
+        for (std::size_t i = 0; i < ydict::kStatsPhaseCount; ++i) {
+            const auto p = static_cast<ydict::StatsPhase>(i);
+            if (!ydict::statsPhaseIsProcessWide(p) && st.phase(p).count > 0)
+                row(p, st.phase(p));
+        }
+        for (std::size_t i = 0; i < ydict::kStatsCounterCount; ++i) {
+            const auto c = static_cast<ydict::StatsCounter>(i);
+            std::cerr << "  " << ydict::statsCounterName(c) << " = " << st.counter(c) << "\n";
         }
+    }
 
-        std::cout << pretty << "\n";
-        std::cout << "----  END  (pretty) ----\n";
+    std::cerr << "stats [render, all dictionaries]\n" << header;
+    const ydict::DictionaryStats& st = all.back().second;
+    for (std::size_t i = 0; i < ydict::kStatsPhaseCount; ++i) {
+        const auto p = static_cast<ydict::StatsPhase>(i);
+        if (ydict::statsPhaseIsProcessWide(p))
+            row(p, st.phase(p));
     }
+}
 
-    if (writePlainFile) {
-        // Plain-text file remains useful as a debug artifact (RTF->plain conversion).
-        const std::string plain = dict.readPlainText(idx);
-
-        const std::string fname = sanitizeFilename(std::string(word)) + ".plain.txt";
-        std::ofstream out(fname, std::ios::binary);
-        if (out) {
-            out.write(plain.data(), static_cast<std::streamsize>(plain.size()));
-            std::cout << "(saved to " << fname << ")\n";
+/*
+ * --check-order: every adjacent pair of entries that is out of byte order,
+ * per loaded dictionary, and how many words only the linear fallback of
+ * findWord() can find. Returns 1 if any index has inversions.
+ */
+static int checkOrder(const ydict::DictionarySet& dicts)
+{
+    int rc = 0;
+    for (int s = 0; s < dicts.size(); ++s) {
+        const ydict::Dictionary* d = dicts.dictionary(s);
+        if (!d)
+            continue;
+        const ydict::IndexOrderReport r = d->checkIndexOrder();
+        std::cout << "check-order [" << dicts.name(s) << "]: " << d->wordCount() << " words, "
+                  << r.inversions.size() << " inversions\n";
+        for (const int i : r.inversions) {
+            const auto prev = d->wordAt(i - 1);
+            const auto cur = d->wordAt(i);
+            std::cout << "  " << i << "\t" << (prev ? prev->word : "") << "\t> " << (cur ? cur->word : "") << "\n";
+        }
+        if (r.fallback_words > 0) {
+            std::cout << "  fallback: " << r.fallback_words << " words found only by the linear scan, "
+                      << r.fallback_comparisons << " comparisons to look each up once ("
+                      << r.fallback_comparisons / r.fallback_words << " per lookup)\n";
         } else {
-            std::cout << "(failed to save " << fname << ")\n";
+            std::cout << "  fallback: none (every word is found by the binary search)\n";
         }
+        if (!r.inversions.empty())
+            rc = 1;
     }
+    return rc;
 }
 
+static std::string kib(std::size_t bytes)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f KiB", bytes / 1024.0);
+    return buf;
+}
+
+// --diagnostics: what one dictionary costs, per structure (see ydict::MemoryUsage).
+static void printMemoryUsage(std::ostream& out, const std::string& name, const ydict::MemoryUsage& m)
+{
+    out << "memory [" << name << "] " << m.words << " words\n";
+    out << "  index image    " << (m.index_shared ? "shared mapping" : "private heap") << ": "
+        << kib(m.index_header_bytes + m.index_entry_bytes + m.headword_bytes + m.headword_nul_bytes) << "\n";
+    out << "    headwords    " << kib(m.headword_bytes) << " text + " << kib(m.headword_nul_bytes) << " NULs\n";
+    out << "    entry table  " << kib(m.index_entry_bytes) << " (lookup index; word offset/size, .dat offset)\n";
+    out << "    header       " << m.index_header_bytes << " B\n";
+    if (!m.index_shared)
+        out << "    heap slack   " << kib(m.index_slack_bytes) << "\n";
+    out << "    pages        " << kib(m.index_mapped_bytes) << " spanned, "
+        << (m.resident_known ? kib(m.index_resident_bytes) : std::string("?")) << " resident\n";
+    if (m.dat_memory_bytes > 0) {
+        out << "  .dat           in memory" << (m.dat_memory_owned ? "" : " (not owned)") << ": "
+            << kib(m.dat_memory_bytes) << ", " << (m.resident_known ? kib(m.dat_resident_bytes) : std::string("?"))
+            << " resident\n";
+    } else {
+        out << "  .dat           on disk: " << kib(m.dat_file_bytes) << " (read per lookup, not held)\n";
+    }
+    out << "  document cache " << m.doc_cache.entries << "/" << m.doc_cache_capacity << " entries: "
+        << kib(m.doc_cache.document_bytes) << " documents + " << kib(m.doc_cache.overhead_bytes) << " overhead\n";
+    out << "  stats          " << kib(m.stats_bytes) << "\n";
+    out << "  object         " << kib(m.object_bytes) << "\n";
+    out << "  private total  " << kib(m.privateBytes()) << "\n";
+}
+
+// Runs its action when main() returns, whichever mode returned.
+struct AtExit
+{
+    std::function<void()> action;
+    ~AtExit()
+    {
+        if (action)
+            action();
+    }
+};
+
 int main(int argc, char** argv)
 {
-    const CliOptions cli = parseCli(argc, argv);
+    CliOptions cli = parseCli(argc, argv);
     if (cli.help) {
         printUsage(argv[0]);
         return 0;
     }
 
-    if (cli.word.empty() && !cli.smoke_test && !cli.dump_index) {
+    // The client talks to a running server; it never loads the dictionary itself.
+    if (cli.client) {
+        return runClient(cli.client_opt);
+    }
+
+    if (cli.word.empty() && !cli.smoke_test && !cli.dump_index && !cli.batch && !cli.serve && !cli.http && !cli.jsonrpc &&
+        !cli.check_order && !cli.export_all && !cli.validate) {
         std::cerr << "No <word> specified. Use -h or --help for usage.\n";
         return 2;
     }
 
-    ydict::Dictionary dict;
-    ydict::Config cfg;
+    // In --jsonrpc mode (and --export to "-") stdout carries the protocol or
+    // the records only (written through stdio, not iostreams); send any
+    // diagnostics printed below to stderr.
+    if (cli.jsonrpc || (cli.export_all && cli.export_opt.output == "-")) {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    // Written after everything below has returned (server threads joined).
+    AtExit traceWriter;
+    if (!cli.trace_path.empty()) {
+        ydict::traceStart(cli.trace_path);
+        ydict::traceThreadName("main");
+        traceWriter.action = [] {
+            std::string why;
+            if (!ydict::traceStop(&why))
+                std::cerr << "--trace: " << why << "\n";
+        };
+    }
+
+    // Outlives every mode below; closed (and checked) on the way out.
+    ydict::QueryLogWriter queryLog;
+    AtExit queryLogCloser;
+    if (!cli.query_log_path.empty()) {
+        std::string why;
+        if (!queryLog.open(cli.query_log_path, &why)) {
+            std::cerr << "--query-log: " << why << "\n";
+            return 1;
+        }
+        cli.batch_opt.query_log = &queryLog;
+        cli.serve_opt.query_log = &queryLog;
+        cli.http_opt.query_log = &queryLog;
+        cli.jsonrpc_opt.query_log = &queryLog;
+        queryLogCloser.action = [&queryLog, diagnostics = cli.diagnostics] {
+            const std::uint64_t n = queryLog.records();
+            if (!queryLog.close())
+                std::cerr << "--query-log: write failed\n";
+            else if (diagnostics)
+                std::cerr << "query log: " << n << " queries\n";
+        };
+    }
+
+    std::vector<ydict::DictionarySource> sources;
 
     std::string cfgErr;
-    if (!loadConfigFromExeDir(cfg, &cfgErr, /*diagnostics=*/cli.diagnostics)) {
+    bool cfgOk = false;
+    {
+        ydict::TraceSpan trace("config.load", "init");
+        cfgOk = loadConfigFromExeDir(sources, &cfgErr, /*diagnostics=*/cli.diagnostics);
+    }
+    if (!cfgOk) {
         std::cerr << cfgErr;
         return 1;
     }
@@ -559,15 +866,154 @@ int main(int argc, char** argv)
 
     // Optional debug dump of the loaded idx table (handled by the library).
     if (cli.dump_index) {
-        cfg.idx_dump_path = cli.index_file;
+        sources.front().config.idx_dump_path = cli.index_file;
+    }
+
+    // All configured dictionaries load concurrently. --dict narrows the set
+    // (and loads lazy ones); the single-dictionary modes use the first enabled.
+    ydict::DictionarySet dicts;
+    dicts.init(std::move(sources));
+    if (!cli.dicts.empty()) {
+        for (int s = 0; s < dicts.size(); ++s) {
+            dicts.disable(s);
+        }
+        for (const std::string& name : cli.dicts) {
+            const int s = dicts.find(name);
+            if (s < 0 || !dicts.enable(s)) {
+                std::cerr << "Cannot load dictionary \"" << name << "\"\n";
+                return 1;
+            }
+        }
     }
 
-    const bool ok = dict.init(cfg);
+    int primary = -1;
+    int enabledCount = 0;
+    for (int s = 0; s < dicts.size(); ++s) {
+        if (!dicts.isEnabled(s)) {
+            if (cli.diagnostics && dicts.dictionary(s) == nullptr && s > 0)
+                std::cout << "[" << dicts.name(s) << "] not loaded\n";
+            continue;
+        }
+        if (primary < 0)
+            primary = s;
+        ++enabledCount;
+    }
+
+    const ydict::Dictionary notLoaded;
+    const bool ok = primary >= 0;
+    const ydict::Dictionary& dict = ok ? *dicts.dictionary(primary) : notLoaded;
+
+    AtExit statsReport;
+    if (cli.stats) {
+        statsReport.action = [&dicts] {
+            std::vector<std::pair<std::string, ydict::DictionaryStats>> all;
+            for (int s = 0; s < dicts.size(); ++s) {
+                if (dicts.isEnabled(s) && dicts.dictionary(s))
+                    all.emplace_back(dicts.name(s), dicts.dictionary(s)->stats());
+            }
+            printStats(all);
+        };
+    }
 
     if (cli.diagnostics || cli.smoke_test || cli.dump_index) {
         std::cout << "init() => " << (ok ? "OK" : "FAIL") << "\n";
         std::cout << dict.version() << "\n";
     }
+    if (cli.diagnostics) {
+        for (int s = 0; s < dicts.size(); ++s) {
+            const ydict::Dictionary* d = dicts.dictionary(s);
+            if (!d || !d->sharedIndexStatus().requested)
+                continue;
+            const ydict::SharedIndexStatus& sh = d->sharedIndexStatus();
+            std::cout << (s == 0 ? "" : "[" + dicts.name(s) + "] ") << "shared index: " << sh.path;
+            if (sh.attached && !sh.rebuilt)
+                std::cout << " (attached)\n";
+            else if (sh.attached)
+                std::cout << " (rebuilt: " << sh.note << ")\n";
+            else
+                std::cout << " (not used: " << sh.note << ")\n";
+        }
+        for (int s = 0; s < dicts.size(); ++s) {
+            if (const ydict::Dictionary* d = dicts.dictionary(s))
+                printMemoryUsage(std::cout, dicts.name(s), d->memoryUsage());
+        }
+    }
+
+    if (cli.check_order) {
+        if (!ok) {
+            std::cerr << "init() failed\n";
+            return 1;
+        }
+        return checkOrder(dicts);
+    }
+
+    if (cli.export_all) {
+        if (!ok) {
+            std::cerr << "init() failed\n";
+            return 1;
+        }
+        return runExport(dict, cli.export_opt);
+    }
+
+    if (cli.validate) {
+        if (!ok) {
+            std::cerr << "init() failed\n";
+            return 1;
+        }
+        return runValidate(dict, cli.validate_opt);
+    }
+
+    if (cli.batch) {
+        if (!ok) {
+            std::cerr << "init() failed\n";
+            return 1;
+        }
+        return runBatch(dict, cli.batch_opt);
+    }
+
+    if (cli.serve || cli.http || cli.jsonrpc) {
+        if (!ok) {
+            std::cerr << "init() failed\n";
+            return 1;
+        }
+
+        // Long-running modes serve the primary dictionary through a reloadable snapshot.
+        ydict::LiveDictionary live(dicts.config(primary), dicts.snapshot(primary));
+        const bool diagnostics = cli.diagnostics;
+        live.setListener([&live, diagnostics](bool reloaded, const std::shared_ptr<const ydict::Dictionary>& d) {
+            if (!reloaded)
+                std::cerr << "reload failed; still serving generation " << live.generation() << "\n";
+            else if (diagnostics)
+                std::cerr << "reloaded: generation " << live.generation() << ", " << d->wordCount() << " words\n";
+        });
+        if (cli.watch && !live.watch())
+            std::cerr << "--watch: cannot watch the dictionary files; reload on SIGHUP only\n";
+
+        // Report on the snapshot being served at exit (reloads start a fresh one).
+        AtExit liveStatsReport;
+        if (cli.stats) {
+            statsReport.action = nullptr;
+            liveStatsReport.action = [&live, &dicts, primary] {
+                if (const auto d = live.snapshot())
+                    printStats({{dicts.name(primary), d->stats()}});
+            };
+        }
+
+        // The document cache fills while serving; report the footprint it reached.
+        AtExit liveMemoryReport;
+        if (cli.diagnostics) {
+            liveMemoryReport.action = [&live, &dicts, primary] {
+                if (const auto d = live.snapshot())
+                    printMemoryUsage(std::cerr, dicts.name(primary), d->memoryUsage());
+            };
+        }
+
+        if (cli.serve)
+            return runServer(live, cli.serve_opt);
+        if (cli.http)
+            return runHttpServer(live, cli.http_opt);
+        return runJsonRpc(live, cli.jsonrpc_opt);
+    }
 
     if (ok) {
         if (cli.dump_index) {
@@ -582,16 +1028,27 @@ int main(int argc, char** argv)
         //   ydict_app.exe get
         //   ydict_app.exe --show-plain get
         if (!cli.word.empty()) {
-            if (cli.diagnostics) {
+            ydict::TraceSpan trace("lookup", "request", cli.word);
+            if (!cli.query_log_path.empty())
+                queryLog.append(ydict::QueryOp::RenderDirect, cli.word, 0, static_cast<std::uint8_t>(cli.format));
+            if (enabledCount > 1 && !cli.diagnostics) {
+                dumpFederatedDefinition(dicts,
+                                        cli.word,
+                                        /*format=*/cli.format,
+                                        /*writePlainFile=*/cli.write_plain_file,
+                                        /*previews=*/cli.previews);
+            } else if (cli.diagnostics) {
                 dumpFullDefinition(dict,
                                    cli.word,
-                                   /*showPlain=*/cli.show_plain,
-                                   /*writePlainFile=*/cli.write_plain_file);
+                                   /*format=*/cli.format,
+                                   /*writePlainFile=*/cli.write_plain_file,
+                                   /*previews=*/cli.previews);
             } else {
                 dumpMinimalDefinition(dict,
                                       cli.word,
-                                      /*showPlain=*/cli.show_plain,
-                                      /*writePlainFile=*/cli.write_plain_file);
+                                      /*format=*/cli.format,
+                                      /*writePlainFile=*/cli.write_plain_file,
+                                      /*previews=*/cli.previews);
             }
             return 0;
         }
@@ -603,7 +1060,7 @@ int main(int argc, char** argv)
         // --- smoke tests (no <word> provided) ---
 
         for (int i = 0; i < dict.wordCount() && i < 25; ++i) {
-            const auto* e = dict.wordAt(i);
+            const auto e = dict.wordAt(i);
             std::cout << "  [" << i << "] datOffset=" << e->dat_offset
                       << " word=\"" << e->word << "\"\n";
         }
@@ -645,7 +1102,7 @@ int main(int argc, char** argv)
                 continue;
             }
 
-            const auto* e = dict.wordAt(idx);
+            const auto e = dict.wordAt(idx);
             std::cout << "  datOffset=" << (e ? e->dat_offset : 0) << "\n";
 
             const std::string plain = dict.readPlainText(idx);
@@ -672,13 +1129,13 @@ int main(int argc, char** argv)
 
             for (int k = 0; k < static_cast<int>(hits.size()); ++k) {
                 const int wi = hits[k];
-                const auto* e = dict.wordAt(wi);
+                const auto e = dict.wordAt(wi);
                 std::cout << "  [" << k << "] idx=" << wi
                           << " word=\"" << (e ? e->word : "?") << "\"\n";
             }
 
             const int firstIdx = hits.front();
-            const auto* e0 = dict.wordAt(firstIdx);
+            const auto e0 = dict.wordAt(firstIdx);
             std::cout << "  \n  selected=\"" << (e0 ? e0->word : "?") << "\"\n";
             const std::string def = dict.readPlainText(firstIdx);
             dumpHeadTail(def, /*headMax=*/220, /*tailMax=*/120, /*indent=*/"  ", /*blankLineBeforeTail=*/false);
@@ -0,0 +1,182 @@
+#include "ydict/query_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace ydict {
+
+static constexpr char kLogMagic[4] = {'Y', 'D', 'Q', 'L'};
+static constexpr std::uint32_t kLogVersion = 1;
+static constexpr std::size_t kFlushBytes = 64 * 1024;
+static constexpr std::size_t kMaxKeyBytes = 4096;       // longer keys are truncated
+
+static void put_varint(std::string& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static bool get_varint(const std::string& in, size_t& pos, std::uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size())
+            return false;
+        const unsigned char b = static_cast<unsigned char>(in[pos++]);
+        v |= std::uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+const char* queryOpName(QueryOp op)
+{
+    switch (op) {
+    case QueryOp::Lookup:       return "lookup";
+    case QueryOp::Suggest:      return "suggest";
+    case QueryOp::Fuzzy:        return "fuzzy";
+    case QueryOp::Render:       return "render";
+    case QueryOp::RenderDirect: return "render.direct";
+    }
+    return "?";
+}
+
+QueryLogWriter::~QueryLogWriter()
+{
+    close();
+}
+
+bool QueryLogWriter::open(const std::string& path, std::string* why)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(mu_);
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        if (why)
+            *why = "cannot create " + path;
+        return false;
+    }
+
+    buf_.clear();
+    buf_.append(kLogMagic, sizeof(kLogMagic));
+    for (int i = 0; i < 4; ++i) {
+        buf_.push_back(static_cast<char>((kLogVersion >> (8 * i)) & 0xFF));
+    }
+    last_ = std::chrono::steady_clock::now();
+    records_ = 0;
+    failed_ = false;
+    return true;
+}
+
+void QueryLogWriter::append(QueryOp op, std::string_view key, std::uint32_t limit, std::uint8_t format,
+                            std::uint8_t maxDistance)
+{
+    key = key.substr(0, kMaxKeyBytes);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!file_ || failed_)
+        return;
+
+    // Timestamped under the lock, so records are in time order and deltas never go negative.
+    const auto now = std::chrono::steady_clock::now();
+    const auto dt = std::chrono::duration_cast<std::chrono::microseconds>(now - last_).count();
+    last_ += std::chrono::microseconds(dt); // keep the sub-microsecond remainder for the next delta
+
+    put_varint(buf_, static_cast<std::uint64_t>(dt));
+    buf_.push_back(static_cast<char>(op));
+    buf_.push_back(static_cast<char>(format));
+    buf_.push_back(static_cast<char>(maxDistance));
+    put_varint(buf_, limit);
+    put_varint(buf_, key.size());
+    buf_.append(key.data(), key.size());
+    ++records_;
+
+    if (buf_.size() >= kFlushBytes)
+        flushLocked();
+}
+
+bool QueryLogWriter::flushLocked()
+{
+    if (!buf_.empty() && std::fwrite(buf_.data(), 1, buf_.size(), file_) != buf_.size())
+        failed_ = true;
+    buf_.clear();
+    return !failed_;
+}
+
+bool QueryLogWriter::close()
+{
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!file_)
+        return !failed_;
+
+    flushLocked();
+    if (std::fclose(file_) != 0)
+        failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
+
+std::uint64_t QueryLogWriter::records() const
+{
+    std::lock_guard<std::mutex> lock(mu_);
+    return records_;
+}
+
+bool readQueryLog(const std::string& path, std::vector<QueryRecord>& out, std::string* why)
+{
+    auto fail = [why](const char* reason) {
+        if (why)
+            *why = reason;
+        return false;
+    };
+
+    out.clear();
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        return fail("cannot open");
+    const std::string in((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+    if (in.size() < 8 || std::memcmp(in.data(), kLogMagic, sizeof(kLogMagic)) != 0)
+        return fail("not a query log");
+    std::uint32_t version = 0;
+    for (int i = 0; i < 4; ++i) {
+        version |= std::uint32_t(static_cast<unsigned char>(in[4 + i])) << (8 * i);
+    }
+    if (version != kLogVersion)
+        return fail("unsupported query log version");
+
+    size_t pos = 8;
+    std::uint64_t t = 0;
+    while (pos < in.size()) {
+        QueryRecord r;
+        std::uint64_t dt = 0;
+        std::uint64_t limit = 0;
+        std::uint64_t keyLen = 0;
+        if (!get_varint(in, pos, dt) || in.size() - pos < 3)
+            return fail("truncated record");
+        r.op = static_cast<QueryOp>(static_cast<unsigned char>(in[pos]));
+        r.format = static_cast<std::uint8_t>(in[pos + 1]);
+        r.max_distance = static_cast<std::uint8_t>(in[pos + 2]);
+        pos += 3;
+        if (!get_varint(in, pos, limit) || !get_varint(in, pos, keyLen) || keyLen > in.size() - pos)
+            return fail("truncated record");
+        if (r.op < QueryOp::Lookup || r.op > QueryOp::RenderDirect || limit > 0xFFFFFFFFu)
+            return fail("bad record");
+
+        t += dt;
+        r.time_us = t;
+        r.limit = static_cast<std::uint32_t>(limit);
+        r.key.assign(in, pos, static_cast<size_t>(keyLen));
+        pos += static_cast<size_t>(keyLen);
+        out.push_back(std::move(r));
+    }
+    return true;
+}
+
+} // namespace ydict
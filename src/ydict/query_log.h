@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ydict {
+
+/*
+ * Query log
+ * ---------
+ * Compact binary record of the queries a process served, for replaying
+ * production-shaped load (see ydict_replay). Little-endian, append-only:
+ *
+ *   header:  "YDQL" | u32 version (1)
+ *   record:  varint dt_us | u8 op | u8 format | u8 max_distance | varint limit
+ *            | varint key_len | key bytes
+ *
+ * dt_us is the time since the previous record (the first: since open()), so
+ * a steady stream of queries costs a few bytes of timing each. Renders are
+ * logged as the path that served them: Render through Dictionary::document()
+ * (parse cache; HTTP, JSON-RPC), RenderDirect as readRtf() + renderRtf()
+ * (batch, --serve, the CLI).
+ */
+enum class QueryOp : std::uint8_t {
+    Lookup = 1,
+    Suggest = 2,
+    Fuzzy = 3,
+    Render = 4,
+    RenderDirect = 5,
+};
+
+const char* queryOpName(QueryOp op);
+
+struct QueryRecord {
+    std::uint64_t time_us = 0;      // since the log was opened
+    QueryOp op = QueryOp::Lookup;
+    std::uint8_t format = 0;        // OutputFormat, renders
+    std::uint8_t max_distance = 0;  // fuzzy
+    std::uint32_t limit = 0;        // suggest, fuzzy
+    std::string key;                // word or prefix
+};
+
+/*
+ * Thread-safe writer. Records are encoded into a buffer under one short
+ * lock and written out in 64 KiB blocks, so logging adds no syscall per
+ * query. A write error stops logging; close() reports it.
+ */
+class QueryLogWriter {
+public:
+    QueryLogWriter() = default;
+    ~QueryLogWriter();
+
+    QueryLogWriter(const QueryLogWriter&) = delete;
+    QueryLogWriter& operator=(const QueryLogWriter&) = delete;
+
+    bool open(const std::string& path, std::string* why = nullptr);
+
+    void append(QueryOp op, std::string_view key, std::uint32_t limit = 0, std::uint8_t format = 0,
+                std::uint8_t maxDistance = 0);
+
+    // Flush and close. False if any write failed.
+    bool close();
+
+    std::uint64_t records() const;
+
+private:
+    bool flushLocked();
+
+    mutable std::mutex mu_;
+    std::FILE* file_ = nullptr;
+    std::string buf_;
+    std::chrono::steady_clock::time_point last_;
+    std::uint64_t records_ = 0;
+    bool failed_ = false;
+};
+
+// Read a whole log. False (with `why`) if it is not a query log or is damaged.
+bool readQueryLog(const std::string& path, std::vector<QueryRecord>& out, std::string* why = nullptr);
+
+} // namespace ydict
@@ -0,0 +1,1392 @@
+#include "ydict/ydict.h"
+#include "ydict/document.h"
+#include "ydict/json.h"
+#include "ydict/stats.h"
+#include "ydict/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace ydict {
+
+/*
+ * Byte->UTF-8 mapping for the dictionary's "phonetic" font stream.
+ *
+ * In ydpdict RTF, phonetic transcription is emitted using font #1 (\f1).
+ * In that mode, bytes in the 0x80..0x9F range are *not* CP1250 letters — they
+ * are custom glyph slots used for IPA-like symbols. We translate those 32
+ * slots to their intended Unicode characters so the output becomes valid UTF-8.
+ *
+ * Unknown / unused / not-yet-reverse-engineered slots are left as "?" so we
+ * don’t silently emit wrong phonetics; it makes missing mappings obvious
+ * during testing.
+ */
+static const char* kPhoneticToUtf8[32] = {
+    "?", "?", "ɔ", "ʒ", "?", "ʃ", "ɛ", "ʌ",
+    "ə", "θ", "ɪ", "ɑ", "?", "ː", "ˈ", "?",
+    "ŋ", "?", "?", "?", "?", "?", "?", "ð",
+    "æ", "?", "?", "?", "?", "?", "?", "?"
+};
+
+/* --- text decoding helpers --- */
+
+static int hexval(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+    return -1;
+}
+
+static void append_cp1250_byte_as_utf8(std::string& out, unsigned char b)
+{
+    if (b == 0x7F) { // upstream mapped this to "~"
+        out.push_back('~');
+        return;
+    }
+    if (b < 0x80) {
+        out.push_back(static_cast<char>(b));
+        return;
+    }
+
+#ifdef _WIN32
+    wchar_t wbuf[2] = {};
+    const char in = static_cast<char>(b);
+
+    const int wlen = MultiByteToWideChar(1250 /*CP1250*/, MB_ERR_INVALID_CHARS, &in, 1, wbuf, 2);
+    if (wlen <= 0) {
+        out.push_back('?');
+        return;
+    }
+
+    char ubuf[8] = {};
+    const int ulen = WideCharToMultiByte(CP_UTF8, 0, wbuf, wlen, ubuf, int(sizeof(ubuf)), nullptr, nullptr);
+    if (ulen <= 0) {
+        out.push_back('?');
+        return;
+    }
+    out.append(ubuf, ubuf + ulen);
+#else
+    out.push_back('?');
+#endif
+}
+
+static void append_byte_as_utf8(std::string& out, unsigned char b, bool phoneticMode)
+{
+    if (phoneticMode && b >= 128 && b < 160) {
+        out += kPhoneticToUtf8[b - 128];
+        return;
+    }
+    append_cp1250_byte_as_utf8(out, b);
+}
+
+// Minimal RTF \uN support
+static void append_unicode_as_utf8(std::string& out, int param)
+{
+#ifdef _WIN32
+    wchar_t wc = static_cast<wchar_t>(param);
+    char ubuf[8] = {};
+    const int ulen = WideCharToMultiByte(CP_UTF8, 0, &wc, 1, ubuf, int(sizeof(ubuf)), nullptr, nullptr);
+    if (ulen > 0) out.append(ubuf, ubuf + ulen);
+    else out.push_back('?');
+#else
+    (void)param;
+    out.push_back('?');
+#endif
+}
+
+static bool is_alpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_digit(char c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+static bool is_line_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static std::string_view trim_sv(std::string_view s)
+{
+    size_t b = 0;
+    while (b < s.size() && is_line_ws(s[b])) {
+        ++b;
+    }
+    size_t e = s.size();
+    while (e > b && is_line_ws(s[e - 1])) {
+        --e;
+    }
+    return s.substr(b, e - b);
+}
+
+static bool is_pos_heading(std::string_view t)
+{
+    t = trim_sv(t);
+    // Keep it conservative: only known headings should match.
+    return t == "n" ||
+           t == "adj" ||
+           t == "adv" ||
+           t == "vt" ||
+           t == "vi" ||
+           t == "prep" ||
+           t == "pron" ||
+           t == "conj" ||
+           t == "num" ||
+           t == "det" ||
+           t == "modal aux vb";
+}
+
+/*
+ * Minimal RTF scanner
+ * -------------------
+ * We parse a small subset of the RTF-like stream used by ydpdict and report
+ * visible text to a handler, trying to stay close to ydpdict’s *layout* (line
+ * breaks / spacing) without relying on the old plain-text heuristics.
+ *
+ * Important choices:
+ *   - We treat \par and \line (and raw '\n') as line breaks.
+ *   - We treat \pard as a paragraph-format reset (no line break).
+ *   - Text inside hidden blocks is never reported.
+ *
+ * Supported constructs:
+ *   - groups: '{' pushes state, '}' pops state
+ *   - '\saN' => indentation at beginning of line
+ *   - '\cfN' => style bucket (used as a hint for headings / colors)
+ *   - '\f1' => phonetic font stream (0x80..0x9F map via kPhoneticToUtf8)
+ *   - '\qc' => hidden blocks (ydpdict convention)
+ *   - "\'hh" and '\uN' => proper decoding to UTF-8
+ *
+ * Handler interface:
+ *   text(byte, state, srcBegin, srcEnd)     - visible text byte (CP1250 / phonetic slot)
+ *   textRun(bytes, state, srcBegin)         - visible run of printable ASCII
+ *                                             (no decoding needed, same as text()
+ *                                             called per byte)
+ *   unicode(code, state, srcBegin, srcEnd)  - visible \uN character
+ *   lineBreak()                             - visible \par, \line or '\n'
+ *   done()                                  - checked after each line break;
+ *                                             true stops the scan early
+ *
+ * Optional (detected at compile time, for lintRtf()):
+ *   unknownWord(name)                       - control word the scanner ignores
+ *   unmatchedClose()                        - '}' with no group open
+ */
+struct RtfGroupState
+{
+    int  cf = 0;           // \cfN
+    bool phonetic = false; // \f1
+    bool hide = false;     // \qc
+    bool margin = false;   // \saN
+};
+
+/*
+ * Group nesting limit. Real entries nest a handful of levels; malformed input
+ * may open thousands of groups, so the state stack is a fixed inline array
+ * (no allocation per call) and anything past the limit degrades gracefully:
+ * groups beyond it share one state, and the state at the limit is restored
+ * once they are all closed again.
+ */
+#ifndef YDICT_RTF_MAX_GROUP_DEPTH
+#define YDICT_RTF_MAX_GROUP_DEPTH 32
+#endif
+
+static_assert(YDICT_RTF_MAX_GROUP_DEPTH >= 1 && YDICT_RTF_MAX_GROUP_DEPTH <= 4096,
+              "YDICT_RTF_MAX_GROUP_DEPTH must be in [1, 4096]");
+
+class RtfGroupStack
+{
+public:
+    RtfGroupState& top() { return slots_[depth_]; }
+
+    void push()
+    {
+        if (depth_ < kMaxDepth) {
+            slots_[depth_ + 1] = slots_[depth_];
+            ++depth_;
+            return;
+        }
+        if (overflow_++ == 0)
+            saved_ = slots_[depth_];
+    }
+
+    // Unbalanced '}' at the outermost level is ignored (returns false).
+    bool pop()
+    {
+        if (overflow_ > 0) {
+            if (--overflow_ == 0)
+                slots_[depth_] = saved_;
+            return true;
+        }
+        if (depth_ == 0)
+            return false;
+        --depth_;
+        return true;
+    }
+
+    // Groups currently open, including those past the limit.
+    std::size_t depth() const { return depth_ + overflow_; }
+
+private:
+    static constexpr std::size_t kMaxDepth = YDICT_RTF_MAX_GROUP_DEPTH;
+
+    RtfGroupState slots_[kMaxDepth + 1] = {};
+    std::size_t depth_ = 0;
+    std::size_t overflow_ = 0;  // groups opened past kMaxDepth
+    RtfGroupState saved_;       // state at kMaxDepth when overflow began
+};
+
+enum class RtfWord : std::uint8_t { Other, Par, Line, Pard, Tab, Cf, Sa, F, Qc, U };
+
+// Control words we act on; switch on length first so unknown words cost one compare.
+static RtfWord classify_word(std::string_view t)
+{
+    switch (t.size()) {
+    case 1:
+        if (t[0] == 'f') return RtfWord::F;
+        if (t[0] == 'u') return RtfWord::U;
+        break;
+    case 2:
+        if (t == "cf") return RtfWord::Cf;
+        if (t == "sa") return RtfWord::Sa;
+        if (t == "qc") return RtfWord::Qc;
+        break;
+    case 3:
+        if (t == "par") return RtfWord::Par;
+        if (t == "tab") return RtfWord::Tab;
+        break;
+    case 4:
+        if (t == "line") return RtfWord::Line;
+        if (t == "pard") return RtfWord::Pard;
+        break;
+    default:
+        break;
+    }
+    return RtfWord::Other;
+}
+
+// Bytes that are literal text in every font: printable ASCII minus RTF syntax.
+static bool is_plain_ascii(unsigned char c)
+{
+    return c >= 0x20 && c < 0x7F && c != '\\' && c != '{' && c != '}';
+}
+
+/*
+ * The scanner keeps its group stack between calls, so a definition can also be
+ * fed in pieces. scan(buf, base, final) reports source offsets relative to
+ * `base`; with final == false it stops in front of a control sequence that the
+ * end of `buf` may have cut short (\, \'h, \word, \word12, \uN and its
+ * fallback char) and returns how many bytes it consumed. The caller passes the
+ * unconsumed tail again, with more input appended.
+ */
+template <class Handler>
+class RtfScanner
+{
+public:
+    explicit RtfScanner(Handler& h) : h_(h) {}
+
+    size_t scan(std::string_view rtf, size_t base, bool final);
+
+    // Set once the handler's done() stopped the scan.
+    bool stopped() const { return stopped_; }
+
+    std::size_t openGroups() const { return st_.depth(); }
+
+private:
+    Handler& h_;
+    RtfGroupStack st_;
+    bool stopped_ = false;
+};
+
+template <class Handler>
+size_t RtfScanner<Handler>::scan(std::string_view rtf, size_t base, bool final)
+{
+    Handler& h = h_;
+    RtfGroupStack& st = st_;
+
+    for (size_t i = 0; i < rtf.size(); ++i) {
+        const unsigned char ch = static_cast<unsigned char>(rtf[i]);
+
+        if (ch == '{') {
+            st.push();
+            continue;
+        }
+        if (ch == '}') {
+            if (!st.pop()) {
+                if constexpr (requires { h.unmatchedClose(); })
+                    h.unmatchedClose();
+            }
+            continue;
+        }
+
+        if (ch != '\\') {
+            if (ch == '\n') {
+                if (!st.top().hide) {
+                    h.lineBreak();
+                    if (h.done()) {
+                        stopped_ = true;
+                        return rtf.size();
+                    }
+                }
+                continue;
+            }
+            if (ch == '\r') {
+                continue;
+            }
+
+            if (st.top().hide)
+                continue;
+
+            // Hot path: hand runs of printable ASCII over in one call.
+            if (is_plain_ascii(ch)) {
+                size_t j = i + 1;
+                while (j < rtf.size() && is_plain_ascii(static_cast<unsigned char>(rtf[j]))) {
+                    ++j;
+                }
+                h.textRun(rtf.substr(i, j - i), st.top(), base + i);
+                i = j - 1;
+                continue;
+            }
+
+            h.text(ch, st.top(), base + i, base + i + 1);
+            continue;
+        }
+
+        // Control sequence
+        if (i + 1 >= rtf.size()) {
+            if (!final)
+                return i;
+            break;
+        }
+
+        // Escaped literal: \\ \{ \}
+        const char next = rtf[i + 1];
+        if (next == '\\' || next == '{' || next == '}') {
+            if (!st.top().hide)
+                h.text(static_cast<unsigned char>(next), st.top(), base + i, base + i + 2);
+            i += 1;
+            continue;
+        }
+
+        // Hex escape: \'hh
+        if (next == '\'' && i + 3 >= rtf.size() && !final)
+            return i;
+        if (next == '\'' && i + 3 < rtf.size()) {
+            const int h1 = hexval(rtf[i + 2]);
+            const int h2 = hexval(rtf[i + 3]);
+            if (h1 >= 0 && h2 >= 0) {
+                const unsigned char b = static_cast<unsigned char>((h1 << 4) | h2);
+                if (!st.top().hide)
+                    h.text(b, st.top(), base + i, base + i + 4);
+                i += 3;
+                continue;
+            }
+        }
+
+        // Parse control word: \word[+/-num]?
+        const size_t start = i;
+        size_t j = i + 1;
+        while (j < rtf.size() && is_alpha(rtf[j])) {
+            ++j;
+        }
+        if (j >= rtf.size() && !final)
+            return start;
+        const std::string_view name = rtf.substr(i + 1, j - (i + 1));
+        const RtfWord word = classify_word(name);
+
+        bool hasParam = false;
+        int sign = 1;
+        int param = 0;
+        if (j < rtf.size() && (rtf[j] == '-' || is_digit(rtf[j]))) {
+            hasParam = true;
+            if (rtf[j] == '-') { sign = -1; ++j; }
+            while (j < rtf.size() && is_digit(rtf[j])) {
+                if (param < 100000000) // saturate absurd digit runs instead of overflowing
+                    param = param * 10 + (rtf[j] - '0');
+                ++j;
+            }
+            param *= sign;
+            if (j >= rtf.size() && !final)
+                return start;
+        }
+
+        // Optional delimiter space after control word
+        if (j < rtf.size() && rtf[j] == ' ')
+            i = j;
+        else
+            i = j - 1;
+
+        RtfGroupState& cur = st.top();
+
+        switch (word) {
+        case RtfWord::Par:
+        case RtfWord::Line:
+            if (!cur.hide) {
+                h.lineBreak();
+                if (h.done()) {
+                    stopped_ = true;
+                    return rtf.size();
+                }
+            }
+            break;
+
+        case RtfWord::Pard:
+            // Paragraph defaults/reset; do NOT create a new line (RTF often does \pard\par).
+            cur.cf = 0;
+            cur.margin = false;
+            break;
+
+        case RtfWord::Tab:
+            if (!cur.hide)
+                h.text('\t', cur, base + start, base + i + 1);
+            break;
+
+        case RtfWord::Cf: if (hasParam) cur.cf = param; break;
+        case RtfWord::Sa: if (hasParam) cur.margin = (param != 0); break;
+        case RtfWord::F:  if (hasParam) cur.phonetic = (param == 1); break;
+        case RtfWord::Qc: cur.hide = true; break;
+
+        case RtfWord::U:
+            if (hasParam && !cur.hide) {
+                // RTF expects a fallback char right after \uN — skip one if present
+                if (i + 1 < rtf.size())
+                    ++i;
+                else if (!final)
+                    return start;
+                h.unicode(param, cur, base + start, base + i + 1);
+            }
+            break;
+
+        case RtfWord::Other:
+            // Everything else ignored for now.
+            if constexpr (requires { h.unknownWord(name); }) {
+                if (!name.empty())
+                    h.unknownWord(name);
+            }
+            break;
+        }
+    }
+    return rtf.size();
+}
+
+template <class Handler>
+static void scan_rtf(std::string_view rtf, Handler& h)
+{
+    RtfScanner<Handler> scanner(h);
+    scanner.scan(rtf, 0, true);
+}
+
+/* --- lint --- */
+
+class LintHandler
+{
+public:
+    explicit LintHandler(RtfLint& total) : total_(total) {}
+
+    void text(unsigned char b, const RtfGroupState& s, size_t, size_t)
+    {
+        if (s.phonetic && b >= 128 && b < 160 && kPhoneticToUtf8[b - 128][0] == '?') {
+            ++counts.unmapped_phonetic;
+            ++total_.unmapped_phonetic_by_slot[b - 128];
+        }
+    }
+    void textRun(std::string_view, const RtfGroupState&, size_t) {}
+    void unicode(int, const RtfGroupState&, size_t, size_t) {}
+    void lineBreak() {}
+    bool done() const { return false; }
+
+    void unknownWord(std::string_view name)
+    {
+        ++counts.unknown_words;
+        ++total_.unknown_words[std::string(name)];
+    }
+    void unmatchedClose() { ++counts.unmatched_closes; }
+
+    RtfLintCounts counts;
+
+private:
+    RtfLint& total_;
+};
+
+RtfLintCounts lintRtf(std::string_view rtf, RtfLint& total)
+{
+    LintHandler h(total);
+    RtfScanner<LintHandler> scanner(h);
+    scanner.scan(rtf, 0, true);
+    h.counts.unclosed_groups = scanner.openGroups();
+
+    total.counts.unmapped_phonetic += h.counts.unmapped_phonetic;
+    total.counts.unknown_words += h.counts.unknown_words;
+    total.counts.unmatched_closes += h.counts.unmatched_closes;
+    total.counts.unclosed_groups += h.counts.unclosed_groups;
+    return h.counts;
+}
+
+void RtfLint::merge(const RtfLint& other)
+{
+    counts.unmapped_phonetic += other.counts.unmapped_phonetic;
+    counts.unknown_words += other.counts.unknown_words;
+    counts.unmatched_closes += other.counts.unmatched_closes;
+    counts.unclosed_groups += other.counts.unclosed_groups;
+    for (std::size_t i = 0; i < 32; ++i) {
+        unmapped_phonetic_by_slot[i] += other.unmapped_phonetic_by_slot[i];
+    }
+    for (const auto& [name, n] : other.unknown_words) {
+        unknown_words[name] += n;
+    }
+}
+
+/*
+ * Line assembly
+ * -------------
+ * Visible text is collected per output line and trimmed; the line's style
+ * (indentation, \cfN) is taken from the state at its first visible byte.
+ * Leading whitespace is dropped as it arrives (indentation comes from \saN),
+ * trailing whitespace when the line is closed. Line breaks are compressed to
+ * at most one empty line and never precede the first line.
+ *
+ * The assembler decodes into storage owned by its sink and hands each closed
+ * line over as a DocLine (+ DocSpans). Sinks:
+ *   DocumentSink          - storage is the Document arena; lines are kept
+ *   FormatSink<F, Out>    - storage is a reused line buffer; each line is
+ *                           formatted right away and the buffer cleared
+ *
+ * Sink::kStyled == false (CLI, plain) compiles out style-run tracking: the
+ * whole line is a single span.
+ */
+template <class Sink>
+class LineAssembler
+{
+public:
+    LineAssembler(Sink& sink, size_t maxLines) : sink_(sink), max_lines_(maxLines) {}
+
+    void text(unsigned char b, const RtfGroupState& s, size_t srcBegin, size_t srcEnd)
+    {
+        // Trim noisy leading whitespace at BOL.
+        if (!line_open_ && (b == ' ' || b == '\t' || b == '\r'))
+            return;
+
+        begin_run(s, srcBegin);
+        append_byte_as_utf8(sink_.text, b, s.phonetic);
+        sink_.spans.back().src_end = static_cast<std::uint32_t>(srcEnd);
+    }
+
+    void textRun(std::string_view run, const RtfGroupState& s, size_t srcBegin)
+    {
+        const size_t srcEnd = srcBegin + run.size();
+        if (!line_open_) {
+            size_t k = 0;
+            while (k < run.size() && run[k] == ' ') {
+                ++k;
+            }
+            run.remove_prefix(k);
+            srcBegin += k;
+            if (run.empty())
+                return;
+        }
+
+        begin_run(s, srcBegin);
+        sink_.text.append(run.data(), run.size());
+        sink_.spans.back().src_end = static_cast<std::uint32_t>(srcEnd);
+    }
+
+    void unicode(int code, const RtfGroupState& s, size_t srcBegin, size_t srcEnd)
+    {
+        begin_run(s, srcBegin);
+        append_unicode_as_utf8(sink_.text, code);
+        sink_.spans.back().src_end = static_cast<std::uint32_t>(srcEnd);
+    }
+
+    void lineBreak()
+    {
+        flush_line();
+        if (done())
+            return;
+
+        // Avoid leading newlines and compress multiple blank lines.
+        if (lines_ == 0 || nl_run_ >= 2)
+            return;
+        sink_.newline();
+        ++nl_run_;
+    }
+
+    bool done() const { return lines_ >= max_lines_; }
+
+    void finish() { flush_line(); }
+
+private:
+    void begin_run(const RtfGroupState& s, size_t srcBegin)
+    {
+        const auto textPos = static_cast<std::uint32_t>(sink_.text.size());
+
+        if (!line_open_) {
+            line_open_ = true;
+            line_ = DocLine{};
+            line_.cf = s.cf;
+            line_.margin = s.margin;
+            line_.text_begin = textPos;
+            line_.span_begin = static_cast<std::uint32_t>(sink_.spans.size());
+            line_.src_begin = static_cast<std::uint32_t>(srcBegin);
+        } else {
+            if constexpr (!Sink::kStyled) {
+                return;
+            } else {
+                DocSpan& last = sink_.spans.back();
+                if (last.cf == s.cf && last.phonetic == s.phonetic)
+                    return;
+                last.text_end = textPos;
+            }
+        }
+
+        DocSpan span;
+        span.text_begin = textPos;
+        span.src_begin = static_cast<std::uint32_t>(srcBegin);
+        span.cf = s.cf;
+        span.phonetic = s.phonetic;
+        sink_.spans.push_back(span);
+    }
+
+    void flush_line()
+    {
+        if (!line_open_)
+            return;
+        line_open_ = false;
+
+        // Trim trailing whitespace, dropping runs that become empty.
+        std::string& text = sink_.text;
+        std::vector<DocSpan>& spans = sink_.spans;
+
+        size_t end = text.size();
+        while (end > line_.text_begin && is_line_ws(text[end - 1])) {
+            --end;
+        }
+        text.resize(end);
+
+        const auto textEnd = static_cast<std::uint32_t>(end);
+        while (spans.size() > line_.span_begin && spans.back().text_begin >= textEnd) {
+            spans.pop_back();
+        }
+        if (spans.size() == line_.span_begin)
+            return; // whitespace-only line: emits nothing
+
+        spans.back().text_end = textEnd;
+
+        line_.text_end = textEnd;
+        line_.span_end = static_cast<std::uint32_t>(spans.size());
+        line_.src_end = spans.back().src_end;
+
+        const std::string_view t(text.data() + line_.text_begin, line_.text_end - line_.text_begin);
+        if (line_.cf == 2 && is_pos_heading(t))
+            line_.kind = LineKind::Pos;
+        else if (lines_ == 0)
+            line_.kind = LineKind::Head;
+        else if (line_.margin)
+            line_.kind = LineKind::Example;
+        else
+            line_.kind = LineKind::Sense;
+
+        sink_.line(line_);
+        ++lines_;
+        nl_run_ = 0;
+    }
+
+    Sink& sink_;
+    size_t max_lines_ = 0;
+    size_t lines_ = 0;  // lines handed to the sink so far
+    DocLine line_{};
+    bool line_open_ = false;
+    int nl_run_ = 0;    // consecutive line breaks already emitted after the last line
+};
+
+struct DocumentSink
+{
+    static constexpr bool kStyled = true;
+
+    explicit DocumentSink(Document& d) : doc(d), text(d.text), spans(d.spans) {}
+
+    void line(const DocLine& l) { doc.lines.push_back(l); }
+    void newline() { ++doc.lines.back().newlines_after; }
+
+    Document& doc;
+    std::string& text;
+    std::vector<DocSpan>& spans;
+};
+
+// Group lines into POS blocks -> senses -> examples.
+static void build_outline(Document& doc)
+{
+    constexpr std::uint32_t kNone = Document::kNone;
+
+    auto ensure_block = [&]() {
+        if (!doc.blocks.empty())
+            return;
+        const auto s = static_cast<std::uint32_t>(doc.senses.size());
+        doc.blocks.push_back(DocBlock{kNone, s, s});
+    };
+    auto add_sense = [&](std::uint32_t line) {
+        ensure_block();
+        const auto e = static_cast<std::uint32_t>(doc.examples.size());
+        doc.senses.push_back(DocSense{line, e, e});
+        doc.blocks.back().sense_end = static_cast<std::uint32_t>(doc.senses.size());
+    };
+
+    for (std::uint32_t i = 0; i < doc.lines.size(); ++i) {
+        switch (doc.lines[i].kind) {
+        case LineKind::Head:
+            doc.head_line = i;
+            break;
+        case LineKind::Pos: {
+            const auto s = static_cast<std::uint32_t>(doc.senses.size());
+            doc.blocks.push_back(DocBlock{i, s, s});
+            break;
+        }
+        case LineKind::Sense:
+            add_sense(i);
+            break;
+        case LineKind::Example:
+            ensure_block();
+            if (doc.blocks.back().sense_begin == doc.blocks.back().sense_end)
+                add_sense(kNone);
+            doc.examples.push_back(i);
+            doc.senses.back().example_end = static_cast<std::uint32_t>(doc.examples.size());
+            break;
+        }
+    }
+}
+
+Document parseDocument(std::string_view rtf, std::size_t maxLines)
+{
+    Document doc;
+    if (maxLines == 0)
+        return doc;
+    TraceSpan trace("render.parse", "render");
+    YDICT_STATS_TIME(&processStats(), RenderParse);
+    doc.text.reserve(rtf.size());
+
+    DocumentSink sink(doc);
+    LineAssembler<DocumentSink> assembler(sink, maxLines);
+    scan_rtf(rtf, assembler);
+    assembler.finish();
+    build_outline(doc);
+    return doc;
+}
+
+Document parseDocument(std::string_view rtf)
+{
+    return parseDocument(rtf, static_cast<std::size_t>(-1));
+}
+
+/*
+ * Output targets
+ * --------------
+ * Formatters write through one of these, so the same formatter code renders
+ * into a string, into a caller's fixed buffer, or only counts bytes.
+ */
+struct StringOut
+{
+    void append(std::string_view v) { s.append(v.data(), v.size()); }
+    void put(char c) { s.push_back(c); }
+
+    std::string& s;
+};
+
+struct CountOut
+{
+    void append(std::string_view v) { n += v.size(); }
+    void put(char) { ++n; }
+
+    size_t n = 0;
+};
+
+struct BufferOut
+{
+    void append(std::string_view v)
+    {
+        if (n < cap) {
+            const size_t k = std::min(v.size(), cap - n);
+            std::memcpy(dst + n, v.data(), k);
+        }
+        n += v.size();
+    }
+    void put(char c)
+    {
+        if (n < cap)
+            dst[n] = c;
+        ++n;
+    }
+
+    char* dst = nullptr;
+    size_t cap = 0;
+    size_t n = 0; // full output size, may exceed cap
+};
+
+/*
+ * Line formatters
+ * ---------------
+ * Each format is a small class driven line by line:
+ *   begin / beginLine / text (per span) / endLine / newline / end
+ * renderDocument() walks a document and feeds those events; the direct
+ * renderers feed them from the line assembler.
+ *
+ * kStyled: the format looks at span styles (phonetic / \cfN), so the
+ * assembler has to split lines into runs.
+ */
+
+template <class Out>
+static void append_html_escaped(Out& out, std::string_view s)
+{
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        const char* esc = nullptr;
+        switch (s[i]) {
+        case '&': esc = "&amp;";  break;
+        case '<': esc = "&lt;";   break;
+        case '>': esc = "&gt;";   break;
+        case '"': esc = "&quot;"; break;
+        default:  continue;
+        }
+        out.append(s.substr(run, i - run));
+        out.append(esc);
+        run = i + 1;
+    }
+    out.append(s.substr(run));
+}
+
+struct CliFormatter
+{
+    static constexpr bool kStyled = false;
+
+    template <class Out> void begin(Out&) {}
+    template <class Out> void beginLine(Out& out, const DocLine& l)
+    {
+        if (l.margin)
+            out.append("  ");
+        // Historical note: we used to render \cf2 as "- ". Keep it only for non-POS lines.
+        if (l.cf == 2 && l.kind != LineKind::Pos)
+            out.append("- ");
+    }
+    template <class Out> void text(Out& out, std::string_view t, const DocSpan&) { out.append(t); }
+    template <class Out> void endLine(Out&) {}
+    template <class Out> void newline(Out& out) { out.put('\n'); }
+    template <class Out> void end(Out&) {}
+};
+
+struct PlainFormatter
+{
+    static constexpr bool kStyled = false;
+
+    template <class Out> void begin(Out&) {}
+    template <class Out> void beginLine(Out&, const DocLine&) {}
+    template <class Out> void text(Out& out, std::string_view t, const DocSpan&) { out.append(t); }
+    template <class Out> void endLine(Out&) {}
+    template <class Out> void newline(Out& out) { out.put('\n'); }
+    template <class Out> void end(Out&) {}
+};
+
+struct AnsiFormatter
+{
+    static constexpr bool kStyled = true;
+
+    static constexpr const char* kReset = "\x1b[0m";
+    static constexpr const char* kPhonetic = "\x1b[36m"; // cyan
+
+    static const char* lineColor(LineKind k)
+    {
+        switch (k) {
+        case LineKind::Head:    return "\x1b[1m";  // bold
+        case LineKind::Pos:     return "\x1b[32m"; // green
+        case LineKind::Example: return "\x1b[90m"; // grey
+        case LineKind::Sense:   break;
+        }
+        return "";
+    }
+
+    template <class Out> void begin(Out&) {}
+    template <class Out> void beginLine(Out& out, const DocLine& l)
+    {
+        cli.beginLine(out, l);
+        color = lineColor(l.kind);
+        out.append(color);
+    }
+    template <class Out> void text(Out& out, std::string_view t, const DocSpan& s)
+    {
+        if (!s.phonetic) {
+            out.append(t);
+            return;
+        }
+        out.append(kPhonetic);
+        out.append(t);
+        out.append(kReset);
+        out.append(color);
+    }
+    template <class Out> void endLine(Out& out) { out.append(kReset); }
+    template <class Out> void newline(Out& out) { out.put('\n'); }
+    template <class Out> void end(Out&) {}
+
+    CliFormatter cli;
+    const char* color = "";
+};
+
+struct HtmlFormatter
+{
+    static constexpr bool kStyled = true;
+
+    static const char* lineClass(LineKind k)
+    {
+        switch (k) {
+        case LineKind::Head:    return "ydict-head";
+        case LineKind::Pos:     return "ydict-pos";
+        case LineKind::Example: return "ydict-example";
+        case LineKind::Sense:   break;
+        }
+        return "ydict-sense";
+    }
+
+    template <class Out> void begin(Out& out) { out.append("<div class=\"ydict-entry\">\n"); }
+    template <class Out> void beginLine(Out& out, const DocLine& l)
+    {
+        out.append("<p class=\"");
+        out.append(lineClass(l.kind));
+        out.append("\">");
+    }
+    template <class Out> void text(Out& out, std::string_view t, const DocSpan& s)
+    {
+        if (s.phonetic) {
+            out.append("<span class=\"ydict-phonetic\">");
+            append_html_escaped(out, t);
+            out.append("</span>");
+        } else {
+            append_html_escaped(out, t);
+        }
+    }
+    template <class Out> void endLine(Out& out) { out.append("</p>\n"); }
+    template <class Out> void newline(Out&) {}
+    template <class Out> void end(Out& out) { out.append("</div>\n"); }
+};
+
+template <class Formatter, class Out>
+static void render_lines(const Document& doc, Formatter fmt, Out& out)
+{
+    fmt.begin(out);
+    for (const DocLine& l : doc.lines) {
+        fmt.beginLine(out, l);
+        for (std::uint32_t s = l.span_begin; s < l.span_end; ++s) {
+            const DocSpan& span = doc.spans[s];
+            fmt.text(out, doc.spanText(span), span);
+        }
+        fmt.endLine(out);
+        for (int k = 0; k < l.newlines_after; ++k) {
+            fmt.newline(out);
+        }
+    }
+    fmt.end(out);
+}
+
+static void append_json_line(std::string& out, const Document& doc, std::uint32_t line)
+{
+    if (line == Document::kNone) {
+        out += "null";
+        return;
+    }
+    appendJsonString(out, doc.lineText(doc.lines[line]));
+}
+
+static void render_json(const Document& doc, std::string& out)
+{
+    out += "{\"headword\":";
+    appendJsonString(out, doc.headword());
+
+    out += ",\"phonetics\":[";
+    bool first = true;
+    for (std::string_view p : doc.phonetics()) {
+        if (!first) out.push_back(',');
+        first = false;
+        appendJsonString(out, p);
+    }
+    out += "]";
+
+    out += ",\"blocks\":[";
+    for (size_t b = 0; b < doc.blocks.size(); ++b) {
+        const DocBlock& block = doc.blocks[b];
+        if (b) out.push_back(',');
+        out += "{\"pos\":";
+        append_json_line(out, doc, block.pos_line);
+        out += ",\"senses\":[";
+        for (std::uint32_t s = block.sense_begin; s < block.sense_end; ++s) {
+            const DocSense& sense = doc.senses[s];
+            if (s != block.sense_begin) out.push_back(',');
+            out += "{\"text\":";
+            append_json_line(out, doc, sense.line);
+            out += ",\"examples\":[";
+            for (std::uint32_t e = sense.example_begin; e < sense.example_end; ++e) {
+                if (e != sense.example_begin) out.push_back(',');
+                append_json_line(out, doc, doc.examples[e]);
+            }
+            out += "]}";
+        }
+        out += "]}";
+    }
+    out += "]}\n";
+}
+
+std::string renderDocument(const Document& doc, OutputFormat fmt)
+{
+    TraceSpan trace("render.format", "render");
+    YDICT_STATS_TIME(&processStats(), RenderFormat);
+    std::string out;
+    out.reserve(doc.text.size() + doc.lines.size() * 4 + 64);
+
+    StringOut so{out};
+    switch (fmt) {
+    case OutputFormat::Cli:   render_lines(doc, CliFormatter{}, so);   break;
+    case OutputFormat::Plain: render_lines(doc, PlainFormatter{}, so); break;
+    case OutputFormat::Ansi:  render_lines(doc, AnsiFormatter{}, so);  break;
+    case OutputFormat::Html:  render_lines(doc, HtmlFormatter{}, so);  break;
+    case OutputFormat::Json:  render_json(doc, out);                   break;
+    }
+    return out;
+}
+
+/*
+ * Direct rendering (RTF -> one format, no Document)
+ * -------------------------------------------------
+ * One instantiation per (formatter, output target): the scanner, assembler
+ * and formatter inline into a single loop with the format's unused branches
+ * compiled out.
+ */
+template <class Formatter, class Out>
+struct FormatSink
+{
+    static constexpr bool kStyled = Formatter::kStyled;
+
+    void line(const DocLine& l)
+    {
+        fmt.beginLine(out, l);
+        for (std::uint32_t s = l.span_begin; s < l.span_end; ++s) {
+            const DocSpan& span = spans[s];
+            fmt.text(out, std::string_view(text).substr(span.text_begin, span.text_end - span.text_begin), span);
+        }
+        fmt.endLine(out);
+
+        text.clear();
+        spans.clear();
+    }
+    void newline() { fmt.newline(out); }
+
+    Formatter fmt;
+    Out& out;
+    std::string text;
+    std::vector<DocSpan> spans;
+};
+
+template <class Formatter, class Out>
+static void render_direct(std::string_view rtf, Out& out, size_t maxLines)
+{
+    FormatSink<Formatter, Out> sink{Formatter{}, out, {}, {}};
+    sink.text.reserve(256);
+
+    sink.fmt.begin(out);
+    if (maxLines > 0) {
+        LineAssembler<FormatSink<Formatter, Out>> assembler(sink, maxLines);
+        scan_rtf(rtf, assembler);
+        assembler.finish();
+    }
+    sink.fmt.end(out);
+}
+
+template <class Out>
+static void render_rtf_to(std::string_view rtf, OutputFormat fmt, Out& out, size_t maxLines)
+{
+    switch (fmt) {
+    case OutputFormat::Cli:   render_direct<CliFormatter>(rtf, out, maxLines);   return;
+    case OutputFormat::Plain: render_direct<PlainFormatter>(rtf, out, maxLines); return;
+    case OutputFormat::Ansi:  render_direct<AnsiFormatter>(rtf, out, maxLines);  return;
+    case OutputFormat::Html:  render_direct<HtmlFormatter>(rtf, out, maxLines);  return;
+    case OutputFormat::Json: {
+        // The JSON outline needs every line before it can be written.
+        std::string json;
+        render_json(parseDocument(rtf, maxLines), json);
+        out.append(json);
+        return;
+    }
+    }
+}
+
+std::string renderRtf(std::string_view rtf, OutputFormat fmt, std::size_t maxLines)
+{
+    TraceSpan trace("render", "render");
+    YDICT_STATS_TIME(&processStats(), RenderDirect);
+    std::string out;
+    out.reserve(rtf.size());
+
+    StringOut so{out};
+    render_rtf_to(rtf, fmt, so, maxLines);
+    return out;
+}
+
+std::string renderRtf(std::string_view rtf, OutputFormat fmt)
+{
+    return renderRtf(rtf, fmt, static_cast<std::size_t>(-1));
+}
+
+std::size_t measureRtf(std::string_view rtf, OutputFormat fmt)
+{
+    YDICT_STATS_TIME(&processStats(), RenderDirect);
+    CountOut co;
+    render_rtf_to(rtf, fmt, co, static_cast<size_t>(-1));
+    return co.n;
+}
+
+std::size_t renderRtfTo(std::string_view rtf, OutputFormat fmt, char* dst, std::size_t cap)
+{
+    YDICT_STATS_TIME(&processStats(), RenderDirect);
+    BufferOut bo{dst, dst ? cap : 0, 0};
+    render_rtf_to(rtf, fmt, bo, static_cast<size_t>(-1));
+    return bo.n;
+}
+
+/*
+ * Streaming rendering
+ * -------------------
+ * The same scanner/assembler/formatter pipeline as render_direct(), kept alive
+ * between feed() calls. Formatted output collects in a small buffer that is
+ * handed to the caller's sink whenever it passes kStreamFlushBytes.
+ *
+ * A control sequence cut by a chunk boundary is carried over in `pending_`
+ * and completed from the next chunk, kCarryBytes at a time.
+ */
+static constexpr size_t kStreamFlushBytes = 16 * 1024;
+static constexpr size_t kCarryBytes = 64;
+
+struct SinkOut
+{
+    void append(std::string_view v)
+    {
+        buf.append(v.data(), v.size());
+        if (buf.size() >= kStreamFlushBytes)
+            flush();
+    }
+    void put(char c)
+    {
+        buf.push_back(c);
+        if (buf.size() >= kStreamFlushBytes)
+            flush();
+    }
+    void flush()
+    {
+        if (!buf.empty())
+            sink(buf);
+        buf.clear();
+    }
+
+    const RtfStreamRenderer::Sink& sink;
+    std::string buf;
+};
+
+/*
+ * A cut control sequence can be arbitrarily long in malformed input
+ * (\aaaa..., \cf0000...). Rewrite it into an equivalent short form so the
+ * carry-over stays bounded: classify_word() only tells words of up to four
+ * letters apart, and only the (saturated) value of the digits matters.
+ * Returns the number of bytes removed.
+ */
+static size_t compact_control(std::string& seq)
+{
+    constexpr size_t kMaxSeq = 32;
+    if (seq.size() <= kMaxSeq)
+        return 0;
+
+    size_t j = 1;
+    while (j < seq.size() && is_alpha(seq[j])) {
+        ++j;
+    }
+    std::string out(seq, 0, std::min<size_t>(j, 6));
+
+    if (j < seq.size() && seq[j] == '-')
+        out += seq[j++];
+    if (j < seq.size() && is_digit(seq[j])) {
+        int param = 0;
+        for (; j < seq.size() && is_digit(seq[j]); ++j) {
+            if (param < 100000000)
+                param = param * 10 + (seq[j] - '0');
+        }
+        out += std::to_string(param);
+    }
+    out.append(seq, j, std::string::npos);
+
+    const size_t removed = seq.size() - out.size();
+    seq.swap(out);
+    return removed;
+}
+
+struct RtfStreamRenderer::Impl
+{
+    virtual ~Impl() = default;
+    virtual bool feed(std::string_view chunk) = 0;
+    virtual void finish() = 0;
+};
+
+template <class Formatter>
+class StreamRenderImpl final : public RtfStreamRenderer::Impl
+{
+public:
+    StreamRenderImpl(const RtfStreamRenderer::Sink& sink, size_t maxLines)
+        : out_{sink, {}},
+          sink_{Formatter{}, out_, {}, {}},
+          assembler_(sink_, maxLines),
+          scanner_(assembler_),
+          max_lines_(maxLines)
+    {
+        out_.buf.reserve(kStreamFlushBytes + 256);
+        sink_.text.reserve(256);
+        sink_.fmt.begin(out_);
+    }
+
+    bool feed(std::string_view chunk) override
+    {
+        if (max_lines_ == 0)
+            return false;
+
+        while (!chunk.empty() && !scanner_.stopped()) {
+            if (pending_.empty()) {
+                const size_t n = scanner_.scan(chunk, pos_, false);
+                pos_ += n;
+                pending_.assign(chunk.substr(n));
+                chunk = {};
+            } else {
+                const size_t take = std::min(chunk.size(), kCarryBytes);
+                pending_.append(chunk.data(), take);
+                chunk.remove_prefix(take);
+
+                const size_t n = scanner_.scan(pending_, pos_, false);
+                pos_ += n;
+                pending_.erase(0, n);
+            }
+            // Bytes dropped from the cut sequence still count for later source offsets.
+            pos_ += compact_control(pending_);
+        }
+        if (scanner_.stopped())
+            pending_.clear();
+        return !scanner_.stopped();
+    }
+
+    void finish() override
+    {
+        if (max_lines_ > 0) {
+            if (!pending_.empty() && !scanner_.stopped())
+                scanner_.scan(pending_, pos_, true);
+            pending_.clear();
+            assembler_.finish();
+        }
+        sink_.fmt.end(out_);
+        out_.flush();
+    }
+
+private:
+    using Sink = FormatSink<Formatter, SinkOut>;
+
+    SinkOut out_;
+    Sink sink_;
+    LineAssembler<Sink> assembler_;
+    RtfScanner<LineAssembler<Sink>> scanner_;
+    size_t max_lines_ = 0;
+    std::string pending_; // cut control sequence carried into the next chunk
+    size_t pos_ = 0;      // source offset of pending_[0] / the next chunk
+};
+
+// The JSON outline needs every line before anything can be written.
+class StreamJsonImpl final : public RtfStreamRenderer::Impl
+{
+public:
+    StreamJsonImpl(const RtfStreamRenderer::Sink& sink, size_t maxLines)
+        : sink_(sink), max_lines_(maxLines) {}
+
+    bool feed(std::string_view chunk) override
+    {
+        rtf_.append(chunk.data(), chunk.size());
+        return true;
+    }
+
+    void finish() override
+    {
+        std::string json;
+        render_json(parseDocument(rtf_, max_lines_), json);
+        sink_(json);
+        rtf_.clear();
+    }
+
+private:
+    const RtfStreamRenderer::Sink& sink_;
+    size_t max_lines_ = 0;
+    std::string rtf_;
+};
+
+RtfStreamRenderer::RtfStreamRenderer(OutputFormat fmt, Sink sink, std::size_t maxLines)
+    : sink_(std::move(sink))
+{
+    switch (fmt) {
+    case OutputFormat::Cli:   impl_ = std::make_unique<StreamRenderImpl<CliFormatter>>(sink_, maxLines);   break;
+    case OutputFormat::Plain: impl_ = std::make_unique<StreamRenderImpl<PlainFormatter>>(sink_, maxLines); break;
+    case OutputFormat::Ansi:  impl_ = std::make_unique<StreamRenderImpl<AnsiFormatter>>(sink_, maxLines);  break;
+    case OutputFormat::Html:  impl_ = std::make_unique<StreamRenderImpl<HtmlFormatter>>(sink_, maxLines);  break;
+    case OutputFormat::Json:  impl_ = std::make_unique<StreamJsonImpl>(sink_, maxLines);                  break;
+    }
+}
+
+RtfStreamRenderer::~RtfStreamRenderer() = default;
+
+bool RtfStreamRenderer::feed(std::string_view chunk)
+{
+    if (finished_)
+        return false;
+#if YDICT_STATS
+    // One render.direct sample per definition: the time of every feed() plus finish().
+    const auto start = std::chrono::steady_clock::now();
+    const bool more = impl_->feed(chunk);
+    render_ns_ += static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    return more;
+#else
+    return impl_->feed(chunk);
+#endif
+}
+
+void RtfStreamRenderer::finish()
+{
+    if (finished_)
+        return;
+    finished_ = true;
+#if YDICT_STATS
+    const auto start = std::chrono::steady_clock::now();
+    impl_->finish();
+    render_ns_ += static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    processStats().record(StatsPhase::RenderDirect, render_ns_);
+#else
+    impl_->finish();
+#endif
+}
+
+std::string renderRtfForCli(std::string_view rtf)
+{
+    return renderRtf(rtf, OutputFormat::Cli);
+}
+
+std::string renderRtfForCli(std::string_view rtf, size_t maxLines)
+{
+    return renderRtf(rtf, OutputFormat::Cli, maxLines);
+}
+
+} // namespace ydict
@@ -0,0 +1,116 @@
+#include "ydict/stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <thread>
+
+namespace ydict {
+
+const char* statsPhaseName(StatsPhase p)
+{
+    switch (p) {
+    case StatsPhase::InitOpen:     return "init.open";
+    case StatsPhase::InitHeader:   return "init.header";
+    case StatsPhase::InitTable:    return "init.table";
+    case StatsPhase::InitDump:     return "init.dump";
+    case StatsPhase::ReadLocate:   return "read.locate";
+    case StatsPhase::ReadBody:     return "read.body";
+    case StatsPhase::FindWord:     return "findWord";
+    case StatsPhase::Suggest:      return "suggest";
+    case StatsPhase::Fuzzy:        return "fuzzy";
+    case StatsPhase::RenderParse:  return "render.parse";
+    case StatsPhase::RenderFormat: return "render.format";
+    case StatsPhase::RenderDirect: return "render.direct";
+    case StatsPhase::Count:        break;
+    }
+    return "?";
+}
+
+const char* statsCounterName(StatsCounter c)
+{
+    switch (c) {
+    case StatsCounter::FindFastHits:     return "findWord.fast_hits";
+    case StatsCounter::FindFallbackHits: return "findWord.fallback_hits";
+    case StatsCounter::FindMisses:       return "findWord.misses";
+    case StatsCounter::SuggestScanned:   return "suggest.scanned";
+    case StatsCounter::FuzzyScanned:     return "fuzzy.scanned";
+    case StatsCounter::ScansTruncated:   return "scans.truncated";
+    case StatsCounter::Count:            break;
+    }
+    return "?";
+}
+
+bool statsPhaseIsProcessWide(StatsPhase p)
+{
+    return p == StatsPhase::RenderParse || p == StatsPhase::RenderFormat || p == StatsPhase::RenderDirect;
+}
+
+std::uint64_t LatencySummary::percentileNs(double q) const
+{
+    if (count == 0)
+        return 0;
+
+    const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(count);
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < kLatencyBuckets; ++b) {
+        seen += buckets[b];
+        if (seen > 0 && static_cast<double>(seen) >= rank) {
+            const std::uint64_t upper = b + 1 < 64 ? (std::uint64_t(1) << (b + 1)) - 1 : ~std::uint64_t(0);
+            return std::min(upper, max_ns);
+        }
+    }
+    return max_ns;
+}
+
+std::size_t StatsCollector::shardIndex()
+{
+    thread_local const std::size_t shard = std::hash<std::thread::id>{}(std::this_thread::get_id()) % kShards;
+    return shard;
+}
+
+void StatsCollector::record(StatsPhase p, std::uint64_t ns)
+{
+    PhaseCells& c = shards_[shardIndex()].phases[static_cast<std::size_t>(p)];
+    const std::size_t bucket = std::min<std::size_t>(ns ? std::bit_width(ns) - 1 : 0, kLatencyBuckets - 1);
+
+    c.count.fetch_add(1, std::memory_order_relaxed);
+    c.total_ns.fetch_add(ns, std::memory_order_relaxed);
+    c.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t max = c.max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !c.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void StatsCollector::add(StatsCounter c, std::uint64_t n)
+{
+    shards_[shardIndex()].counters[static_cast<std::size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+}
+
+void StatsCollector::mergeInto(DictionaryStats& out) const
+{
+    for (const Shard& s : shards_) {
+        for (std::size_t p = 0; p < kStatsPhaseCount; ++p) {
+            const PhaseCells& c = s.phases[p];
+            LatencySummary& l = out.phases[p];
+            l.count += c.count.load(std::memory_order_relaxed);
+            l.total_ns += c.total_ns.load(std::memory_order_relaxed);
+            l.max_ns = std::max(l.max_ns, c.max_ns.load(std::memory_order_relaxed));
+            for (std::size_t b = 0; b < kLatencyBuckets; ++b) {
+                l.buckets[b] += c.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+        for (std::size_t k = 0; k < kStatsCounterCount; ++k) {
+            out.counters[k] += s.counters[k].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+StatsCollector& processStats()
+{
+    static StatsCollector collector;
+    return collector;
+}
+
+} // namespace ydict
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Build switch for the instrumentation below (CMake option YDICT_STATS).
+ * With 0 the YDICT_STATS_* macros expand to nothing: no clock reads, no
+ * atomics on any lookup path; Dictionary::stats() then reports enabled=false.
+ */
+#ifndef YDICT_STATS
+#define YDICT_STATS 0
+#endif
+
+namespace ydict {
+
+/*
+ * Instrumented phases
+ * -------------------
+ * Per-Dictionary phases cover init() and definition reads (the .dat is opened
+ * once by init(), so a read is: locate the record, then read its body) and
+ * the index queries. Render phases are process-wide: the renderers are free
+ * functions and do not know which dictionary the RTF came from.
+ */
+enum class StatsPhase : std::uint8_t {
+    InitOpen,       // open the .dat, read the .idx
+    InitHeader,     // stat the sources, check an existing shared index image
+    InitTable,      // parse the .idx word table (and publish the shared image)
+    InitDump,       // optional idx dump
+    ReadLocate,     // validate offset + read the u32 length prefix
+    ReadBody,       // read (or copy) the RTF bytes
+    FindWord,
+    Suggest,
+    Fuzzy,
+    RenderParse,    // parseDocument() (also inside render.direct for Json)
+    RenderFormat,   // renderDocument()
+    RenderDirect,   // renderRtf(), renderRtfTo(), measureRtf(), RtfStreamRenderer
+    Count
+};
+
+enum class StatsCounter : std::uint8_t {
+    FindFastHits,       // findWord() answered by the binary search
+    FindFallbackHits,   // ... only by the linear fallback scan (index not in byte order)
+    FindMisses,
+    SuggestScanned,     // index entries suggest() looked at
+    FuzzyScanned,       // ... fuzzy() ran the edit distance on
+    ScansTruncated,     // suggest()/fuzzy() calls stopped by their QueryBudget
+    Count
+};
+
+constexpr std::size_t kStatsPhaseCount = static_cast<std::size_t>(StatsPhase::Count);
+constexpr std::size_t kStatsCounterCount = static_cast<std::size_t>(StatsCounter::Count);
+
+// Bucket b counts samples in [2^b, 2^(b+1)) ns (bucket 0 also holds 0 ns); the last one is open-ended.
+constexpr std::size_t kLatencyBuckets = 40;
+
+const char* statsPhaseName(StatsPhase p);       // "init.open", "read.body", ...
+const char* statsCounterName(StatsCounter c);   // "findWord.fast_hits", ...
+bool statsPhaseIsProcessWide(StatsPhase p);     // the render phases
+
+struct LatencySummary {
+    std::uint64_t count = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+    std::array<std::uint64_t, kLatencyBuckets> buckets{};
+
+    // Upper edge of the bucket holding quantile q in [0, 1], capped at max_ns (0 if empty).
+    std::uint64_t percentileNs(double q) const;
+};
+
+struct DictionaryStats {
+    bool enabled = false;       // built with YDICT_STATS
+    std::array<LatencySummary, kStatsPhaseCount> phases{};
+    std::array<std::uint64_t, kStatsCounterCount> counters{};
+
+    const LatencySummary& phase(StatsPhase p) const { return phases[static_cast<std::size_t>(p)]; }
+    std::uint64_t counter(StatsCounter c) const { return counters[static_cast<std::size_t>(c)]; }
+};
+
+/*
+ * Thread-safe accumulator behind DictionaryStats. Writers pick one of a few
+ * cache-line-aligned shards by thread, so server workers rarely touch the
+ * same lines; everything is relaxed atomics, and mergeInto() sums the shards
+ * (a snapshot taken under load may be a few samples apart between fields).
+ */
+class StatsCollector {
+public:
+    void record(StatsPhase p, std::uint64_t ns);
+    void add(StatsCounter c, std::uint64_t n);
+
+    // Adds this collector's totals into `out` (phases and counters).
+    void mergeInto(DictionaryStats& out) const;
+
+private:
+    static constexpr std::size_t kShards = 8;
+
+    struct PhaseCells {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> total_ns{0};
+        std::atomic<std::uint64_t> max_ns{0};
+        std::array<std::atomic<std::uint64_t>, kLatencyBuckets> buckets{};
+    };
+
+    struct alignas(64) Shard {
+        std::array<PhaseCells, kStatsPhaseCount> phases{};
+        std::array<std::atomic<std::uint64_t>, kStatsCounterCount> counters{};
+    };
+
+    static std::size_t shardIndex();
+
+    std::array<Shard, kShards> shards_{};
+};
+
+// Collector for the process-wide (render) phases.
+StatsCollector& processStats();
+
+// Times the enclosing scope into `collector` (nothing if it is null).
+class PhaseTimer {
+public:
+    PhaseTimer(StatsCollector* collector, StatsPhase phase)
+        : collector_(collector), phase_(phase), start_(std::chrono::steady_clock::now())
+    {
+    }
+    ~PhaseTimer()
+    {
+        if (collector_) {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+            collector_->record(phase_, static_cast<std::uint64_t>(ns.count()));
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    StatsCollector* collector_;
+    StatsPhase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace ydict
+
+// Library-internal hooks; compiled out entirely unless YDICT_STATS is set.
+#define YDICT_STATS_CAT2(a, b) a##b
+#define YDICT_STATS_CAT(a, b) YDICT_STATS_CAT2(a, b)
+
+#if YDICT_STATS
+#define YDICT_STATS_TIME(collector, phase) \
+    ::ydict::PhaseTimer YDICT_STATS_CAT(ydict_phase_timer_, __LINE__)((collector), ::ydict::StatsPhase::phase)
+#define YDICT_STATS_ADD(collector, counter, n)                                     \
+    do {                                                                           \
+        if (::ydict::StatsCollector* ydict_stats_c_ = (collector))                 \
+            ydict_stats_c_->add(::ydict::StatsCounter::counter, (n));              \
+    } while (0)
+#else
+#define YDICT_STATS_TIME(collector, phase) static_cast<void>(0)
+#define YDICT_STATS_ADD(collector, counter, n) static_cast<void>(0)
+#endif
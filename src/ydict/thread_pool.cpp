@@ -0,0 +1,69 @@
+#include "ydict/thread_pool.h"
+#include "ydict/trace.h"
+
+#include <utility>
+
+namespace ydict {
+
+std::size_t ThreadPool::defaultThreads()
+{
+    const unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+    if (threads == 0)
+        threads = defaultThreads();
+
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& t : workers_) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        tasks_.push_back(Task{std::move(task), traceEnabled() ? traceNowNs() : 0});
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    traceThreadName("pool worker");
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return; // stopping and drained
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        // Time spent waiting for a worker shows up as its own span before the task.
+        if (task.queued_ns != 0 && traceEnabled()) {
+            const std::uint64_t now = traceNowNs();
+            traceAsync("pool.queued", "pool", task.queued_ns, now - task.queued_ns);
+        }
+        TraceSpan trace("pool.task", "pool");
+        task.fn();
+    }
+}
+
+} // namespace ydict
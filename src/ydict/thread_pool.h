@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ydict {
+
+/*
+ * Fixed-size worker pool
+ * ----------------------
+ * Tasks run in submission order on `threads` workers. The destructor finishes
+ * every queued task before joining. parallelFor() splits an index range over
+ * the workers and the calling thread and returns once all indices are done.
+ */
+class ThreadPool {
+public:
+    // threads == 0: one worker per hardware thread.
+    explicit ThreadPool(std::size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const { return workers_.size(); }
+
+    void submit(std::function<void()> task);
+
+    // Run fn(i) for every i in [0, n); indices are claimed one at a time, so
+    // slow items do not hold up a whole slice.
+    template <class Fn>
+    void parallelFor(std::size_t n, Fn&& fn);
+
+    static std::size_t defaultThreads();
+
+private:
+    void workerLoop();
+
+    struct Task {
+        std::function<void()> fn;
+        std::uint64_t queued_ns = 0;    // trace clock at submit(), 0 when not tracing
+    };
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+template <class Fn>
+void ThreadPool::parallelFor(std::size_t n, Fn&& fn)
+{
+    if (n == 0)
+        return;
+
+    std::atomic<std::size_t> next{0};
+    auto drain = [&]() {
+        for (std::size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+
+    // Helpers reference this frame, so wait for all of them, not just for the indices.
+    const std::size_t helpers = std::min(size(), n - 1);
+    std::mutex doneMu;
+    std::condition_variable doneCv;
+    std::size_t done = 0;
+
+    for (std::size_t h = 0; h < helpers; ++h) {
+        submit([&]() {
+            drain();
+            std::lock_guard<std::mutex> lock(doneMu);
+            if (++done == helpers)
+                doneCv.notify_one();
+        });
+    }
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(doneMu);
+    doneCv.wait(lock, [&]() { return done == helpers; });
+}
+
+} // namespace ydict
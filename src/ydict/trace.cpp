@@ -0,0 +1,282 @@
+#include "ydict/trace.h"
+#include "ydict/json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace ydict {
+
+namespace trace_detail {
+std::atomic<bool> g_enabled{false};
+}
+
+struct TraceEvent
+{
+    const char* name;
+    const char* cat;
+    std::uint64_t ts_ns;
+    std::uint64_t dur_ns;
+    std::uint64_t id;           // async spans
+    char ph;                    // 'X' complete, 'i' instant, 'A' async (written as a b/e pair)
+    std::uint8_t detail_len;
+    char detail[38];
+};
+
+static_assert(kTraceEventsPerThread > 0 && (kTraceEventsPerThread & (kTraceEventsPerThread - 1)) == 0,
+              "kTraceEventsPerThread must be a power of two");
+
+/*
+ * One thread's ring. Only the owning thread writes events and `head`; the
+ * release store of `head` publishes the slot written before it.
+ */
+struct ThreadBuffer
+{
+    std::uint64_t tid = 0;
+    std::atomic<const char*> name{nullptr};
+    std::unique_ptr<TraceEvent[]> ring = std::make_unique<TraceEvent[]>(kTraceEventsPerThread);
+    std::atomic<std::uint64_t> head{0};     // events ever written
+};
+
+static std::mutex g_mu;                                         // guards the fields below
+static std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;    // never shrinks: threads keep raw pointers
+static std::string g_path;
+static bool g_started = false;
+
+static std::atomic<std::int64_t> g_epoch_ns{0};
+static std::atomic<std::uint64_t> g_next_async_id{1};
+
+static thread_local ThreadBuffer* t_buffer = nullptr;
+
+static std::int64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::uint64_t current_tid()
+{
+#if defined(_WIN32)
+    return GetCurrentThreadId();
+#elif defined(__linux__)
+    return static_cast<std::uint64_t>(::syscall(SYS_gettid));
+#else
+    static std::atomic<std::uint64_t> next{1};
+    thread_local const std::uint64_t tid = next.fetch_add(1);
+    return tid;
+#endif
+}
+
+static std::uint64_t current_pid()
+{
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<std::uint64_t>(::getpid());
+#endif
+}
+
+static ThreadBuffer& thread_buffer()
+{
+    if (!t_buffer) {
+        auto buf = std::make_unique<ThreadBuffer>();
+        buf->tid = current_tid();
+        std::lock_guard<std::mutex> lock(g_mu);
+        g_buffers.push_back(std::move(buf));
+        t_buffer = g_buffers.back().get();
+    }
+    return *t_buffer;
+}
+
+// Longest prefix of `s` within `max` bytes that does not split a UTF-8 sequence.
+static std::size_t utf8_prefix(std::string_view s, std::size_t max)
+{
+    if (s.size() <= max)
+        return s.size();
+    std::size_t n = max;
+    // Cut in front of the code point straddling the limit (at most 3 continuation bytes back).
+    while (n > 0 && max - n < 3 && (static_cast<unsigned char>(s[n]) & 0xC0) == 0x80) {
+        --n;
+    }
+    return (static_cast<unsigned char>(s[n]) & 0xC0) == 0x80 ? max : n;
+}
+
+static void push_event(char ph, const char* name, const char* cat, std::uint64_t ts, std::uint64_t dur,
+                       std::string_view detail)
+{
+    ThreadBuffer& b = thread_buffer();
+    const std::uint64_t h = b.head.load(std::memory_order_relaxed);
+    TraceEvent& e = b.ring[h & (kTraceEventsPerThread - 1)];
+    e.name = name;
+    e.cat = cat;
+    e.ts_ns = ts;
+    e.dur_ns = dur;
+    e.id = ph == 'A' ? g_next_async_id.fetch_add(1, std::memory_order_relaxed) : 0;
+    e.ph = ph;
+    e.detail_len = static_cast<std::uint8_t>(utf8_prefix(detail, sizeof(e.detail)));
+    std::memcpy(e.detail, detail.data(), e.detail_len);
+    b.head.store(h + 1, std::memory_order_release);
+}
+
+static void append_event_json(std::string& out, const TraceEvent& e, std::uint64_t pid, std::uint64_t tid,
+                              char asyncPhase = 0)
+{
+    char num[128];
+    out += "{\"name\":";
+    appendJsonString(out, e.name);
+    out += ",\"cat\":";
+    appendJsonString(out, e.cat);
+    if (asyncPhase != 0) {
+        const std::uint64_t ts = asyncPhase == 'b' ? e.ts_ns : e.ts_ns + e.dur_ns;
+        std::snprintf(num, sizeof(num), ",\"ph\":\"%c\",\"id\":%llu,\"ts\":%.3f", asyncPhase,
+                      static_cast<unsigned long long>(e.id), ts / 1e3);
+    } else if (e.ph == 'X') {
+        std::snprintf(num, sizeof(num), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", e.ts_ns / 1e3, e.dur_ns / 1e3);
+    } else {
+        std::snprintf(num, sizeof(num), ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", e.ts_ns / 1e3);
+    }
+    out += num;
+    std::snprintf(num, sizeof(num), ",\"pid\":%llu,\"tid\":%llu", static_cast<unsigned long long>(pid),
+                  static_cast<unsigned long long>(tid));
+    out += num;
+    if (e.detail_len > 0) {
+        out += ",\"args\":{\"detail\":";
+        appendJsonString(out, std::string_view(e.detail, e.detail_len));
+        out += '}';
+    }
+    out += '}';
+}
+
+bool traceStart(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(g_mu);
+    if (g_started)
+        return false;
+
+    for (const auto& b : g_buffers) {
+        b->head.store(0, std::memory_order_relaxed);
+    }
+    g_path = path;
+    g_started = true;
+    g_epoch_ns.store(steady_ns(), std::memory_order_relaxed);
+    trace_detail::g_enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+bool traceStop(std::string* why)
+{
+    trace_detail::g_enabled.store(false, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(g_mu);
+    if (!g_started) {
+        if (why)
+            *why = "trace not started";
+        return false;
+    }
+    g_started = false;
+
+    const std::uint64_t pid = current_pid();
+    std::uint64_t dropped = 0;
+    std::string out;
+    out += "{\"traceEvents\":[\n";
+    char meta[160];
+    std::snprintf(meta, sizeof(meta),
+                  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%llu,\"tid\":0,\"args\":{\"name\":\"ydict\"}}",
+                  static_cast<unsigned long long>(pid));
+    out += meta;
+
+    for (const auto& b : g_buffers) {
+        const std::uint64_t head = b->head.load(std::memory_order_acquire);
+        if (head == 0)
+            continue;
+        if (const char* name = b->name.load(std::memory_order_relaxed)) {
+            std::snprintf(meta, sizeof(meta), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%llu,\"tid\":%llu,\"args\":{\"name\":",
+                          static_cast<unsigned long long>(pid), static_cast<unsigned long long>(b->tid));
+            out += meta;
+            appendJsonString(out, name);
+            out += "}}";
+        }
+
+        const std::uint64_t first = head > kTraceEventsPerThread ? head - kTraceEventsPerThread : 0;
+        dropped += first;
+        for (std::uint64_t i = first; i < head; ++i) {
+            const TraceEvent& e = b->ring[i & (kTraceEventsPerThread - 1)];
+            out += ",\n";
+            if (e.ph == 'A') {
+                append_event_json(out, e, pid, b->tid, 'b');
+                out += ",\n";
+                append_event_json(out, e, pid, b->tid, 'e');
+            } else {
+                append_event_json(out, e, pid, b->tid);
+            }
+        }
+    }
+
+    char tail[96];
+    std::snprintf(tail, sizeof(tail), "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":%llu}}\n",
+                  static_cast<unsigned long long>(dropped));
+    out += tail;
+
+    std::ofstream f(g_path, std::ios::binary | std::ios::trunc);
+    f.write(out.data(), static_cast<std::streamsize>(out.size()));
+    f.close();
+    if (!f) {
+        if (why)
+            *why = "cannot write " + g_path;
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t traceNowNs()
+{
+    return static_cast<std::uint64_t>(steady_ns() - g_epoch_ns.load(std::memory_order_relaxed));
+}
+
+void traceThreadName(const char* name)
+{
+    if (traceEnabled())
+        thread_buffer().name.store(name, std::memory_order_relaxed);
+}
+
+void traceComplete(const char* name, const char* cat, std::uint64_t startNs, std::uint64_t durNs,
+                   std::string_view detail)
+{
+    if (traceEnabled())
+        push_event('X', name, cat, startNs, durNs, detail);
+}
+
+void traceInstant(const char* name, const char* cat, std::string_view detail)
+{
+    if (traceEnabled())
+        push_event('i', name, cat, traceNowNs(), 0, detail);
+}
+
+void traceAsync(const char* name, const char* cat, std::uint64_t startNs, std::uint64_t durNs,
+                std::string_view detail)
+{
+    if (traceEnabled())
+        push_event('A', name, cat, startNs, durNs, detail);
+}
+
+} // namespace ydict
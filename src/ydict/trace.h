@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ydict {
+
+/*
+ * Trace events (Chrome / Perfetto JSON)
+ * -------------------------------------
+ * Process-wide recorder for spans ("complete" events) and instants, written
+ * as Chrome trace-event JSON that chrome://tracing and ui.perfetto.dev load
+ * directly. Meant for looking at concurrency, queueing and I/O stalls in
+ * the server and batch modes without attaching a profiler.
+ *
+ *   - traceStart() enables recording; until then every hook is one relaxed
+ *     atomic load.
+ *   - Each thread appends to its own fixed-size ring buffer (single writer,
+ *     no locks; registering a thread's buffer takes a mutex once). When a
+ *     ring is full the oldest events are overwritten and counted as dropped.
+ *   - traceStop() disables recording and writes every buffer to the file.
+ *     Call it after the worker threads are done (an event being written
+ *     while it runs may be missing or torn).
+ *
+ * Names and categories must be string literals (only the pointer is kept);
+ * `detail` (a word, a path) is copied, truncated to a few dozen bytes.
+ */
+constexpr std::size_t kTraceEventsPerThread = 16384;
+
+namespace trace_detail {
+extern std::atomic<bool> g_enabled;
+}
+
+inline bool traceEnabled()
+{
+    return trace_detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+// Start recording into `path` (written by traceStop()). False if already started.
+bool traceStart(const std::string& path);
+
+// Stop recording and write the JSON file. False (with `why`) if it cannot be written.
+bool traceStop(std::string* why = nullptr);
+
+// Nanoseconds on the trace clock (steady, since traceStart()).
+std::uint64_t traceNowNs();
+
+// Label the calling thread in the trace ("http worker", ...); a literal, like names.
+void traceThreadName(const char* name);
+
+void traceComplete(const char* name, const char* cat, std::uint64_t startNs, std::uint64_t durNs,
+                   std::string_view detail = {});
+void traceInstant(const char* name, const char* cat, std::string_view detail = {});
+
+// A span that may overlap others on its thread (e.g. time a task sat in a queue); gets its own track.
+void traceAsync(const char* name, const char* cat, std::uint64_t startNs, std::uint64_t durNs,
+                std::string_view detail = {});
+
+// Records the enclosing scope as one span. `detail` must outlive the span.
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* cat, std::string_view detail = {})
+        : name_(name), cat_(cat), detail_(detail), start_(traceEnabled() ? traceNowNs() : kOff)
+    {
+    }
+    ~TraceSpan()
+    {
+        if (start_ != kOff && traceEnabled())
+            traceComplete(name_, cat_, start_, traceNowNs() - start_, detail_);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    static constexpr std::uint64_t kOff = ~std::uint64_t(0);
+
+    const char* name_;
+    const char* cat_;
+    std::string_view detail_;
+    std::uint64_t start_;
+};
+
+} // namespace ydict
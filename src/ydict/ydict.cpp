@@ -1,40 +1,30 @@
 #include "ydict/ydict.h"
+#include "ydict/dat_file.h"
+#include "ydict/trace.h"
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <memory>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
-#ifdef _WIN32
-#include <Windows.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 namespace ydict {
 
-/*
- * Byte->UTF-8 mapping for the dictionary's "phonetic" font stream.
- *
- * In ydpdict RTF, phonetic transcription is emitted using font #1 (\f1).
- * In that mode, bytes in the 0x80..0x9F range are *not* CP1250 letters — they
- * are custom glyph slots used for IPA-like symbols. We translate those 32
- * slots to their intended Unicode characters so the output becomes valid UTF-8.
- *
- * Unknown / unused / not-yet-reverse-engineered slots are left as "?" so we
- * don’t silently emit wrong phonetics; it makes missing mappings obvious
- * during testing.
- */
-static const char* kPhoneticToUtf8[32] = {
-    "?", "?", "ɔ", "ʒ", "?", "ʃ", "ɛ", "ʌ",
-    "ə", "θ", "ɪ", "ɑ", "?", "ː", "ˈ", "?",
-    "ŋ", "?", "?", "?", "?", "?", "?", "ð",
-    "æ", "?", "?", "?", "?", "?", "?", "?"
-};
-
-static bool dump_idx_to_file(const std::string& dumpPath, const std::vector<WordEntry>& words)
+static bool dump_idx_to_file(const std::string& dumpPath, const IndexView& index)
 {
     std::ofstream out(dumpPath, std::ios::binary);
     if (!out)
@@ -44,47 +34,68 @@ static bool dump_idx_to_file(const std::string& dumpPath, const std::vector<Word
      * Simple line-based dump, easy to grep/diff/analyze:
      * i<TAB>datOffset<TAB>word<NL>
      */
-    for (size_t i = 0; i < words.size(); ++i) {
-        out << i << '\t' << words[i].dat_offset << '\t' << words[i].word << '\n';
+    for (size_t i = 0; i < index.size(); ++i) {
+        out << i << '\t' << index.datOffset(i) << '\t' << index.word(i) << '\n';
     }
 
     return true;
 }
 
-static std::uint16_t read_u16_le(std::istream& in)
+static std::uint32_t load_u32_le(const std::byte* p)
 {
-    unsigned char b[2]{};
-    in.read(reinterpret_cast<char*>(b), 2);
-    return static_cast<std::uint16_t>(b[0] | (std::uint16_t(b[1]) << 8));
+    return (std::to_integer<std::uint32_t>(p[0])      ) |
+           (std::to_integer<std::uint32_t>(p[1]) <<  8) |
+           (std::to_integer<std::uint32_t>(p[2]) << 16) |
+           (std::to_integer<std::uint32_t>(p[3]) << 24);
 }
 
-static std::uint32_t read_u32_le(std::istream& in)
+// Size and mtime of one source file, for IndexStamp.
+static bool stat_source(const std::string& path, std::uint64_t& size, std::int64_t& mtimeNs)
 {
-    unsigned char b[4]{};
-    in.read(reinterpret_cast<char*>(b), 4);
-    return (std::uint32_t(b[0])      ) |
-           (std::uint32_t(b[1]) <<  8) |
-           (std::uint32_t(b[2]) << 16) |
-           (std::uint32_t(b[3]) << 24);
+    std::error_code ec;
+    const auto sz = std::filesystem::file_size(path, ec);
+    if (ec)
+        return false;
+    const auto mt = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return false;
+    size = static_cast<std::uint64_t>(sz);
+    mtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(mt.time_since_epoch()).count();
+    return true;
 }
 
-static std::string read_cstr(std::istream& in)
+static bool read_whole_file(const std::string& path, std::vector<std::byte>& out)
 {
-    std::string s;
-    for (;;) {
-        const int c = in.get();
-        if (c == EOF || c == 0) break;
-        s.push_back(static_cast<char>(c));
-    }
-    return s;
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    if (size < 0)
+        return false;
+    in.seekg(0, std::ios::beg);
+
+    out.resize(static_cast<size_t>(size));
+    in.read(reinterpret_cast<char*>(out.data()), size);
+    return in.gcount() == size;
+}
+
+// A fresh collector per init(); none at all in builds without YDICT_STATS.
+static std::unique_ptr<StatsCollector> make_stats_collector()
+{
+#if YDICT_STATS
+    return std::make_unique<StatsCollector>();
+#else
+    return nullptr;
+#endif
 }
 
 bool Dictionary::init(const Config& cfg)
 {
-    initialized_ = false;
-    words_.clear();
-    dat_path_.clear();
-    idx_dump_status_ = IdxDumpStatus{};
+    TraceSpan trace("Dictionary::init", "init", cfg.idx_path);
+    reset();
+    stats_ = make_stats_collector();
 
     if (cfg.idx_path.empty())
         return false;
@@ -92,567 +103,515 @@ bool Dictionary::init(const Config& cfg)
     if (cfg.dat_path.empty())
         return false;
 
-    dat_path_ = cfg.dat_path;
+    // Opened once; every definition read is a positional read on this descriptor.
+    {
+        YDICT_STATS_TIME(stats_.get(), InitOpen);
+        if (!dat_file_.open(cfg.dat_path))
+            return false;
+    }
 
-    // quick sanity check: can we open .dat at all?
-    std::ifstream dat(dat_path_, std::ios::binary);
-    if (!dat)
-        return false;
+    IndexStamp stamp;
+    {
+        YDICT_STATS_TIME(stats_.get(), InitHeader);
+        if (!stat_source(cfg.idx_path, stamp.idx_size, stamp.idx_mtime_ns) ||
+            !stat_source(cfg.dat_path, stamp.dat_size, stamp.dat_mtime_ns)) {
+            dat_file_.close();
+            return false;
+        }
+    }
 
-    std::ifstream idx(cfg.idx_path, std::ios::binary);
-    if (!idx)
+    bool ok = false;
+    if (!cfg.shared_index_path.empty()) {
+        ok = loadSharedIndex(cfg, stamp);
+    } else {
+        // The table is small; one read, then the same parser as initFromMemory().
+        std::vector<std::byte> idx;
+        {
+            YDICT_STATS_TIME(stats_.get(), InitOpen);
+            ok = read_whole_file(cfg.idx_path, idx);
+        }
+        YDICT_STATS_TIME(stats_.get(), InitTable);
+        ok = ok && buildIndexImage(idx, stamp, index_image_) && index_.bind(index_image_);
+    }
+    if (!ok) {
+        reset();
         return false;
+    }
 
-    constexpr std::uint32_t kIdxMagic = 0x8d4e11d5;
-
-    const std::uint32_t magic = read_u32_le(idx);
-    if (!idx || magic != kIdxMagic)
-        return false;
+    dat_path_ = cfg.dat_path;
+    finishInit(cfg);
+    return true;
+}
 
-    idx.seekg(8, std::ios::beg);
-    const std::uint16_t count = read_u16_le(idx);
-    if (!idx)
-        return false;
+/*
+ * Use the shared image if it matches the files just opened; otherwise build
+ * one, publish it for the other processes and map what was published. Any
+ * failure on the shared side leaves this process with its private image.
+ */
+bool Dictionary::loadSharedIndex(const Config& cfg, const IndexStamp& stamp)
+{
+    SharedIndexStatus& st = shared_index_status_;
+    st.requested = true;
+    st.path = cfg.shared_index_path;
+
+    std::string why;
+    {
+        YDICT_STATS_TIME(stats_.get(), InitHeader);
+        if (index_file_.attach(st.path, why)) {
+            if (index_.bind(index_file_.bytes(), &why)) {
+                if (index_.stamp() == stamp) {
+                    st.attached = true;
+                    return true;
+                }
+                why = "stale (built from other .idx/.dat files)";
+            }
+            index_.clear();
+            index_file_.close();
+        }
+    }
+    st.note = why;
 
-    idx.seekg(16, std::ios::beg);
-    const std::uint32_t tableOffset = read_u32_le(idx);
-    if (!idx)
-        return false;
+    std::vector<std::byte> idx;
+    {
+        YDICT_STATS_TIME(stats_.get(), InitOpen);
+        if (!read_whole_file(cfg.idx_path, idx))
+            return false;
+    }
 
-    idx.seekg(tableOffset, std::ios::beg);
-    if (!idx)
+    YDICT_STATS_TIME(stats_.get(), InitTable);
+    if (!buildIndexImage(idx, stamp, index_image_))
         return false;
 
-    words_.reserve(count);
-
-    for (std::uint32_t i = 0; i < count; ++i) {
-        idx.seekg(4, std::ios::cur); // skip unknown 4 bytes
-        const std::uint32_t datOffset = read_u32_le(idx);
-        const std::string word = read_cstr(idx);
+    std::string shareWhy;
+    if (SharedIndexFile::publish(st.path, index_image_, shareWhy) && index_file_.attach(st.path, shareWhy) &&
+        index_.bind(index_file_.bytes(), &shareWhy)) {
+        // Another process may have published in between; fine if it is the same build.
+        if (index_.stamp() == stamp) {
+            st.attached = true;
+            st.rebuilt = true;
+            std::vector<std::byte>().swap(index_image_);
+            return true;
+        }
+        shareWhy = "replaced by another build";
+    }
+    index_.clear();
+    index_file_.close();
 
-        if (!idx)
-            return false;
+    st.note += "; private copy (" + shareWhy + ")";
+    return index_.bind(index_image_);
+}
 
-        words_.push_back(WordEntry{word, datOffset});
+bool Dictionary::initFromMemory(std::span<const std::byte> idx, std::span<const std::byte> dat)
+{
+    TraceSpan trace("Dictionary::initFromMemory", "init");
+    reset();
+    stats_ = make_stats_collector();
+
+    bool ok = false;
+    {
+        YDICT_STATS_TIME(stats_.get(), InitTable);
+        ok = !dat.empty() && buildIndexImage(idx, IndexStamp{}, index_image_) && index_.bind(index_image_);
     }
-
-    // Optional debug artifact (disabled by default).
-    // Useful for analyzing collation/sorting/prefix-search issues.
-    if (!cfg.idx_dump_path.empty()) {
-        idx_dump_status_.requested = true;
-        idx_dump_status_.path = cfg.idx_dump_path;
-        idx_dump_status_.ok = dump_idx_to_file(cfg.idx_dump_path, words_);
+    if (!ok) {
+        reset();
+        return false;
     }
 
-    initialized_ = true;
+    dat_mem_ = dat;
+    dat_in_memory_ = true;
+    finishInit(Config{});
     return true;
 }
 
-std::string Dictionary::version() const
+bool Dictionary::initFromMemory(std::vector<std::byte>&& idx, std::vector<std::byte>&& dat)
 {
-    if (!initialized_)
-        return "ydict - not initialized";
-    return "ydict - idx loaded (" + std::to_string(words_.size()) + " words)";
+    // The word table is copied out of `idx` into the index image; only `dat` is kept.
+    auto owned = std::make_unique<const std::vector<std::byte>>(std::move(dat));
+    if (!initFromMemory(idx, *owned))
+        return false;
+
+    dat_owner_ = std::move(owned);
+    return true;
 }
 
-int Dictionary::wordCount() const
+std::shared_ptr<const Dictionary> Dictionary::open(const Config& cfg)
 {
-    return static_cast<int>(words_.size());
+    auto dict = std::make_shared<Dictionary>();
+    if (!dict->init(cfg))
+        return nullptr;
+    return dict;
 }
 
-const WordEntry* Dictionary::wordAt(int index) const
+std::shared_ptr<const Dictionary> Dictionary::openFromMemory(std::vector<std::byte>&& idx, std::vector<std::byte>&& dat)
 {
-    if (index < 0 || index >= static_cast<int>(words_.size()))
+    auto dict = std::make_shared<Dictionary>();
+    if (!dict->initFromMemory(std::move(idx), std::move(dat)))
         return nullptr;
-    return &words_[index];
+    return dict;
 }
 
-std::string Dictionary::readRtf(int defIndex) const
+void Dictionary::reset()
 {
-    if (!initialized_ || dat_path_.empty())
-        return {};
-
-    if (defIndex < 0 || defIndex >= static_cast<int>(words_.size()))
-        return {};
-
-    std::ifstream dat(dat_path_, std::ios::binary);
-    if (!dat)
-        return {};
-
-    // file size
-    dat.seekg(0, std::ios::end);
-    const std::streamoff fileSize = dat.tellg();
-    if (fileSize <= 0)
-        return {};
-
-    const std::uint32_t offset = words_[defIndex].dat_offset;
-
-    // need at least 4 bytes for length
-    if (static_cast<std::streamoff>(offset) + 4 > fileSize)
-        return {};
-
-    dat.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
-    if (!dat)
-        return {};
-
-    const std::uint32_t len = read_u32_le(dat);
-    if (!dat)
-        return {};
-
-    // sanity limit (RTF definitions should be reasonably small)
-    constexpr std::uint32_t kMaxDefSize = 4u * 1024u * 1024u; // 4 MiB
-    if (len == 0 || len > kMaxDefSize)
-        return {};
-
-    if (static_cast<std::streamoff>(offset) + 4 + static_cast<std::streamoff>(len) > fileSize)
-        return {};
+    initialized_ = false;
+    index_.clear();
+    std::vector<std::byte>().swap(index_image_);
+    index_file_.close();
+    shared_index_status_ = SharedIndexStatus{};
+    dat_path_.clear();
+    dat_file_.close();
+    dat_mem_ = {};
+    dat_owner_.reset();
+    dat_in_memory_ = false;
+    idx_dump_status_ = IdxDumpStatus{};
+    doc_cache_.reset();
+}
 
-    std::string rtf;
-    rtf.resize(len);
+void Dictionary::finishInit(const Config& cfg)
+{
+    // Optional debug artifact (disabled by default).
+    // Useful for analyzing collation/sorting/prefix-search issues.
+    if (!cfg.idx_dump_path.empty()) {
+        idx_dump_status_.requested = true;
+        idx_dump_status_.path = cfg.idx_dump_path;
+        YDICT_STATS_TIME(stats_.get(), InitDump);
+        idx_dump_status_.ok = dump_idx_to_file(cfg.idx_dump_path, index_);
+    }
 
-    dat.read(rtf.data(), static_cast<std::streamsize>(len));
-    if (dat.gcount() != static_cast<std::streamsize>(len))
-        return {};
+    if (cfg.document_cache_entries > 0)
+        doc_cache_ = std::make_unique<DocumentCache>(cfg.document_cache_entries);
 
-    return rtf;
+    initialized_ = true;
 }
 
-/* --- text decoding helpers (used by both RTF->plain and RTF->CLI) --- */
-
-static int hexval(char c)
+DictionaryStats Dictionary::stats() const
 {
-    if (c >= '0' && c <= '9') return c - '0';
-    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
-    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
-    return -1;
+    DictionaryStats out;
+    out.enabled = YDICT_STATS != 0;
+    if (stats_)
+        stats_->mergeInto(out);
+    if (out.enabled)
+        processStats().mergeInto(out);
+    return out;
 }
 
-static void append_cp1250_byte_as_utf8(std::string& out, unsigned char b)
+/*
+ * Page-rounded extent of [p, p+n), and how much of it is resident now.
+ * mincore() works on heap blocks and file mappings alike; elsewhere only
+ * the extent is known.
+ */
+static void page_residency(const void* p, std::size_t n, std::size_t& mapped, std::size_t& resident, bool& known)
 {
-    if (b == 0x7F) { // upstream mapped this to "~"
-        out.push_back('~');
-        return;
-    }
-    if (b < 0x80) {
-        out.push_back(static_cast<char>(b));
+    mapped = resident = 0;
+    known = false;
+    if (!p || n == 0)
         return;
-    }
-
-#ifdef _WIN32
-    wchar_t wbuf[2] = {};
-    const char in = static_cast<char>(b);
-
-    const int wlen = MultiByteToWideChar(1250 /*CP1250*/, MB_ERR_INVALID_CHARS, &in, 1, wbuf, 2);
-    if (wlen <= 0) {
-        out.push_back('?');
-        return;
-    }
-
-    char ubuf[8] = {};
-    const int ulen = WideCharToMultiByte(CP_UTF8, 0, wbuf, wlen, ubuf, int(sizeof(ubuf)), nullptr, nullptr);
-    if (ulen <= 0) {
-        out.push_back('?');
+#ifdef __linux__
+    const auto page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(p) & ~(page - 1);
+    const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(p) + n + page - 1) & ~(page - 1);
+    mapped = end - begin;
+
+    std::vector<unsigned char> vec(mapped / page);
+    if (::mincore(reinterpret_cast<void*>(begin), mapped, vec.data()) != 0)
         return;
+    for (const unsigned char v : vec) {
+        resident += (v & 1) ? page : 0;
     }
-    out.append(ubuf, ubuf + ulen);
+    known = true;
 #else
-    out.push_back('?');
+    mapped = n;
 #endif
 }
 
-static void append_byte_as_utf8(std::string& out, unsigned char b, bool phoneticMode)
+std::size_t MemoryUsage::privateBytes() const
 {
-    if (phoneticMode && b >= 128 && b < 160) {
-        out += kPhoneticToUtf8[b - 128];
-        return;
-    }
-    append_cp1250_byte_as_utf8(out, b);
+    std::size_t n = object_bytes + stats_bytes + doc_cache.document_bytes + doc_cache.overhead_bytes;
+    if (!index_shared)
+        n += index_header_bytes + index_entry_bytes + headword_bytes + headword_nul_bytes + index_slack_bytes;
+    if (dat_memory_owned)
+        n += dat_memory_bytes;
+    return n;
 }
 
-static bool is_alpha(char c)
+MemoryUsage Dictionary::memoryUsage() const
 {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    MemoryUsage u;
+    u.object_bytes = sizeof(Dictionary) + (dat_path_.capacity() > std::string().capacity() ? dat_path_.capacity() + 1 : 0);
+    if (!initialized_)
+        return u;
+
+    u.words = index_.size();
+    if (const IndexImageHeader* h = index_.header()) {
+        u.index_header_bytes = h->header_size;
+        u.index_entry_bytes = std::size_t(h->arena_offset) - h->entries_offset;
+        for (std::size_t i = 0; i < index_.size(); ++i) {
+            u.headword_bytes += index_.word(i).size();
+        }
+        u.headword_nul_bytes = h->arena_size - u.headword_bytes;
+    }
+
+    const std::span<const std::byte> image = index_file_.bytes().empty()
+        ? std::span<const std::byte>(index_image_)
+        : index_file_.bytes();
+    u.index_shared = !index_file_.bytes().empty();
+    if (!u.index_shared)
+        u.index_slack_bytes = index_image_.capacity() - index_image_.size();
+    page_residency(image.data(), image.size(), u.index_mapped_bytes, u.index_resident_bytes, u.resident_known);
+
+    if (dat_in_memory_) {
+        std::size_t mapped = 0;
+        bool known = false;
+        u.dat_memory_bytes = dat_mem_.size();
+        u.dat_memory_owned = dat_owner_ != nullptr;
+        page_residency(dat_mem_.data(), dat_mem_.size(), mapped, u.dat_resident_bytes, known);
+    } else {
+        u.dat_file_bytes = static_cast<std::size_t>(dat_file_.size());
+    }
+
+    if (doc_cache_) {
+        u.object_bytes += sizeof(DocumentCache);
+        u.doc_cache_capacity = doc_cache_->capacity();
+        u.doc_cache = doc_cache_->usage();
+    }
+    if (stats_)
+        u.stats_bytes = sizeof(StatsCollector);
+    return u;
 }
 
-static bool is_digit(char c)
+std::string Dictionary::version() const
 {
-    return (c >= '0' && c <= '9');
+    if (!initialized_)
+        return "ydict - not initialized";
+    return "ydict - idx loaded (" + std::to_string(index_.size()) + " words)";
 }
 
-static std::string_view trim_sv(std::string_view s)
+int Dictionary::wordCount() const
 {
-    size_t b = 0;
-    while (b < s.size() && (s[b] == ' ' || s[b] == '\t' || s[b] == '\r')) {
-        ++b;
-    }
-    size_t e = s.size();
-    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r')) {
-        --e;
-    }
-    return s.substr(b, e - b);
+    return static_cast<int>(index_.size());
 }
 
-static bool is_pos_heading(std::string_view t)
+std::optional<WordEntry> Dictionary::wordAt(int index) const
 {
-    t = trim_sv(t);
-    // Keep it conservative: only known headings should match.
-    return t == "n" ||
-           t == "adj" ||
-           t == "adv" ||
-           t == "vt" ||
-           t == "vi" ||
-           t == "prep" ||
-           t == "pron" ||
-           t == "conj" ||
-           t == "num" ||
-           t == "det" ||
-           t == "modal aux vb";
+    if (index < 0 || index >= wordCount())
+        return std::nullopt;
+    return WordEntry{index_.word(index), index_.datOffset(index)};
 }
 
+// sanity limit (RTF definitions should be reasonably small)
+constexpr std::uint32_t kMaxDefSize = 4u * 1024u * 1024u; // 4 MiB
+
 /*
- * Minimal RTF -> CLI renderer (no colors)
- * --------------------------------------
- * We parse a small subset of the RTF-like stream used by ydpdict and render it
- * into UTF-8 console text, trying to stay close to ydpdict’s *layout* (line
- * breaks / spacing) without relying on the old plain-text heuristics.
- *
- * Important choices:
- *   - We treat \par and \line as line breaks.
- *   - We treat \pard as a paragraph-format reset (no line break).
- *   - We compress excessive blank lines (max one empty line / i.e. max 2 '\n' in a row).
- *   - Some style signals (e.g. \cf2) are used by ydpdict for headings; we avoid
- *     emitting a leading "- " for POS headings like "vt/vi/n/adj".
- *
- * Supported constructs:
- *   - groups: '{' pushes state, '}' pops state
- *   - '\par'/'\line' => newline
- *   - '\saN' => indentation at beginning of line
- *   - '\cfN' => style bucket (used only as a hint; we mostly preserve text)
- *   - '\f1' => phonetic font stream (0x80..0x9F map via kPhoneticToUtf8)
- *   - '\qc' => hidden blocks (ydpdict convention)
- *   - "\'hh" and '\uN' => proper decoding to UTF-8
+ * Definition record (u32 length + RTF bytes) inside an in-memory .dat, with
+ * the same checks as file_definition(). On success `rtf` views the RTF bytes.
  */
-struct RtfCliState
+static bool memory_definition(std::span<const std::byte> dat, std::uint32_t offset, std::string_view& rtf)
 {
-    int  cf = 0;           // \cfN
-    bool phonetic = false; // \f1
-    bool hide = false;     // \qc
-    bool margin = false;   // \saN
-};
-
-std::string renderRtfForCli(std::string_view rtf)
-{
-    std::vector<RtfCliState> st;
-    st.push_back(RtfCliState{});
-
-    std::string out;
-    out.reserve(rtf.size());
-
-    std::string line;
-    line.reserve(256);
-
-    bool haveLineStartState = false;
-    RtfCliState lineStartState{};
-
-    int nl_run = 0; // consecutive '\n' already emitted into `out`
-
-    auto mark_non_nl = [&]() {
-        nl_run = 0;
-    };
-
-    auto emit_newline = [&]() {
-        // Avoid leading newlines and compress multiple blank lines.
-        if (out.empty()) {
-            return;
-        }
-        if (nl_run >= 2) { // allow at most one empty line
-            return;
-        }
-        out.push_back('\n');
-        ++nl_run;
-    };
-
-    auto flush_line = [&]() {
-        if (!haveLineStartState && line.empty()) {
-            return;
-        }
-
-        std::string_view t = trim_sv(line);
-        if (t.empty()) {
-            line.clear();
-            haveLineStartState = false;
-            return;
-        }
-
-        mark_non_nl();
-
-        if (lineStartState.margin) {
-            out += "  ";
-        }
-
-        // Historical note: we used to render \cf2 as "- ". Keep it only for non-POS lines.
-        if (lineStartState.cf == 2 && !is_pos_heading(t)) {
-            out += "- ";
-        }
+    // need at least 4 bytes for length
+    if (static_cast<std::uint64_t>(offset) + 4 > dat.size())
+        return false;
 
-        out.append(t.data(), t.size());
+    const std::uint32_t len = load_u32_le(dat.data() + offset);
+    if (len == 0 || len > kMaxDefSize)
+        return false;
 
-        line.clear();
-        haveLineStartState = false;
-    };
+    if (static_cast<std::uint64_t>(offset) + 4 + len > dat.size())
+        return false;
 
-    auto ensure_line_started = [&]() {
-        if (haveLineStartState)
-            return;
-        haveLineStartState = true;
-        lineStartState = st.back();
-    };
+    rtf = std::string_view(reinterpret_cast<const char*>(dat.data()) + offset + 4, len);
+    return true;
+}
 
-    auto push_text_byte = [&](unsigned char b) {
-        if (st.back().hide)
-            return;
+/*
+ * Locate a definition record (u32 length + RTF bytes) in the open .dat and
+ * validate it against the file size. On success `len` is the RTF length and
+ * the RTF bytes start at offset + 4.
+ */
+static bool file_definition(const DatFile& dat, std::uint32_t offset, std::uint32_t& len)
+{
+    const std::uint64_t fileSize = dat.size();
+    if (fileSize == 0)
+        return false;
 
-        // Trim noisy leading whitespace at BOL; indentation comes from \saN.
-        if (line.empty() && (b == ' ' || b == '\t' || b == '\r'))
-            return;
+    // need at least 4 bytes for length
+    if (static_cast<std::uint64_t>(offset) + 4 > fileSize)
+        return false;
 
-        ensure_line_started();
-        append_byte_as_utf8(line, b, st.back().phonetic);
-    };
+    std::byte b[4];
+    if (dat.readAt(offset, b, 4) != 4)
+        return false;
+    len = load_u32_le(b);
 
-    for (size_t i = 0; i < rtf.size(); ++i) {
-        const unsigned char ch = static_cast<unsigned char>(rtf[i]);
+    if (len == 0 || len > kMaxDefSize)
+        return false;
 
-        if (ch == '{') {
-            st.push_back(st.back());
-            continue;
-        }
-        if (ch == '}') {
-            if (st.size() > 1)
-                st.pop_back();
-            continue;
-        }
+    if (static_cast<std::uint64_t>(offset) + 4 + len > fileSize)
+        return false;
 
-        if (ch != '\\') {
-            if (ch == '\n') {
-                if (!st.back().hide) {
-                    flush_line();
-                    emit_newline();
-                }
-                continue;
-            }
-            if (ch == '\r') {
-                continue;
-            }
+    return true;
+}
 
-            push_text_byte(ch);
-            continue;
-        }
+const char* definitionStatusName(DefinitionStatus status)
+{
+    switch (status) {
+    case DefinitionStatus::Ok:            return "ok";
+    case DefinitionStatus::BadIndex:      return "bad index";
+    case DefinitionStatus::OffsetPastEnd: return "offset past end of .dat";
+    case DefinitionStatus::BadLength:     return "bad length";
+    case DefinitionStatus::PastEnd:       return "record past end of .dat";
+    case DefinitionStatus::ReadError:     return "read error";
+    }
+    return "?";
+}
 
-        // Control sequence
-        if (i + 1 >= rtf.size())
-            break;
+DefinitionStatus Dictionary::checkDefinition(int defIndex, std::uint32_t* length) const
+{
+    if (!initialized_ || defIndex < 0 || defIndex >= wordCount())
+        return DefinitionStatus::BadIndex;
+
+    // Same checks as memory_definition() / file_definition(), told apart.
+    const std::uint64_t offset = index_.datOffset(defIndex);
+    const std::uint64_t datSize = dat_in_memory_ ? dat_mem_.size() : dat_file_.size();
+    if (offset + 4 > datSize)
+        return DefinitionStatus::OffsetPastEnd;
+
+    std::byte b[4];
+    if (dat_in_memory_)
+        std::memcpy(b, dat_mem_.data() + offset, 4);
+    else if (dat_file_.readAt(offset, b, 4) != 4)
+        return DefinitionStatus::ReadError;
+    const std::uint32_t len = load_u32_le(b);
+    if (length)
+        *length = len;
 
-        // Escaped literal: \\ \{ \}
-        const char next = rtf[i + 1];
-        if (next == '\\' || next == '{' || next == '}') {
-            i += 1;
-            push_text_byte(static_cast<unsigned char>(next));
-            continue;
-        }
+    if (len == 0 || len > kMaxDefSize)
+        return DefinitionStatus::BadLength;
+    if (offset + 4 + len > datSize)
+        return DefinitionStatus::PastEnd;
+    return DefinitionStatus::Ok;
+}
 
-        // Hex escape: \'hh
-        if (next == '\'' && i + 3 < rtf.size()) {
-            const int h1 = hexval(rtf[i + 2]);
-            const int h2 = hexval(rtf[i + 3]);
-            if (h1 >= 0 && h2 >= 0) {
-                const unsigned char b = static_cast<unsigned char>((h1 << 4) | h2);
-                i += 3;
-                push_text_byte(b);
-                continue;
-            }
-        }
+std::vector<int> Dictionary::entriesInDatOrder() const
+{
+    std::vector<int> order(index_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    // ydpdict writes definitions in index order, so this is usually already sorted.
+    std::stable_sort(order.begin(), order.end(),
+                     [this](int a, int b) { return index_.datOffset(a) < index_.datOffset(b); });
+    return order;
+}
 
-        // Parse control word: \word[+/-num]?
-        size_t j = i + 1;
-        std::string tok;
-        while (j < rtf.size() && is_alpha(rtf[j])) {
-            tok.push_back(rtf[j]);
-            ++j;
-        }
+std::string Dictionary::readRtf(int defIndex) const
+{
+    return readRtfPrefix(defIndex, static_cast<size_t>(-1));
+}
 
-        bool hasParam = false;
-        int sign = 1;
-        int param = 0;
-        if (j < rtf.size() && (rtf[j] == '-' || is_digit(rtf[j]))) {
-            hasParam = true;
-            if (rtf[j] == '-') { sign = -1; ++j; }
-            while (j < rtf.size() && is_digit(rtf[j])) {
-                param = param * 10 + (rtf[j] - '0');
-                ++j;
-            }
-            param *= sign;
-        }
+std::string Dictionary::readRtfPrefix(int defIndex, size_t maxBytes) const
+{
+    if (!initialized_)
+        return {};
 
-        // Optional delimiter space after control word
-        if (j < rtf.size() && rtf[j] == ' ')
-            i = j;
-        else
-            i = j - 1;
+    if (defIndex < 0 || defIndex >= wordCount())
+        return {};
 
-        if (tok == "par" || tok == "line") {
-            if (!st.back().hide) {
-                flush_line();
-                emit_newline();
-            }
-            continue;
+    if (dat_in_memory_) {
+        std::string_view rtf;
+        {
+            YDICT_STATS_TIME(stats_.get(), ReadLocate);
+            if (!memory_definition(dat_mem_, index_.datOffset(defIndex), rtf))
+                return {};
         }
+        YDICT_STATS_TIME(stats_.get(), ReadBody);
+        return std::string(rtf.substr(0, maxBytes));
+    }
 
-        if (tok == "pard") {
-            // Paragraph defaults/reset; do NOT create a new line (RTF often does \pard\par).
-            st.back().cf = 0;
-            st.back().margin = false;
-            continue;
-        }
+    TraceSpan trace("dat.read", "io");
+    const std::uint32_t offset = index_.datOffset(defIndex);
+    std::uint32_t len = 0;
+    {
+        YDICT_STATS_TIME(stats_.get(), ReadLocate);
+        if (!file_definition(dat_file_, offset, len))
+            return {};
+    }
 
-        if (tok == "tab") {
-            if (!st.back().hide) {
-                push_text_byte('\t');
-            }
-            continue;
-        }
+    // Only the requested prefix is read; file_definition() still validated the full entry.
+    const size_t want = std::min<size_t>(len, maxBytes);
 
-        if (tok == "cf" && hasParam) { st.back().cf = param; continue; }
-        if (tok == "sa" && hasParam) { st.back().margin = (param != 0); continue; }
-        if (tok == "f"  && hasParam) { st.back().phonetic = (param == 1); continue; }
-        if (tok == "qc") { st.back().hide = true; continue; }
-
-        // Minimal RTF \uN support
-        if (tok == "u" && hasParam && !st.back().hide) {
-#ifdef _WIN32
-            wchar_t wc = static_cast<wchar_t>(param);
-            char ubuf[8] = {};
-            const int ulen = WideCharToMultiByte(CP_UTF8, 0, &wc, 1, ubuf, int(sizeof(ubuf)), nullptr, nullptr);
-            ensure_line_started();
-            if (ulen > 0) line.append(ubuf, ubuf + ulen);
-            else line.push_back('?');
-#else
-            ensure_line_started();
-            line.push_back('?');
-#endif
-            // RTF expects a fallback char right after \uN — skip one if present
-            if (i + 1 < rtf.size())
-                ++i;
-            continue;
-        }
+    YDICT_STATS_TIME(stats_.get(), ReadBody);
+    std::string rtf;
+    rtf.resize(want);
 
-        // Everything else ignored for now.
-    }
+    if (dat_file_.readAt(static_cast<std::uint64_t>(offset) + 4, rtf.data(), want) != want)
+        return {};
 
-    flush_line();
-    return out;
+    return rtf;
 }
 
-static std::string rtf_to_plain_utf8(const std::string& rtf)
+bool Dictionary::streamDefinition(int defIndex, OutputFormat fmt,
+                                  const std::function<void(std::string_view)>& sink,
+                                  size_t blockSize) const
 {
-    std::string out;
-    out.reserve(rtf.size());
-
-    bool phonetic = false;
-
-    for (size_t i = 0; i < rtf.size(); ) {
-        const unsigned char ch = static_cast<unsigned char>(rtf[i]);
-
-        if (ch == '{' || ch == '}') {
-            ++i;
-            continue;
-        }
-
-        if (ch != '\\') {
-            append_byte_as_utf8(out, ch, phonetic);
-            ++i;
-            continue;
-        }
+    if (!initialized_)
+        return false;
 
-        // control sequence
-        ++i;
-        if (i >= rtf.size())
-            break;
+    if (defIndex < 0 || defIndex >= wordCount())
+        return false;
 
-        // hex escape: \'hh
-        if (rtf[i] == '\'' && i + 2 < rtf.size()) {
-            const int h1 = hexval(rtf[i + 1]);
-            const int h2 = hexval(rtf[i + 2]);
-            if (h1 >= 0 && h2 >= 0) {
-                const unsigned char b = static_cast<unsigned char>((h1 << 4) | h2);
-                append_byte_as_utf8(out, b, phonetic);
-                i += 3;
-                continue;
-            }
+    if (dat_in_memory_) {
+        // Already resident: feed the renderer straight from the buffer, same block size.
+        std::string_view rtf;
+        {
+            YDICT_STATS_TIME(stats_.get(), ReadLocate);
+            if (!memory_definition(dat_mem_, index_.datOffset(defIndex), rtf))
+                return false;
         }
 
-        // parse control word: letters
-        std::string tok;
-        while (i < rtf.size()) {
-            const char c = rtf[i];
-            if (!is_alpha(c))
+        RtfStreamRenderer renderer(fmt, sink);
+        const size_t step = std::max<size_t>(blockSize, 1);
+        for (size_t pos = 0; pos < rtf.size(); pos += step) {
+            if (!renderer.feed(rtf.substr(pos, step)))
                 break;
-            tok.push_back(c);
-            ++i;
         }
+        renderer.finish();
+        return true;
+    }
 
-        // optional numeric parameter
-        bool hasParam = false;
-        int param = 0;
-        int sign = 1;
-
-        if (i < rtf.size() && (rtf[i] == '-' || is_digit(rtf[i]))) {
-            hasParam = true;
-            if (rtf[i] == '-') { sign = -1; ++i; }
-            while (i < rtf.size() && is_digit(rtf[i])) {
-                param = param * 10 + (rtf[i] - '0');
-                ++i;
-            }
-            param *= sign;
-        }
-
-        // skip one optional space delimiter
-        if (i < rtf.size() && rtf[i] == ' ')
-            ++i;
-
-        if (tok == "par" || tok == "line") {
-            out.push_back('\n');
-            continue;
-        }
-        if (tok == "tab") {
-            out.push_back('\t');
-            continue;
-        }
+    const std::uint32_t offset = index_.datOffset(defIndex);
+    std::uint32_t len = 0;
+    {
+        TraceSpan trace("dat.read", "io");
+        YDICT_STATS_TIME(stats_.get(), ReadLocate);
+        if (!file_definition(dat_file_, offset, len))
+            return false;
+    }
 
-        if (tok == "f" && hasParam) {
-            phonetic = (param == 1);
-            continue;
+    std::string block(std::min<size_t>(std::max<size_t>(blockSize, 1), len), '\0');
+    RtfStreamRenderer renderer(fmt, sink);
+
+    std::uint64_t at = static_cast<std::uint64_t>(offset) + 4;
+    size_t left = len;
+    while (left > 0) {
+        const size_t want = std::min(left, block.size());
+        bool read = false;
+        {
+            TraceSpan trace("dat.read", "io");
+            YDICT_STATS_TIME(stats_.get(), ReadBody);
+            read = dat_file_.readAt(at, block.data(), want) == want;
         }
-
-        if (tok == "u" && hasParam) {
-#ifdef _WIN32
-            wchar_t wc = static_cast<wchar_t>(param);
-            char ubuf[8] = {};
-            const int ulen = WideCharToMultiByte(CP_UTF8, 0, &wc, 1, ubuf, int(sizeof(ubuf)), nullptr, nullptr);
-            if (ulen > 0) out.append(ubuf, ubuf + ulen);
-            else out.push_back('?');
-#else
-            out.push_back('?');
-#endif
-            if (i < rtf.size())
-                ++i;
-            continue;
+        if (!read) {
+            renderer.finish();
+            return false;
         }
+        at += want;
+        left -= want;
 
-        // everything else ignored
+        if (!renderer.feed(std::string_view(block.data(), want)))
+            break;
     }
 
-    return out;
+    renderer.finish();
+    return true;
 }
 
 std::string Dictionary::readPlainText(int defIndex) const
@@ -660,7 +619,7 @@ std::string Dictionary::readPlainText(int defIndex) const
     const std::string rtf = readRtf(defIndex);
     if (rtf.empty())
         return {};
-    return rtf_to_plain_utf8(rtf);
+    return renderRtf(rtf, OutputFormat::Plain);
 }
 
 std::string Dictionary::readPlainText(std::string_view word) const
@@ -671,38 +630,184 @@ std::string Dictionary::readPlainText(std::string_view word) const
     return readPlainText(idx);
 }
 
+std::string Dictionary::previewAt(int defIndex, size_t maxLines, size_t maxBytes) const
+{
+    if (maxLines == 0 || maxBytes == 0)
+        return {};
+
+    const std::string rtf = readRtfPrefix(defIndex, maxBytes);
+    if (rtf.empty())
+        return {};
+    return renderRtfForCli(rtf, maxLines);
+}
+
+Document Dictionary::readDocument(int defIndex) const
+{
+    const std::string rtf = readRtf(defIndex);
+    if (rtf.empty())
+        return {};
+    return parseDocument(rtf);
+}
+
+std::shared_ptr<const Document> Dictionary::document(int defIndex) const
+{
+    if (doc_cache_) {
+        if (auto hit = doc_cache_->find(defIndex)) {
+            traceInstant("document.cache_hit", "cache");
+            return hit;
+        }
+        traceInstant("document.cache_miss", "cache");
+    }
+
+    const std::string rtf = readRtf(defIndex);
+    if (rtf.empty())
+        return {};
+
+    auto doc = std::make_shared<const Document>(parseDocument(rtf));
+    if (doc_cache_)
+        doc_cache_->insert(defIndex, doc);
+    return doc;
+}
+
+/*
+ * First entry whose word is not less than `key` (the index is sorted by byte
+ * order). If `probesOrdered` is given, it is cleared when the probes show the
+ * index is not: probes below `key` move right and must not decrease, probes
+ * at or above it move left and must not increase.
+ */
+static size_t lower_bound_word(const IndexView& index, std::string_view key, size_t* comparisons = nullptr,
+                               bool* probesOrdered = nullptr)
+{
+    size_t lo = 0;
+    size_t hi = index.size();
+    std::string_view below;     // last probe < key
+    std::string_view above;     // last probe >= key
+    bool haveBelow = false;
+    bool haveAbove = false;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (comparisons)
+            ++*comparisons;
+        const std::string_view w = index.word(mid);
+        if (w < key) {
+            if (probesOrdered && haveBelow && w < below)
+                *probesOrdered = false;
+            below = w;
+            haveBelow = true;
+            lo = mid + 1;
+        } else {
+            if (probesOrdered && haveAbove && w > above)
+                *probesOrdered = false;
+            above = w;
+            haveAbove = true;
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
 int Dictionary::findWord(std::string_view word) const
 {
     if (!initialized_ || word.empty())
         return -1;
 
-    // Fast path (assumes .idx word table is sorted in a way compatible with std::string ordering)
-    const auto it = std::lower_bound(
-        words_.begin(), words_.end(), word,
-        [](const WordEntry& e, std::string_view w) { return e.word < w; });
+    YDICT_STATS_TIME(stats_.get(), FindWord);
 
-    if (it != words_.end() && it->word == word)
-        return static_cast<int>(it - words_.begin());
+    // Fast path (assumes .idx word table is sorted in a way compatible with std::string ordering)
+    const size_t pos = lower_bound_word(index_, word);
+    if (pos < index_.size() && index_.word(pos) == word) {
+        YDICT_STATS_ADD(stats_.get(), FindFastHits, 1);
+        return static_cast<int>(pos);
+    }
 
     // Fallback (robust against collation differences): linear scan
-    for (size_t i = 0; i < words_.size(); ++i) {
-        if (words_[i].word == word)
+    for (size_t i = 0; i < index_.size(); ++i) {
+        if (index_.word(i) == word) {
+            YDICT_STATS_ADD(stats_.get(), FindFallbackHits, 1);
             return static_cast<int>(i);
+        }
+    }
+
+    YDICT_STATS_ADD(stats_.get(), FindMisses, 1);
+    return -1;
+}
+
+const char* lookupPathName(LookupPath path)
+{
+    switch (path) {
+    case LookupPath::Fast:     return "fast";
+    case LookupPath::Fallback: return "fallback";
+    case LookupPath::Miss:     return "miss";
+    }
+    return "?";
+}
+
+int Dictionary::findWordExplain(std::string_view word, LookupExplain& explain) const
+{
+    explain = LookupExplain{};
+    if (!initialized_ || word.empty())
+        return -1;
+
+    // Same two steps as findWord(), counted.
+    bool probesOrdered = true;
+    const size_t pos = lower_bound_word(index_, word, &explain.search_comparisons, &probesOrdered);
+    explain.search_position = pos;
+    if (pos < index_.size() && index_.word(pos) == word) {
+        explain.path = LookupPath::Fast;
+        explain.index = static_cast<int>(pos);
+        return explain.index;
     }
 
+    for (size_t i = 0; i < index_.size(); ++i) {
+        ++explain.scan_comparisons;
+        if (index_.word(i) == word) {
+            explain.path = LookupPath::Fallback;
+            explain.index = static_cast<int>(i);
+            explain.order_conflict = true;
+            return explain.index;
+        }
+    }
+
+    // The scan settles the miss; still flag an index the search saw out of byte order.
+    explain.order_conflict = !probesOrdered;
     return -1;
 }
 
+IndexOrderReport Dictionary::checkIndexOrder() const
+{
+    IndexOrderReport r;
+    if (!initialized_)
+        return r;
+
+    // The fallback scan stops at the first equal entry: i, or an earlier duplicate.
+    std::unordered_map<std::string_view, size_t> firstIndex;
+
+    for (size_t i = 0; i < index_.size(); ++i) {
+        const std::string_view w = index_.word(i);
+        if (i > 0 && index_.word(i - 1) > w)
+            r.inversions.push_back(static_cast<int>(i));
+
+        const size_t pos = lower_bound_word(index_, w);
+        if (pos < index_.size() && index_.word(pos) == w)
+            continue;
+        if (firstIndex.empty()) {
+            firstIndex.reserve(index_.size());
+            for (size_t j = 0; j < index_.size(); ++j) {
+                firstIndex.try_emplace(index_.word(j), j);
+            }
+        }
+        ++r.fallback_words;
+        r.fallback_comparisons += firstIndex[w] + 1;
+    }
+    return r;
+}
+
 int Dictionary::lowerBound(std::string_view key) const
 {
     if (!initialized_)
         return -1;
 
-    const auto it = std::lower_bound(
-        words_.begin(), words_.end(), key,
-        [](const WordEntry& e, std::string_view k) { return e.word < k; });
-
-    return static_cast<int>(it - words_.begin()); // may be == wordCount()
+    return static_cast<int>(lower_bound_word(index_, key)); // may be == wordCount()
 }
 
 static bool starts_with_sv(std::string_view s, std::string_view prefix)
@@ -738,15 +843,23 @@ int Dictionary::findFirstWithPrefix(std::string_view prefix) const
         return -1;
 
     const int pos = lowerBound(prefix);
-    if (pos < 0 || pos >= static_cast<int>(words_.size()))
+    if (pos < 0 || pos >= wordCount())
         return -1;
 
-    return starts_with_sv(words_[pos].word, prefix) ? pos : -1;
+    return starts_with_sv(index_.word(pos), prefix) ? pos : -1;
 }
 
 std::vector<int> Dictionary::suggest(std::string_view prefix, size_t maxResults) const
+{
+    return suggest(prefix, maxResults, QueryBudget{}, nullptr);
+}
+
+std::vector<int> Dictionary::suggest(std::string_view prefix, size_t maxResults, const QueryBudget& budget,
+                                     bool* truncated) const
 {
     std::vector<int> out;
+    if (truncated)
+        *truncated = false;
     if (!initialized_ || prefix.empty() || maxResults == 0)
         return out;
 
@@ -760,12 +873,116 @@ std::vector<int> Dictionary::suggest(std::string_view prefix, size_t maxResults)
             return out;
     }
 
+    TraceSpan trace("suggest", "index", prefix);
+    YDICT_STATS_TIME(stats_.get(), Suggest);
+
     // Robust: linear scan, keep original order from .idx
-    for (size_t i = 0; i < words_.size() && out.size() < maxResults; ++i) {
-        if (starts_with_ascii_icase(words_[i].word, prefix))
+    size_t i = 0;
+    for (; i < index_.size() && out.size() < maxResults; ++i) {
+        if (i % kBudgetCheckInterval == 0 && i > 0 && budget.exhausted()) {
+            if (truncated)
+                *truncated = true;
+            YDICT_STATS_ADD(stats_.get(), ScansTruncated, 1);
+            break;
+        }
+        if (starts_with_ascii_icase(index_.word(i), prefix))
             out.push_back(static_cast<int>(i));
     }
 
+    YDICT_STATS_ADD(stats_.get(), SuggestScanned, i);
+    return out;
+}
+
+/*
+ * Optimal-string-alignment distance between `a` and `b`, giving up early:
+ * returns maxDist + 1 as soon as every cell of a row exceeds maxDist.
+ * `rows` is scratch space reused across calls.
+ */
+static int bounded_edit_distance(std::string_view a, std::string_view b, int maxDist,
+                                 std::vector<int>& rows)
+{
+    const size_t n = b.size();
+    rows.assign(3 * (n + 1), 0);
+    int* prev2 = rows.data();
+    int* prev = prev2 + (n + 1);
+    int* cur = prev + (n + 1);
+
+    for (size_t j = 0; j <= n; ++j) {
+        prev[j] = static_cast<int>(j);
+    }
+
+    for (size_t i = 1; i <= a.size(); ++i) {
+        cur[0] = static_cast<int>(i);
+        int rowMin = cur[0];
+        const unsigned char ca = ascii_tolower(static_cast<unsigned char>(a[i - 1]));
+
+        for (size_t j = 1; j <= n; ++j) {
+            const unsigned char cb = ascii_tolower(static_cast<unsigned char>(b[j - 1]));
+            const int cost = ca == cb ? 0 : 1;
+            int d = std::min({ prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost });
+            if (i > 1 && j > 1 &&
+                ca == ascii_tolower(static_cast<unsigned char>(b[j - 2])) &&
+                ascii_tolower(static_cast<unsigned char>(a[i - 2])) == cb) {
+                d = std::min(d, prev2[j - 2] + 1);
+            }
+            cur[j] = d;
+            rowMin = std::min(rowMin, d);
+        }
+        if (rowMin > maxDist)
+            return maxDist + 1;
+
+        int* t = prev2;
+        prev2 = prev;
+        prev = cur;
+        cur = t;
+    }
+    return prev[n];
+}
+
+std::vector<FuzzyMatch> Dictionary::fuzzy(std::string_view word, size_t maxResults, int maxDistance) const
+{
+    return fuzzy(word, maxResults, maxDistance, QueryBudget{}, nullptr);
+}
+
+std::vector<FuzzyMatch> Dictionary::fuzzy(std::string_view word, size_t maxResults, int maxDistance,
+                                          const QueryBudget& budget, bool* truncated) const
+{
+    std::vector<FuzzyMatch> out;
+    if (truncated)
+        *truncated = false;
+    if (!initialized_ || word.empty() || maxResults == 0 || maxDistance < 0)
+        return out;
+
+    TraceSpan trace("fuzzy", "index", word);
+    YDICT_STATS_TIME(stats_.get(), Fuzzy);
+
+    // Linear scan; the length check skips most entries before any DP work.
+    std::vector<int> rows;
+    [[maybe_unused]] std::uint64_t scanned = 0;
+    for (size_t i = 0; i < index_.size(); ++i) {
+        if (i % kBudgetCheckInterval == 0 && i > 0 && budget.exhausted()) {
+            if (truncated)
+                *truncated = true;
+            YDICT_STATS_ADD(stats_.get(), ScansTruncated, 1);
+            break;
+        }
+        const std::string_view w = index_.word(i);
+        const size_t lenDiff = w.size() > word.size() ? w.size() - word.size() : word.size() - w.size();
+        if (lenDiff > static_cast<size_t>(maxDistance))
+            continue;
+
+        ++scanned;
+        const int d = bounded_edit_distance(word, w, maxDistance, rows);
+        if (d <= maxDistance)
+            out.push_back(FuzzyMatch{static_cast<int>(i), d});
+    }
+
+    YDICT_STATS_ADD(stats_.get(), FuzzyScanned, scanned);
+
+    std::stable_sort(out.begin(), out.end(),
+                     [](const FuzzyMatch& x, const FuzzyMatch& y) { return x.distance < y.distance; });
+    if (out.size() > maxResults)
+        out.resize(maxResults);
     return out;
 }
 
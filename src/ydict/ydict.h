@@ -1,6 +1,18 @@
 #pragma once
 
+#include "ydict/dat_file.h"
+#include "ydict/document.h"
+#include "ydict/index_image.h"
+#include "ydict/stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -18,13 +30,36 @@ struct Config {
      * Format: idx<TAB>datOffset<TAB>word<NL>
      */
     std::string idx_dump_path;
+
+    /*
+     * Number of parsed definitions kept by Dictionary::document() (LRU).
+     * 0 disables the cache.
+     */
+    std::size_t document_cache_entries = 64;
+
+    /*
+     * Optional: share the parsed word table between processes through this
+     * file (e.g. /dev/shm/ydict-en.index). The first process builds it; the
+     * others map it read-only instead of building their own copy. A file
+     * that is damaged, from another format version or built from different
+     * .idx/.dat files is rebuilt; if it cannot be used at all, the process
+     * keeps a private copy as usual (see Dictionary::sharedIndexStatus()).
+     * If empty (default), every process builds its own.
+     */
+    std::string shared_index_path;
 };
 
+// One index entry; `word` points into the Dictionary's index and lives as long as it.
 struct WordEntry {
-    std::string word;
+    std::string_view word;
     std::uint32_t dat_offset = 0;
 };
 
+struct FuzzyMatch {
+    int index = -1;
+    int distance = 0; // edit distance to the query
+};
+
 struct IdxDumpStatus
 {
     bool requested = false;
@@ -32,37 +67,280 @@ struct IdxDumpStatus
     std::string path;         // meaningful only if requested==true
 };
 
+struct SharedIndexStatus
+{
+    bool requested = false;
+    bool attached = false;    // the index is mapped from the shared file (else a private copy)
+    bool rebuilt = false;     // this process (re)wrote the shared file
+    std::string path;
+    std::string note;         // why the existing file was not used as-is (empty if it was)
+};
+
+/*
+ * Where an entry's definition record (u32 length + RTF) stands in the .dat,
+ * checked without reading its body (Dictionary::checkDefinition()).
+ */
+enum class DefinitionStatus : std::uint8_t {
+    Ok,
+    BadIndex,       // no such entry
+    OffsetPastEnd,  // record starts past the end of the .dat (no room for its length)
+    BadLength,      // length 0 or over the 4 MiB limit
+    PastEnd,        // record runs past the end of the .dat
+    ReadError,
+};
+
+const char* definitionStatusName(DefinitionStatus status);
+
+/*
+ * How findWord() resolved a word (see Dictionary::findWordExplain())
+ * ------------------------------------------------------------------
+ * findWord() binary-searches the index assuming byte order; when that
+ * misses, it falls back to a linear scan in case the .idx is collated
+ * differently. `order_conflict` marks lookups that ran into such an index:
+ * the scan found a word the search missed, or the search's own probes were
+ * out of byte order.
+ */
+enum class LookupPath : std::uint8_t {
+    Fast,       // binary search
+    Fallback,   // linear scan after the binary search missed
+    Miss,       // neither found it
+};
+
+const char* lookupPathName(LookupPath path);
+
+struct LookupExplain {
+    int index = -1;
+    LookupPath path = LookupPath::Miss;
+    std::size_t search_comparisons = 0;   // binary search
+    std::size_t scan_comparisons = 0;     // linear fallback (0 on the fast path)
+    std::size_t search_position = 0;      // where the binary search landed
+    bool order_conflict = false;
+};
+
+// Whole-index order check (Dictionary::checkIndexOrder()).
+struct IndexOrderReport {
+    std::vector<int> inversions;              // i where word(i - 1) > word(i) in byte order
+    std::size_t fallback_words = 0;           // entries the binary search cannot find
+    std::uint64_t fallback_comparisons = 0;   // scan cost of looking each of them up once
+};
+
+/*
+ * Bound on a scan (suggest(), fuzzy(), DictionarySet::suggest())
+ * --------------------------------------------------------------
+ * The scan stops once `deadline` has passed or `*cancel` became true (set
+ * from any thread, e.g. when a newer keystroke supersedes the query) and
+ * returns what it found so far, with `truncated` set. Both are checked every
+ * kBudgetCheckInterval index entries, so a scan overruns the deadline by at
+ * most that much work. A default QueryBudget never stops a scan.
+ */
+constexpr std::size_t kBudgetCheckInterval = 256;
+
+struct QueryBudget {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool>* cancel = nullptr;
+
+    // Deadline `d` from now.
+    static QueryBudget within(std::chrono::steady_clock::duration d, const std::atomic<bool>* cancel = nullptr)
+    {
+        return QueryBudget{std::chrono::steady_clock::now() + d, cancel};
+    }
+
+    bool exhausted() const
+    {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return true;
+        return deadline != std::chrono::steady_clock::time_point::max() &&
+               std::chrono::steady_clock::now() >= deadline;
+    }
+};
+
+/*
+ * Memory footprint of a loaded Dictionary (see Dictionary::memoryUsage()).
+ *
+ * Headwords are not std::strings: they live in one arena inside the index
+ * image, NUL-terminated, next to a table of fixed-size entries (word offset,
+ * word size, .dat offset). That sorted table is also the only lookup index;
+ * findWord(), suggest() and fuzzy() search it in place. The image is either
+ * a private heap block or a read-only mapping of the shared index file.
+ * Resident counts come from mincore() on Linux: pages of the image that are
+ * in RAM right now (a shared mapping's pages are shared by every process
+ * that attached it).
+ */
+struct MemoryUsage {
+    std::size_t words = 0;
+    std::size_t index_header_bytes = 0;
+    std::size_t index_entry_bytes = 0;      // entry table (the lookup index)
+    std::size_t headword_bytes = 0;         // headword text
+    std::size_t headword_nul_bytes = 0;     // terminators
+    std::size_t index_slack_bytes = 0;      // private image: allocated but unused capacity
+    bool index_shared = false;              // image is the mapped shared index file
+    std::size_t index_mapped_bytes = 0;     // page-rounded extent of the image
+    std::size_t index_resident_bytes = 0;
+    bool resident_known = false;            // false where mincore() is unavailable
+
+    std::size_t dat_file_bytes = 0;         // .dat on disk, read per lookup (not held)
+    std::size_t dat_memory_bytes = 0;       // .dat image given to initFromMemory()
+    bool dat_memory_owned = false;          // ... and owned by this Dictionary
+    std::size_t dat_resident_bytes = 0;     // of dat_memory_bytes
+
+    std::size_t doc_cache_capacity = 0;
+    DocumentCacheUsage doc_cache;
+    std::size_t stats_bytes = 0;            // per-dictionary stats shards (YDICT_STATS)
+    std::size_t object_bytes = 0;           // sizeof(Dictionary) and small members
+
+    // Private heap held by this Dictionary: everything above except a shared
+    // index mapping and a .dat image it does not own.
+    std::size_t privateBytes() const;
+};
+
+/*
+ * Dictionary
+ * ----------
+ * init()/initFromMemory() build the whole index; after that the object is
+ * never modified, so one loaded Dictionary can serve any number of threads:
+ * lookups, suggest/fuzzy and definition reads take no locks (the .dat is
+ * read with positional reads on one shared descriptor). document() is the
+ * exception: its parse cache is sharded, each shard behind its own mutex.
+ *
+ * open() returns such a snapshot as shared_ptr<const Dictionary>; loading a
+ * newer file means opening a new snapshot, while threads still holding the
+ * old one keep using it until they drop it. Calling init() on a Dictionary
+ * that other threads are querying is not allowed.
+ */
 class Dictionary {
 public:
+    // Immutable snapshot for sharing across threads; nullptr if loading fails.
+    static std::shared_ptr<const Dictionary> open(const Config& cfg);
+    static std::shared_ptr<const Dictionary> openFromMemory(std::vector<std::byte>&& idx, std::vector<std::byte>&& dat);
+
     bool init(const Config& cfg);
+
+    /*
+     * Same as init(), from .idx/.dat images already in memory (embedded in the
+     * binary, fetched over the network, generated fixtures). The .idx is parsed
+     * and validated exactly as from a file; definitions are then read straight
+     * from `dat`, which must stay valid and unchanged while this Dictionary
+     * uses it. Config defaults apply (document cache on, no idx dump).
+     */
+    bool initFromMemory(std::span<const std::byte> idx, std::span<const std::byte> dat);
+
+    // Same, but the Dictionary takes the buffers over (nothing to keep alive).
+    bool initFromMemory(std::vector<std::byte>&& idx, std::vector<std::byte>&& dat);
     std::string version() const;
 
     int wordCount() const;
-    const WordEntry* wordAt(int index) const;
+    std::optional<WordEntry> wordAt(int index) const;
 
     // Read raw RTF-like stream from .dat for the given entry index.
     std::string readRtf(int defIndex) const;
 
-    // Read plain UTF-8 text, produced by a minimal RTF-to-plain converter.
+    // Same, but reads at most `maxBytes` of the definition from disk.
+    std::string readRtfPrefix(int defIndex, size_t maxBytes) const;
+
+    // Validate the entry's record against the .dat size; `length` gets the declared RTF length if it could be read.
+    DefinitionStatus checkDefinition(int defIndex, std::uint32_t* length = nullptr) const;
+
+    // Every entry index, by .dat offset (ties in index order): whole-dictionary passes read the .dat front to back.
+    std::vector<int> entriesInDatOrder() const;
+
+    /*
+     * Render the entry's definition into `sink` while reading it: the .dat is
+     * read in blocks of `blockSize` bytes and each block is rendered before
+     * the next one is read (see RtfStreamRenderer), so the first output comes
+     * after one block and memory use does not grow with the entry size.
+     * Returns false if the entry cannot be read; a read error after the first
+     * block leaves the output rendered so far in `sink`.
+     */
+    bool streamDefinition(int defIndex, OutputFormat fmt,
+                          const std::function<void(std::string_view)>& sink,
+                          size_t blockSize = 64 * 1024) const;
+
+    // Read plain UTF-8 text (the definition's lines, without CLI indentation/markers).
     std::string readPlainText(int defIndex) const;
     std::string readPlainText(std::string_view word) const;
 
+    // Parse the entry's definition into the structured model (empty on read failure).
+    Document readDocument(int defIndex) const;
+
+    // Same, but served from / stored into the document cache (nullptr on read failure).
+    std::shared_ptr<const Document> document(int defIndex) const;
+
+    /*
+     * Short CLI preview for suggestion lists: the first `maxLines` output lines
+     * (headword, POS, first sense...), rendered from at most `maxBytes` of the
+     * definition. Neither the read nor the render goes past those bounds, so
+     * the last line may be cut short when `maxBytes` is hit first.
+     */
+    std::string previewAt(int defIndex, size_t maxLines = 3, size_t maxBytes = 1024) const;
+
     // Find exact word in the loaded index. Returns -1 if not found.
     int findWord(std::string_view word) const;
 
+    // Same lookup, reporting the path it took and what it cost (not counted in stats()).
+    int findWordExplain(std::string_view word, LookupExplain& explain) const;
+
+    /*
+     * Compare every adjacent pair of entries in byte order and look every
+     * word up the way findWord() does, to tell how often the linear
+     * fallback runs and what it costs. O(n log n); for diagnostics.
+     */
+    IndexOrderReport checkIndexOrder() const;
+
     // For prefix search/suggestions (left-pane behavior in ydpdict).
     int lowerBound(std::string_view key) const;
     int findFirstWithPrefix(std::string_view prefix) const;
     std::vector<int> suggest(std::string_view prefix, size_t maxResults = 15) const;
 
+    // Same, stopping early when `budget` runs out; `truncated` (optional) tells whether it did.
+    std::vector<int> suggest(std::string_view prefix, size_t maxResults, const QueryBudget& budget,
+                             bool* truncated) const;
+
+    /*
+     * Approximate lookup (typos): entries within `maxDistance` edits of `word`
+     * (insert, delete, substitute, swap of two adjacent bytes; ASCII letters
+     * compare case-insensitively). Closest first, ties in index order.
+     */
+    std::vector<FuzzyMatch> fuzzy(std::string_view word, size_t maxResults = 15, int maxDistance = 2) const;
+
+    // Same, bounded by `budget`: if it runs out, the closest matches among the entries scanned so far.
+    std::vector<FuzzyMatch> fuzzy(std::string_view word, size_t maxResults, int maxDistance,
+                                  const QueryBudget& budget, bool* truncated) const;
+
     // Debug/CLI diagnostics: tells whether idx dump was requested and whether it succeeded.
     const IdxDumpStatus& idxDumpStatus() const { return idx_dump_status_; }
 
+    // Whether Config::shared_index_path was used, and how.
+    const SharedIndexStatus& sharedIndexStatus() const { return shared_index_status_; }
+
+    /*
+     * Per-phase latency histograms and counters since the last init() (see
+     * ydict/stats.h), plus the process-wide render phases. Safe to call while
+     * other threads query. All zero, enabled=false, in builds without
+     * YDICT_STATS.
+     */
+    DictionaryStats stats() const;
+
+    // Bytes per structure, computed on demand (walks the cache; not for hot paths).
+    MemoryUsage memoryUsage() const;
+
 private:
+    void reset();
+    void finishInit(const Config& cfg);
+    bool loadSharedIndex(const Config& cfg, const IndexStamp& stamp);
+
     bool initialized_ = false;
     std::string dat_path_;
-    std::vector<WordEntry> words_;
+    DatFile dat_file_;                              // file-backed .dat, opened by init()
+    bool dat_in_memory_ = false;                    // definitions come from dat_mem_
+    std::span<const std::byte> dat_mem_;
+    std::unique_ptr<const std::vector<std::byte>> dat_owner_; // set by the owning initFromMemory()
+    IndexView index_;                               // over index_image_ or index_file_
+    std::vector<std::byte> index_image_;            // private index image
+    SharedIndexFile index_file_;                    // mapped shared index image
     IdxDumpStatus idx_dump_status_;
+    SharedIndexStatus shared_index_status_;
+    std::unique_ptr<DocumentCache> doc_cache_;
+    std::unique_ptr<StatsCollector> stats_;         // null unless built with YDICT_STATS
 };
 
 /*
@@ -72,7 +350,13 @@ private:
  * This helper renders that stream to UTF-8 text suitable for console output
  * (no colors), preserving key semantic cues (indentation, phonetics mapping,
  * hidden blocks) while keeping line breaks close to ydpdict.
+ *
+ * Equivalent to renderDocument(parseDocument(rtf), OutputFormat::Cli).
  */
 std::string renderRtfForCli(std::string_view rtf);
 
+// Bounded variant: stops parsing once `maxLines` output lines were produced
+// (no trailing newline after the last one).
+std::string renderRtfForCli(std::string_view rtf, size_t maxLines);
+
 } // namespace ydict
@@ -0,0 +1,222 @@
+#include "ydict/ydict_c.h"
+#include "ydict/ydict.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+struct ydict_handle {
+    ydict::Dictionary dict;
+};
+
+namespace {
+
+bool to_format(int format, ydict::OutputFormat& fmt)
+{
+    if (format < YDICT_FORMAT_CLI || format > YDICT_FORMAT_JSON)
+        return false;
+    fmt = static_cast<ydict::OutputFormat>(format);
+    return true;
+}
+
+// snprintf-style copy of `s` into a caller buffer.
+int copy_out(std::string_view s, char* buf, size_t buf_size, size_t* out_len)
+{
+    if (out_len)
+        *out_len = s.size();
+    if (buf_size == 0)
+        return s.empty() ? YDICT_OK : YDICT_ERR_BUFFER_TOO_SMALL;
+    const size_t n = s.size() < buf_size ? s.size() : buf_size - 1;
+    std::memcpy(buf, s.data(), n);
+    buf[n] = '\0';
+    return n == s.size() ? YDICT_OK : YDICT_ERR_BUFFER_TOO_SMALL;
+}
+
+// Every entry point runs its body through this: C callers cannot handle exceptions.
+template <class Fn>
+int guarded(Fn&& fn) noexcept
+{
+    try {
+        return fn();
+    } catch (...) { // std::bad_alloc in practice
+        return YDICT_ERR_INTERNAL;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+uint32_t ydict_abi_version(void)
+{
+    return YDICT_C_ABI_VERSION;
+}
+
+const char* ydict_status_string(int status)
+{
+    switch (status) {
+    case YDICT_OK:                   return "ok";
+    case YDICT_ERR_NOT_FOUND:        return "not found";
+    case YDICT_ERR_BUFFER_TOO_SMALL: return "buffer too small";
+    case YDICT_ERR_INVALID_ARGUMENT: return "invalid argument";
+    case YDICT_ERR_INIT_FAILED:      return "dictionary could not be loaded";
+    case YDICT_ERR_READ_FAILED:      return "definition could not be read";
+    case YDICT_ERR_INTERNAL:         return "internal error";
+    default:                         return "unknown status";
+    }
+}
+
+int ydict_open(const char* idx_path, const char* dat_path, ydict_handle** out)
+{
+    if (!idx_path || !dat_path || !out)
+        return YDICT_ERR_INVALID_ARGUMENT;
+    *out = nullptr;
+
+    return guarded([&]() {
+        ydict::Config cfg;
+        cfg.idx_path = idx_path;
+        cfg.dat_path = dat_path;
+
+        ydict_handle* h = new ydict_handle;
+        if (!h->dict.init(cfg)) {
+            delete h;
+            return static_cast<int>(YDICT_ERR_INIT_FAILED);
+        }
+        *out = h;
+        return static_cast<int>(YDICT_OK);
+    });
+}
+
+int ydict_open_memory(const void* idx, size_t idx_size, const void* dat, size_t dat_size,
+                      unsigned flags, ydict_handle** out)
+{
+    if (!out || (!idx && idx_size > 0) || (!dat && dat_size > 0))
+        return YDICT_ERR_INVALID_ARGUMENT;
+    *out = nullptr;
+
+    return guarded([&]() {
+        const std::span<const std::byte> idxSpan(static_cast<const std::byte*>(idx), idx_size);
+        const std::span<const std::byte> datSpan(static_cast<const std::byte*>(dat), dat_size);
+
+        ydict_handle* h = new ydict_handle;
+        const bool ok = (flags & YDICT_MEMORY_BORROW)
+            ? h->dict.initFromMemory(idxSpan, datSpan)
+            : h->dict.initFromMemory(std::vector<std::byte>(idxSpan.begin(), idxSpan.end()),
+                                     std::vector<std::byte>(datSpan.begin(), datSpan.end()));
+        if (!ok) {
+            delete h;
+            return static_cast<int>(YDICT_ERR_INIT_FAILED);
+        }
+        *out = h;
+        return static_cast<int>(YDICT_OK);
+    });
+}
+
+void ydict_close(ydict_handle* h)
+{
+    delete h;
+}
+
+int32_t ydict_word_count(const ydict_handle* h)
+{
+    return h ? h->dict.wordCount() : -1;
+}
+
+int ydict_lookup(const ydict_handle* h, const char* word, int32_t* out_index)
+{
+    if (!h || !word || !out_index)
+        return YDICT_ERR_INVALID_ARGUMENT;
+
+    return guarded([&]() {
+        *out_index = h->dict.findWord(word);
+        return static_cast<int>(*out_index >= 0 ? YDICT_OK : YDICT_ERR_NOT_FOUND);
+    });
+}
+
+int ydict_word_at(const ydict_handle* h, int32_t index, char* buf, size_t buf_size, size_t* out_len)
+{
+    if (!h || (!buf && buf_size > 0))
+        return YDICT_ERR_INVALID_ARGUMENT;
+
+    const auto e = h->dict.wordAt(index);
+    if (!e)
+        return YDICT_ERR_NOT_FOUND;
+    return copy_out(e->word, buf, buf_size, out_len);
+}
+
+int ydict_suggest(const ydict_handle* h, const char* prefix, int32_t* out_indices, size_t max_results,
+                  size_t* out_count)
+{
+    if (!h || !prefix || !out_count || (!out_indices && max_results > 0))
+        return YDICT_ERR_INVALID_ARGUMENT;
+    *out_count = 0;
+
+    return guarded([&]() {
+        const std::vector<int> hits = h->dict.suggest(prefix, max_results);
+        for (const int i : hits) {
+            out_indices[(*out_count)++] = i;
+        }
+        return static_cast<int>(YDICT_OK);
+    });
+}
+
+int ydict_render(const ydict_handle* h, int32_t index, int format, char* buf, size_t buf_size, size_t* out_len)
+{
+    ydict::OutputFormat fmt;
+    if (!h || (!buf && buf_size > 0) || !to_format(format, fmt))
+        return YDICT_ERR_INVALID_ARGUMENT;
+    if (!h->dict.wordAt(index))
+        return YDICT_ERR_NOT_FOUND;
+
+    return guarded([&]() {
+        const std::string rtf = h->dict.readRtf(index);
+        if (rtf.empty())
+            return static_cast<int>(YDICT_ERR_READ_FAILED);
+
+        // Renders straight into the caller's buffer; the return value is the full size.
+        const size_t cap = buf_size > 0 ? buf_size - 1 : 0;
+        const size_t full = ydict::renderRtfTo(rtf, fmt, buf, cap);
+        if (out_len)
+            *out_len = full;
+        if (buf_size > 0)
+            buf[full < cap ? full : cap] = '\0';
+        return static_cast<int>(full <= cap ? YDICT_OK : YDICT_ERR_BUFFER_TOO_SMALL);
+    });
+}
+
+int ydict_render_alloc(const ydict_handle* h, int32_t index, int format, char** out, size_t* out_len)
+{
+    ydict::OutputFormat fmt;
+    if (!h || !out || !to_format(format, fmt))
+        return YDICT_ERR_INVALID_ARGUMENT;
+    *out = nullptr;
+    if (!h->dict.wordAt(index))
+        return YDICT_ERR_NOT_FOUND;
+
+    return guarded([&]() {
+        const std::string rtf = h->dict.readRtf(index);
+        if (rtf.empty())
+            return static_cast<int>(YDICT_ERR_READ_FAILED);
+
+        const std::string text = ydict::renderRtf(rtf, fmt);
+        // Plain malloc: ydict_free() releases it without any C++ runtime on the caller's side.
+        char* p = static_cast<char*>(std::malloc(text.size() + 1));
+        if (!p)
+            return static_cast<int>(YDICT_ERR_INTERNAL);
+        std::memcpy(p, text.data(), text.size());
+        p[text.size()] = '\0';
+        *out = p;
+        if (out_len)
+            *out_len = text.size();
+        return static_cast<int>(YDICT_OK);
+    });
+}
+
+void ydict_free(void* p)
+{
+    std::free(p);
+}
+
+} // extern "C"
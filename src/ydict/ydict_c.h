@@ -0,0 +1,123 @@
+#ifndef YDICT_C_H
+#define YDICT_C_H
+
+/*
+ * C ABI (ydict_shared)
+ * --------------------
+ * Stable plain-C interface to ydict::Dictionary for FFI callers (Python
+ * ctypes/cffi, Go cgo, Rust bindgen). Only C types cross the boundary: the
+ * dictionary is an opaque handle, strings are UTF-8 and NUL-terminated, and
+ * every call returns a ydict_status. No C++ exception escapes a call.
+ *
+ * Output buffers follow snprintf: the caller passes `buf`/`buf_size`, the
+ * call writes at most buf_size - 1 bytes plus a NUL and stores the full
+ * length (without the NUL) in *out_len. YDICT_ERR_BUFFER_TOO_SMALL means
+ * the text was cut (possibly inside a UTF-8 sequence); retry with
+ * *out_len + 1 bytes. buf may be NULL when buf_size is 0 (measure only).
+ *
+ *   ydict_handle* h = NULL;
+ *   if (ydict_open("dict100.idx", "dict100.dat", &h) == YDICT_OK) {
+ *       int32_t idx;
+ *       char text[4096];
+ *       size_t len;
+ *       if (ydict_lookup(h, "get", &idx) == YDICT_OK)
+ *           ydict_render(h, idx, YDICT_FORMAT_PLAIN, text, sizeof text, &len);
+ *       ydict_close(h);
+ *   }
+ *
+ * An open handle may be used from several threads at once; ydict_close()
+ * must not race with any other call on the same handle.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(YDICT_C_BUILD)
+#    define YDICT_C_API __declspec(dllexport)
+#  else
+#    define YDICT_C_API __declspec(dllimport)
+#  endif
+#else
+#  define YDICT_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped only on incompatible changes; new functions keep the version. */
+#define YDICT_C_ABI_VERSION 1
+
+typedef struct ydict_handle ydict_handle;
+
+typedef enum ydict_status {
+    YDICT_OK = 0,
+    YDICT_ERR_NOT_FOUND = 1,          /* word or index not in the dictionary */
+    YDICT_ERR_BUFFER_TOO_SMALL = 2,   /* output cut; see *out_len */
+    YDICT_ERR_INVALID_ARGUMENT = 3,   /* NULL handle/pointer, bad format */
+    YDICT_ERR_INIT_FAILED = 4,        /* files missing or not a valid dictionary */
+    YDICT_ERR_READ_FAILED = 5,        /* definition could not be read */
+    YDICT_ERR_INTERNAL = 6            /* out of memory or another internal failure */
+} ydict_status;
+
+/* Same values as ydict::OutputFormat. */
+typedef enum ydict_format {
+    YDICT_FORMAT_CLI = 0,
+    YDICT_FORMAT_PLAIN = 1,
+    YDICT_FORMAT_ANSI = 2,
+    YDICT_FORMAT_HTML = 3,
+    YDICT_FORMAT_JSON = 4
+} ydict_format;
+
+/* YDICT_C_ABI_VERSION of the loaded library. */
+YDICT_C_API uint32_t ydict_abi_version(void);
+
+/* Static English description of a status code. */
+YDICT_C_API const char* ydict_status_string(int status);
+
+/* Load a dictionary from its .idx/.dat files. On success *out receives a handle for ydict_close(). */
+YDICT_C_API int ydict_open(const char* idx_path, const char* dat_path, ydict_handle** out);
+
+/* ydict_open_memory() flags. */
+#define YDICT_MEMORY_BORROW 1u  /* use `dat` in place; it must outlive the handle (e.g. static data) */
+
+/*
+ * Load a dictionary from .idx/.dat images in memory, with the same validation
+ * as ydict_open(). By default the .dat image is copied, so the caller may free
+ * both buffers once this returns; the .idx is never needed after the call.
+ */
+YDICT_C_API int ydict_open_memory(const void* idx, size_t idx_size, const void* dat, size_t dat_size,
+                                  unsigned flags, ydict_handle** out);
+
+/* Release the handle (NULL is ignored). */
+YDICT_C_API void ydict_close(ydict_handle* h);
+
+/* Number of entries, or -1 for a NULL handle. */
+YDICT_C_API int32_t ydict_word_count(const ydict_handle* h);
+
+/* Exact lookup: *out_index receives the entry index. */
+YDICT_C_API int ydict_lookup(const ydict_handle* h, const char* word, int32_t* out_index);
+
+/* Headword of entry `index` into buf (snprintf rules). */
+YDICT_C_API int ydict_word_at(const ydict_handle* h, int32_t index, char* buf, size_t buf_size, size_t* out_len);
+
+/* Up to `max_results` entry indices starting with `prefix` into `out_indices`; *out_count receives how many. */
+YDICT_C_API int ydict_suggest(const ydict_handle* h, const char* prefix, int32_t* out_indices, size_t max_results,
+                              size_t* out_count);
+
+/* Definition of entry `index` rendered as `format` (a ydict_format) into buf (snprintf rules). */
+YDICT_C_API int ydict_render(const ydict_handle* h, int32_t index, int format, char* buf, size_t buf_size,
+                             size_t* out_len);
+
+/* Same, into a library-allocated NUL-terminated string; release it with ydict_free(). */
+YDICT_C_API int ydict_render_alloc(const ydict_handle* h, int32_t index, int format, char** out, size_t* out_len);
+
+/* Free memory returned by this library (NULL is ignored). */
+YDICT_C_API void ydict_free(void* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YDICT_C_H */
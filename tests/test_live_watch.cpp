@@ -0,0 +1,57 @@
+/*
+ * LiveDictionary::watch()
+ * -----------------------
+ * watch() reports whether inotify could watch the files' directories, and
+ * once it returns true a rewritten .idx/.dat pair is picked up.
+ */
+
+#include "test_support.h"
+
+#include "ydict/live_dictionary.h"
+
+#include <chrono>
+#include <thread>
+
+namespace {
+
+ydict::Config config_for(const std::filesystem::path& stem)
+{
+    ydict::Config cfg;
+    cfg.idx_path = stem.string() + ".idx";
+    cfg.dat_path = stem.string() + ".dat";
+    return cfg;
+}
+
+} // namespace
+
+int main()
+{
+    const std::filesystem::path dir = ydict_test::temp_dir("ydict_test_watch");
+    CHECK(ydict_test::write_dictionary(dir / "d", {{"alpha", "a"}, {"beta", "b"}}));
+
+    {
+        ydict::LiveDictionary missing(config_for(dir / "no-such-dir" / "d"));
+        CHECK(missing.snapshot() == nullptr);
+        CHECK(!missing.watch());
+    }
+
+    ydict::LiveDictionary live(config_for(dir / "d"));
+    CHECK(live.snapshot() != nullptr);
+    CHECK(live.generation() == 1);
+    CHECK(live.watch(std::chrono::milliseconds(50)));
+    CHECK(!live.watch());                                   // already watching
+
+    // The watch is in place once watch() returned: this write must not be missed.
+    CHECK(ydict_test::write_dictionary(dir / "d", {{"alpha", "a"}, {"beta", "b"}, {"gamma", "c"}}));
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (live.generation() < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(live.generation() == 2);
+    const auto snap = live.snapshot();
+    CHECK(snap && snap->wordCount() == 3);
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return ydict_test::test_result();
+}
@@ -0,0 +1,60 @@
+/*
+ * Dictionary::findWordExplain() on an out-of-order .idx
+ * -----------------------------------------------------
+ * "m" sits where byte order wants "b", so binary searches that probe it
+ * go wrong. A word found only by the fallback scan, and a miss whose
+ * search saw the disorder, both report order_conflict; lookups in a
+ * byte-ordered index do not.
+ */
+
+#include "test_support.h"
+
+#include "ydict/ydict.h"
+
+namespace {
+
+std::shared_ptr<const ydict::Dictionary> open_entries(const std::vector<std::string>& words)
+{
+    std::vector<ydict_test::TestEntry> entries;
+    for (const std::string& w : words) {
+        entries.push_back({w, "{\\cf1 " + w + "}"});
+    }
+    std::string idx;
+    std::string dat;
+    ydict_test::build_dictionary(entries, idx, dat);
+    return ydict::Dictionary::openFromMemory(ydict_test::to_bytes(idx), ydict_test::to_bytes(dat));
+}
+
+} // namespace
+
+int main()
+{
+    const auto unordered = open_entries({"a", "m", "c", "d", "e", "f", "g"});
+    CHECK(unordered != nullptr);
+    if (unordered) {
+        ydict::LookupExplain how;
+        CHECK(unordered->findWordExplain("c", how) == 2);
+        CHECK(how.path == ydict::LookupPath::Fallback);
+        CHECK(how.order_conflict);
+
+        CHECK(unordered->findWordExplain("b", how) == -1);
+        CHECK(how.path == ydict::LookupPath::Miss);
+        CHECK(how.order_conflict);
+
+        CHECK(unordered->findWordExplain("f", how) == 5);
+        CHECK(how.path == ydict::LookupPath::Fast);
+        CHECK(!how.order_conflict);
+    }
+
+    const auto ordered = open_entries({"a", "b", "c", "d", "e", "f", "g"});
+    CHECK(ordered != nullptr);
+    if (ordered) {
+        ydict::LookupExplain how;
+        for (const char* missing : {"0", "bb", "dd", "z"}) {
+            CHECK(ordered->findWordExplain(missing, how) == -1);
+            CHECK(how.path == ydict::LookupPath::Miss);
+            CHECK(!how.order_conflict);
+        }
+    }
+    return ydict_test::test_result();
+}
@@ -0,0 +1,213 @@
+/*
+ * --serve backpressure
+ * --------------------
+ * A client pipelines thousands of render requests and does not read the
+ * replies. The server must stop taking requests once its per-connection
+ * backlog (unsent output plus renders in flight) is full, so its memory
+ * stays flat; once the client reads, every request is answered.
+ */
+
+#include "test_support.h"
+
+#include "ydict/app_serve.h"
+#include "ydict/live_dictionary.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kWords = 64;
+constexpr std::size_t kDefinitionBytes = 8 * 1024;
+constexpr std::uint32_t kRequests = 100000;         // ~800 MB of output if nothing pushed back
+constexpr long kMaxGrowthKb = 48 * 1024;
+
+long rss_kb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0)
+            return std::strtol(line.c_str() + 6, nullptr, 10);
+    }
+    return 0;
+}
+
+std::string word(int i)
+{
+    return "w" + std::to_string(100 + i);
+}
+
+std::shared_ptr<const ydict::Dictionary> make_dictionary()
+{
+    std::vector<ydict_test::TestEntry> entries;
+    for (int i = 0; i < kWords; ++i) {
+        std::string rtf = "{\\cf1 " + word(i) + "}\\par\n";
+        while (rtf.size() < kDefinitionBytes) {
+            rtf += "\\pard the house is on a hill we take it over there\\par\n";
+        }
+        entries.push_back({word(i), std::move(rtf)});
+    }
+    std::string idx;
+    std::string dat;
+    ydict_test::build_dictionary(entries, idx, dat);
+    return ydict::Dictionary::openFromMemory(ydict_test::to_bytes(idx), ydict_test::to_bytes(dat));
+}
+
+void append_render(std::string& out, std::uint32_t id, std::string_view key)
+{
+    ydict_test::put_u32(out, static_cast<std::uint32_t>(8 + key.size()));
+    ydict_test::put_u32(out, id);
+    out.push_back(static_cast<char>(ServeOp::Render));
+    out.push_back(static_cast<char>(ydict::OutputFormat::Plain));
+    out.push_back('\0');
+    out.push_back('\0');
+    out += key;
+}
+
+int connect_to(const std::string& path)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+            return fd;
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+} // namespace
+
+int main()
+{
+    // The server takes its stop signal through a signalfd; block it here too so it is not fatal.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    const auto dict = make_dictionary();
+    CHECK(dict != nullptr);
+    if (!dict)
+        return ydict_test::test_result();
+
+    const std::filesystem::path dir = ydict_test::temp_dir("ydict_test_serve");
+    ydict::LiveDictionary live(ydict::Config{}, dict);
+    ServeOptions opt;
+    opt.socket_path = (dir / "s.sock").string();
+    opt.jobs = 2;
+    int serverResult = -1;
+    std::thread server([&] { serverResult = runServer(live, opt); });
+
+    const int fd = connect_to(opt.socket_path);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        ::kill(::getpid(), SIGTERM);
+        server.join();
+        return ydict_test::test_result();
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    std::string frames;
+    for (std::uint32_t id = 0; id < kRequests; ++id) {
+        append_render(frames, id, word(static_cast<int>(id % kWords)));
+    }
+
+    const long baseline = rss_kb();
+    long peak = baseline;
+
+    // Phase 1: send as much as the server takes, never read. It must stop taking.
+    std::size_t sent = 0;
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (sent < frames.size() && std::chrono::steady_clock::now() - lastProgress < std::chrono::milliseconds(1500)) {
+        const ssize_t w = ::send(fd, frames.data() + sent, frames.size() - sent, MSG_NOSIGNAL);
+        if (w > 0) {
+            sent += static_cast<std::size_t>(w);
+            lastProgress = std::chrono::steady_clock::now();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        peak = std::max(peak, rss_kb());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    peak = std::max(peak, rss_kb());
+    CHECK(sent < frames.size());            // the server pushed back
+    CHECK(peak - baseline < kMaxGrowthKb);  // and held its memory while doing so
+    std::cerr << "unread client: sent " << sent << " of " << frames.size() << " bytes, RSS +"
+              << (peak - baseline) / 1024 << " MiB\n";
+
+    // Phase 2: read every reply (sending the rest as room appears).
+    std::string in;
+    std::vector<bool> seen(kRequests, false);
+    std::uint32_t answered = 0;
+    std::uint32_t ok = 0;
+    bool failed = false;
+    while (answered < kRequests && !failed) {
+        pollfd p{fd, static_cast<short>(POLLIN | (sent < frames.size() ? POLLOUT : 0)), 0};
+        if (::poll(&p, 1, 10000) <= 0) {
+            failed = true;
+            break;
+        }
+        if ((p.revents & POLLOUT) && sent < frames.size()) {
+            const ssize_t w = ::send(fd, frames.data() + sent, frames.size() - sent, MSG_NOSIGNAL);
+            if (w > 0)
+                sent += static_cast<std::size_t>(w);
+        }
+        if (p.revents & (POLLIN | POLLHUP)) {
+            char buf[256 * 1024];
+            const ssize_t r = ::read(fd, buf, sizeof(buf));
+            if (r <= 0) {
+                failed = r == 0 || errno != EAGAIN;
+                continue;
+            }
+            in.append(buf, static_cast<std::size_t>(r));
+            std::size_t pos = 0;
+            while (in.size() - pos >= 9) {
+                const auto* b = reinterpret_cast<const unsigned char*>(in.data() + pos);
+                const std::uint32_t len = b[0] | (b[1] << 8) | (b[2] << 16) | (std::uint32_t(b[3]) << 24);
+                if (in.size() - pos < 4 + std::size_t(len))
+                    break;
+                const std::uint32_t id = b[4] | (b[5] << 8) | (b[6] << 16) | (std::uint32_t(b[7]) << 24);
+                if (id < kRequests && !seen[id]) {
+                    seen[id] = true;
+                    ++answered;
+                    ok += b[8] == 0 ? 1 : 0;
+                }
+                pos += 4 + std::size_t(len);
+            }
+            in.erase(0, pos);
+        }
+        peak = std::max(peak, rss_kb());
+    }
+    CHECK(!failed);
+    CHECK(answered == kRequests);
+    CHECK(ok == kRequests);
+    CHECK(peak - baseline < kMaxGrowthKb);
+
+    ::close(fd);
+    ::kill(::getpid(), SIGTERM);
+    server.join();
+    CHECK(serverResult == 0);
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return ydict_test::test_result();
+}
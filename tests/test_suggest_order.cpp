@@ -0,0 +1,73 @@
+/*
+ * DictionarySet::suggest() cut order
+ * ----------------------------------
+ * The .idx lists words in byte order, so capitalised entries come before
+ * every lowercase one. A source must pick its top N case-insensitively
+ * from all its matches, not from the first N in .idx order.
+ */
+
+#include "test_support.h"
+
+#include "ydict/dictionary_set.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> words_of(const ydict::DictionarySet& set, const std::vector<ydict::SourcedHit>& hits)
+{
+    std::vector<std::string> out;
+    for (const ydict::SourcedHit& h : hits) {
+        const auto e = set.dictionary(h.source)->wordAt(h.index);
+        out.emplace_back(e ? e->word : std::string_view());
+    }
+    return out;
+}
+
+ydict::DictionarySource source(const std::filesystem::path& stem, std::string name)
+{
+    ydict::DictionarySource s;
+    s.name = std::move(name);
+    s.config.idx_path = stem.string() + ".idx";
+    s.config.dat_path = stem.string() + ".dat";
+    return s;
+}
+
+} // namespace
+
+int main()
+{
+    const std::filesystem::path dir = ydict_test::temp_dir("ydict_test_suggest");
+
+    // Byte order: the capitalised words fill the first five slots.
+    const std::vector<ydict_test::TestEntry> first = {
+        {"Boplopit", "x"}, {"Brartheacoos", "x"}, {"Bresgetfallthear", "x"}, {"Brill", "x"}, {"Bzz", "x"},
+        {"bafleall", "x"}, {"baibickhi", "x"}, {"baick", "x"}, {"baickyosu", "x"}, {"baillsan", "x"},
+        {"bomb", "x"},
+    };
+    const std::vector<ydict_test::TestEntry> second = {
+        {"Baa", "x"}, {"Zulu", "x"}, {"apex", "x"}, {"bag", "x"},
+    };
+    CHECK(ydict_test::write_dictionary(dir / "first", first));
+    CHECK(ydict_test::write_dictionary(dir / "second", second));
+
+    {
+        ydict::DictionarySet set;
+        CHECK(set.init({source(dir / "first", "first")}, 1));
+        const std::vector<std::string> want = {"bafleall", "baibickhi", "baick", "baickyosu", "baillsan"};
+        CHECK(words_of(set, set.suggest("b", 5)) == want);
+        CHECK(words_of(set, set.suggest("B", 5)) == want);
+    }
+
+    {
+        ydict::DictionarySet set;
+        CHECK(set.init({source(dir / "first", "first"), source(dir / "second", "second")}, 2));
+        const std::vector<std::string> want = {"Baa", "bafleall", "bag", "baibickhi"};
+        CHECK(words_of(set, set.suggest("b", 4)) == want);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return ydict_test::test_result();
+}
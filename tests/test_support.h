@@ -0,0 +1,112 @@
+#pragma once
+
+/*
+ * Shared helpers for the ctest programs in tests/
+ * -----------------------------------------------
+ * Each test is a small executable: CHECK() records a failure and carries
+ * on, and main() returns test_result(). Dictionaries are built here from
+ * (word, RTF) pairs in the order given, so a test can write an .idx that
+ * is deliberately out of byte order.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ydict_test {
+
+inline int& failures()
+{
+    static int n = 0;
+    return n;
+}
+
+#define CHECK(cond)                                                                          \
+    do {                                                                                     \
+        if (!(cond)) {                                                                       \
+            ++ydict_test::failures();                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n";     \
+        }                                                                                    \
+    } while (0)
+
+inline int test_result()
+{
+    if (failures() > 0)
+        std::cerr << failures() << " check(s) failed\n";
+    return failures() == 0 ? 0 : 1;
+}
+
+struct TestEntry
+{
+    std::string word;
+    std::string rtf;
+};
+
+inline void put_u32(std::string& out, std::uint32_t v)
+{
+    for (int k = 0; k < 4; ++k) {
+        out.push_back(static_cast<char>((v >> (8 * k)) & 0xFF));
+    }
+}
+
+// .idx and .dat bytes for `entries`, in the given order (see index_image.cpp for the layout).
+inline void build_dictionary(const std::vector<TestEntry>& entries, std::string& idx, std::string& dat)
+{
+    idx.clear();
+    dat.clear();
+    put_u32(idx, 0x8d4e11d5);
+    put_u32(idx, 0);
+    idx.push_back(static_cast<char>(entries.size() & 0xFF));
+    idx.push_back(static_cast<char>((entries.size() >> 8) & 0xFF));
+    idx.append(6, '\0');
+    put_u32(idx, 20);
+
+    for (const TestEntry& e : entries) {
+        put_u32(idx, 0);
+        put_u32(idx, static_cast<std::uint32_t>(dat.size()));
+        idx += e.word;
+        idx.push_back('\0');
+
+        put_u32(dat, static_cast<std::uint32_t>(e.rtf.size()));
+        dat += e.rtf;
+    }
+}
+
+// Writes <stem>.idx and <stem>.dat; false on I/O failure.
+inline bool write_dictionary(const std::filesystem::path& stem, const std::vector<TestEntry>& entries)
+{
+    std::string idx;
+    std::string dat;
+    build_dictionary(entries, idx, dat);
+    std::ofstream idxOut(stem.string() + ".idx", std::ios::binary);
+    std::ofstream datOut(stem.string() + ".dat", std::ios::binary);
+    idxOut.write(idx.data(), static_cast<std::streamsize>(idx.size()));
+    datOut.write(dat.data(), static_cast<std::streamsize>(dat.size()));
+    return static_cast<bool>(idxOut) && static_cast<bool>(datOut);
+}
+
+inline std::vector<std::byte> to_bytes(std::string_view s)
+{
+    std::vector<std::byte> out(s.size());
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        out[i] = static_cast<std::byte>(s[i]);
+    }
+    return out;
+}
+
+// Fresh empty directory under the system temp dir.
+inline std::filesystem::path temp_dir(std::string_view name)
+{
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / std::string(name);
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
+
+} // namespace ydict_test